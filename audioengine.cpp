@@ -1,19 +1,29 @@
 #include "audioengine.h"
+#include "contenthash.h"
 #include <iostream>
 #include <cmath>
-
+#include <algorithm>
+#include <numeric>
 AudioEngine::AudioEngine()
-    : gateOpen(false)
-    , amplitude(0.0)
-    , currentPitch(261.63)
-    , noteDuration(1000.0)
-    , noteStartSample(0)
+    : liveCommands(64)
     , currentSample(0)
+    , renderBuffer(nullptr)
+    , liveVoices(nullptr)
+    , nextLiveVoicesGeneration(1)
     , segmentDurationMs(1000.0)  // 1 second segments by default
     , useRenderBuffer(false)
-    , renderPlaybackPosition(0)
+    , playbackStream(nullptr)
+    , useStream(false)
+    , renderAheadMs(300.0)
+    , transport(nullptr)
+    , nextTransportGeneration(1)
+    , transportPlayedSamples(0)
+    , transportPlayedGeneration(0)
     , renderPlaybackSegmentIndex(0)
     , renderCacheDirty(true)
+    , nextGraphVersion(1)
+    , voiceLimit(16)
+    , stealPolicy(VoiceAllocator::StealPolicy::Oldest)
     , sampleRate(48000)
     , initialized(false)
 {
@@ -25,6 +35,13 @@ AudioEngine::~AudioEngine()
 {
     shutdown();
     clearAllGraphs();
+
+    // The stream is closed, so nothing can still be reading the snapshots
+    stopStream();
+    reclaimer.publish(renderBuffer, static_cast<const std::vector<float>*>(nullptr));
+    reclaimer.publish(liveVoices, static_cast<LiveVoices*>(nullptr));
+    reclaimer.publish(transport, static_cast<const TransportSnapshot*>(nullptr));
+    reclaimer.collectAll();
 }
 
 bool AudioEngine::initialize(unsigned int sampleRate, unsigned int bufferFrames)
@@ -36,6 +53,8 @@ bool AudioEngine::initialize(unsigned int sampleRate, unsigned int bufferFrames)
 
     this->sampleRate = sampleRate;
     generator.setSampleRate(static_cast<double>(sampleRate));
+    liveGenerator = generator;  // Before the stream starts, the audio thread owns it from here
+    liveBus.setSampleRate(static_cast<double>(sampleRate));
 
     // Try to open the default audio device
     if (audioDevice.getDeviceCount() < 1) {
@@ -90,52 +109,62 @@ bool AudioEngine::isRunning() const
 
 void AudioEngine::playNote(const Note& note)
 {
-    // Store current pitch and note duration
-    currentPitch.store(note.getPitchHz());
-    noteDuration.store(note.getDuration());
-
-    // Record the start sample for timing
-    noteStartSample.store(currentSample.load());
-
-    // Check if note's track has a graph
-    int trackIndex = note.getTrackIndex();
-    bool hasValidGraph = hasGraph(trackIndex);
+    // The audio thread picks the voice and resets it; here we only send the note
+    LiveCommand command;
+    command.type = LiveCommand::Type::NoteOn;
+    command.trackIndex = note.getTrackIndex();
+    command.pitchHz = note.getPitchHz();
+    command.dynamics = note.getDynamics();
+    command.durationMs = note.getDuration();
+    sendLiveCommand(command);
 
-    if (hasValidGraph) {
-        // Reset graph for new note
-        std::lock_guard<std::mutex> lock(graphMutex);
-        if (trackGraphs.contains(trackIndex)) {
-            trackGraphs[trackIndex]->reset();
-        }
-    } else {
-        // Fallback to direct generator
-        generator.setFundamentalHz(note.getPitchHz());
-        generator.reset();
-    }
+    std::cout << "Playing note: " << note.getPitchHz() << " Hz, duration: "
+              << note.getDuration() << " ms (track " << command.trackIndex << ")"
+              << (hasGraph(command.trackIndex) ? " (using graph)" : " (direct)") << std::endl;
+}
 
-    // Open gate
-    gateOpen = true;
+void AudioEngine::updateLiveNote(double pitchHz, double dynamics)
+{
+    LiveCommand command;
+    command.type = LiveCommand::Type::Update;
+    command.pitchHz = pitchHz;
+    command.dynamics = dynamics;
+    sendLiveCommand(command);
+}
 
-    std::cout << "Playing note: " << note.getPitchHz() << " Hz, duration: "
-              << note.getDuration() << " ms (track " << trackIndex << ")"
-              << (hasValidGraph ? " (using graph)" : " (direct)") << std::endl;
+void AudioEngine::releaseNote()
+{
+    LiveCommand command;
+    command.type = LiveCommand::Type::NoteOff;
+    sendLiveCommand(command);
 }
 
 void AudioEngine::stopNote()
 {
-    gateOpen = false;
-    amplitude = 0.0;  // Immediate cutoff for stop button
+    LiveCommand command;
+    command.type = LiveCommand::Type::Stop;  // Immediate cutoff for stop button
+    sendLiveCommand(command);
+
     useRenderBuffer.store(false);  // Stop buffer playback
+    stopStream();
 }
 
-bool AudioEngine::buildGraph(Canvas *canvas, int trackIndex)
+void AudioEngine::sendLiveCommand(const LiveCommand &command)
 {
-    if (!canvas) {
-        clearGraph(trackIndex);
-        return false;
+    if (!liveCommands.push(command)) {
+        std::cerr << "AudioEngine: Live command queue full, command dropped" << std::endl;
     }
+}
+
+bool AudioEngine::buildGraph(const SounitDescription &description, int trackIndex)
+{
+    // Compile before taking the lock: the new graph is private until it's
+    // swapped in, so renders aren't held up and any thread can build
+    std::unique_ptr<SounitGraph> newGraph = std::make_unique<SounitGraph>(static_cast<double>(sampleRate));
+    newGraph->build(description);
+    bool isValid = newGraph->isValid();
 
-    // Lock mutex to prevent audio thread from accessing graph during rebuild
+    // Lock mutex to prevent a render from accessing the graph during the swap
     std::lock_guard<std::mutex> lock(graphMutex);
 
     // Delete old graph for this track if it exists
@@ -144,21 +173,17 @@ bool AudioEngine::buildGraph(Canvas *canvas, int trackIndex)
         trackGraphs.remove(trackIndex);
     }
 
-    // Create and build graph
-    SounitGraph *newGraph = new SounitGraph(static_cast<double>(sampleRate));
-    newGraph->buildFromCanvas(canvas);
-
-    // Check if valid
-    bool isValid = newGraph->isValid();
+    graphVersions.remove(trackIndex);
     if (isValid) {
-        trackGraphs[trackIndex] = newGraph;
+        trackGraphs[trackIndex] = newGraph.release();
+        graphVersions[trackIndex] = nextGraphVersion++;
         std::cout << "AudioEngine: Graph built successfully for track " << trackIndex
                   << " - using graph mode" << std::endl;
     } else {
         std::cout << "AudioEngine: Graph invalid for track " << trackIndex
                   << " - falling back to direct mode" << std::endl;
-        delete newGraph;
     }
+    publishLiveVoices();
 
     // Invalidate render cache - graph structure changed
     renderCacheDirty.store(true);
@@ -167,14 +192,36 @@ bool AudioEngine::buildGraph(Canvas *canvas, int trackIndex)
     return isValid;
 }
 
+bool AudioEngine::updateGraphParameters(const SounitDescription::Node &node, int trackIndex)
+{
+    // Lock mutex so the snapshot isn't swapped while a render reads it
+    std::lock_guard<std::mutex> lock(graphMutex);
+
+    if (!trackGraphs.contains(trackIndex) || !trackGraphs[trackIndex]) {
+        return false;
+    }
+
+    if (!trackGraphs[trackIndex]->updateParameters(node)) {
+        return false;
+    }
+    graphVersions[trackIndex] = nextGraphVersion++;
+    publishLiveVoices();
+
+    // Invalidate render cache - parameters changed
+    renderCacheDirty.store(true);
+    return true;
+}
+
 void AudioEngine::clearGraph(int trackIndex)
 {
-    // Lock mutex to prevent audio thread from accessing graph during clear
+    // Lock mutex to prevent a render from accessing the graph during clear
     std::lock_guard<std::mutex> lock(graphMutex);
 
     if (trackGraphs.contains(trackIndex)) {
         delete trackGraphs[trackIndex];
         trackGraphs.remove(trackIndex);
+        graphVersions.remove(trackIndex);
+        publishLiveVoices();
         renderCacheDirty.store(true);
         std::cout << "AudioEngine: Graph cleared for track " << trackIndex
                   << " - using direct mode" << std::endl;
@@ -183,19 +230,60 @@ void AudioEngine::clearGraph(int trackIndex)
 
 void AudioEngine::clearAllGraphs()
 {
-    // Lock mutex to prevent audio thread from accessing graphs during clear
+    // Lock mutex to prevent a render from accessing graphs during clear
     std::lock_guard<std::mutex> lock(graphMutex);
 
     for (SounitGraph *graph : trackGraphs) {
         delete graph;
     }
     trackGraphs.clear();
+    graphVersions.clear();
+    publishLiveVoices();
     renderCacheDirty.store(true);
     std::cout << "AudioEngine: All graphs cleared - using direct mode" << std::endl;
 }
 
+void AudioEngine::publishLiveVoices()
+{
+    // Voices are built here on the UI thread; the audio thread only ever
+    // sees a complete set through the pointer swap
+    LiveVoices *voices = new LiveVoices();
+    voices->generation = nextLiveVoicesGeneration++;
+    for (auto it = trackGraphs.constBegin(); it != trackGraphs.constEnd(); ++it) {
+        if (it.value() && it.value()->isValid()) {
+            voices->graphs[it.key()] = it.value()->createVoice();
+        }
+    }
+    for (auto it = trackMixes.constBegin(); it != trackMixes.constEnd(); ++it) {
+        voices->mixes[it.key()] = it.value();
+    }
+    reclaimer.publish(liveVoices, voices);
+}
+
+TrackMix AudioEngine::getTrackMix(int trackIndex) const
+{
+    std::lock_guard<std::mutex> lock(graphMutex);
+    return trackMixes.value(trackIndex, TrackMix());
+}
+
+void AudioEngine::setTrackMix(int trackIndex, const TrackMix &mix)
+{
+    std::lock_guard<std::mutex> lock(graphMutex);
+
+    if (trackMixes.value(trackIndex, TrackMix()) == mix) {
+        return;
+    }
+    trackMixes[trackIndex] = mix;
+    publishLiveVoices();
+
+    // Segments hold panned audio - the track's notes need mixing again
+    renderCacheDirty.store(true);
+}
+
 bool AudioEngine::hasGraph(int trackIndex) const
 {
+    std::lock_guard<std::mutex> lock(graphMutex);
+
     return trackGraphs.contains(trackIndex) && trackGraphs[trackIndex] != nullptr
            && trackGraphs[trackIndex]->isValid();
 }
@@ -207,89 +295,207 @@ int AudioEngine::audioCallback(void *outputBuffer, void *inputBuffer,
     AudioEngine *engine = static_cast<AudioEngine*>(userData);
     float *buffer = static_cast<float*>(outputBuffer);
 
-    // Check if we're in buffer playback mode
-    if (engine->useRenderBuffer.load()) {
-        // Lock render buffer mutex
-        std::lock_guard<std::mutex> lock(engine->renderBufferMutex);
+    // Snapshots loaded after this stay alive until exitReader()
+    engine->reclaimer.enterReader();
 
-        for (unsigned int i = 0; i < nFrames; i++) {
-            size_t pos = engine->renderPlaybackPosition.load();
-            float sample = 0.0f;
+    // Apply what the UI thread asked of the live voice since the last callback
+    LiveCommand command;
+    while (engine->liveCommands.pop(command)) {
+        engine->applyLiveCommand(command);
+    }
 
-            // Read from render buffer if position is valid
-            if (pos < engine->renderBuffer.size()) {
-                sample = engine->renderBuffer[pos];
-                engine->renderPlaybackPosition.fetch_add(1);
-            } else {
+    // Streaming playback: drain what the producer has rendered so far,
+    // straight into the device buffer (both are interleaved stereo)
+    if (engine->useStream.load()) {
+        RenderStream *stream = engine->playbackStream.load(std::memory_order_acquire);
+        size_t got = stream ? stream->read(buffer, nFrames) : 0;
+
+        // Loaded after the stream, so a new stream is never counted against the old playback
+        const TransportSnapshot *playing = engine->transport.load(std::memory_order_acquire);
+        engine->transportPlayedSamples.store(engine->playedSamples(playing) + got);
+
+        // Underrun or end of stream: fill with silence
+        std::fill(buffer + got * 2, buffer + nFrames * 2, 0.0f);
+
+        if (!stream || stream->isFinished()) {
+            engine->useStream.store(false);
+        }
+    } else if (engine->useRenderBuffer.load()) {
+        // Check if we're in buffer playback mode
+        const std::vector<float> *rendered = engine->renderBuffer.load(std::memory_order_acquire);
+        uint64_t renderedFrames = rendered ? rendered->size() / 2 : 0;
+        const TransportSnapshot *playing = engine->transport.load(std::memory_order_acquire);
+        const PlaybackTransport *clock = playing ? &playing->clock : nullptr;
+        bool loops = clock && clock->loops();
+        uint64_t played = engine->playedSamples(playing);
+        unsigned int done = 0;
+
+        // Copy runs of consecutive frames, up to the loop end or the buffer end
+        while (done < nFrames) {
+            uint64_t pos = clock ? clock->timelineSample(played) : played;
+            if (pos >= renderedFrames && !loops) {
                 // Reached end of buffer, stop playback
                 engine->useRenderBuffer.store(false);
+                break;
             }
 
-            // Output to both stereo channels
-            buffer[i * 2] = sample;      // Left channel
-            buffer[i * 2 + 1] = sample;  // Right channel
+            uint64_t run = nFrames - done;
+            if (loops) {
+                run = std::min<uint64_t>(run, clock->getLoopEnd() - pos);
+            }
+            if (pos < renderedFrames) {
+                run = std::min(run, renderedFrames - pos);
+                std::copy(rendered->data() + pos * 2, rendered->data() + (pos + run) * 2, buffer + done * 2);
+            } else {
+                // A loop may run past the end of the render, which is silence
+                std::fill(buffer + done * 2, buffer + (done + run) * 2, 0.0f);
+            }
+            done += static_cast<unsigned int>(run);
+            played += run;
         }
+        std::fill(buffer + done * 2, buffer + nFrames * 2, 0.0f);
+        engine->transportPlayedSamples.store(played);
     } else {
         // Live synthesis mode
-        // Simple envelope: fast attack, slow release
-        const double attackRate = 0.01;   // Rise quickly
-        const double releaseRate = 0.001; // Fall slowly
-
-        // Lock mutex ONCE per buffer, not per sample
-        std::lock_guard<std::mutex> lock(engine->graphMutex);
-
-        for (unsigned int i = 0; i < nFrames; i++)
-        {
-            // Calculate note progress (0.0 to 1.0 over note duration)
-            uint64_t currentSmp = engine->currentSample.load();
-            uint64_t startSmp = engine->noteStartSample.load();
-            double duration = engine->noteDuration.load();
-
-            // Convert duration from milliseconds to samples
-            double durationSamples = (duration / 1000.0) * engine->sampleRate;
-
-            // Calculate progress
-            double noteProgress = 0.5;  // Default fallback
-            if (durationSamples > 0.0) {
-                double elapsedSamples = static_cast<double>(currentSmp - startSmp);
-                noteProgress = elapsedSamples / durationSamples;
-                // Clamp to [0.0, 1.0]
-                noteProgress = std::clamp(noteProgress, 0.0, 1.0);
-            }
+        engine->renderLive(buffer, nFrames);
+    }
 
-            // Update amplitude envelope
-            if (engine->gateOpen.load()) {
-                double currentAmp = engine->amplitude.load();
-                currentAmp += (1.0 - currentAmp) * attackRate;
-                engine->amplitude.store(currentAmp);
-            } else {
-                double currentAmp = engine->amplitude.load();
-                currentAmp *= (1.0 - releaseRate);
-                if (currentAmp < 0.0001) currentAmp = 0.0;
-                engine->amplitude.store(currentAmp);
-            }
+    engine->reclaimer.exitReader();
+    return 0;
+}
 
-            // Generate sample
-            double sample;
-            // Note: For live synthesis, we would need to track which track is active
-            // For now, fallback to direct generator for live playback
-            // Pre-rendered playback (the main use case) is handled in renderNotes()
-            sample = engine->generator.generateSample();
+uint64_t AudioEngine::playedSamples(const TransportSnapshot *playing)
+{
+    uint64_t generation = playing ? playing->generation : 0;
+    if (generation != transportPlayedGeneration.load()) {
+        // Count before generation, so a reader that sees the new generation sees the rewind
+        transportPlayedSamples.store(0);
+        transportPlayedGeneration.store(generation);
+    }
+    return transportPlayedSamples.load();
+}
+
+void AudioEngine::applyLiveCommand(const LiveCommand &command)
+{
+    switch (command.type) {
+    case LiveCommand::Type::NoteOn:
+        live.trackIndex = command.trackIndex;
+        live.pitchHz = command.pitchHz;
+        live.dynamics = command.dynamics;
+        live.durationSamples = static_cast<uint64_t>(command.durationMs / 1000.0 * sampleRate);
+        live.elapsedSamples = 0;
+        live.gateOpen = true;
+
+        // Pick the voice again on the next block, which also resets it. A live
+        // note has no content hash; seeding from its pitch makes auditioning
+        // the same pitch twice sound the same
+        live.seed = SounitGraph::noteSeed(command.trackIndex, ContentHash::combine(uint64_t(0), command.pitchHz));
+        live.voiceStale = true;
+        liveGenerator.setFundamentalHz(command.pitchHz);
+        liveGenerator.reset(live.seed);
+        break;
+    case LiveCommand::Type::Update:
+        live.pitchHz = command.pitchHz;
+        live.dynamics = command.dynamics;
+        break;
+    case LiveCommand::Type::NoteOff:
+        live.gateOpen = false;
+        break;
+    case LiveCommand::Type::Stop:
+        live.gateOpen = false;
+        live.amplitude = 0.0;
+        break;
+    }
+}
 
-            // Apply envelope
-            sample *= engine->amplitude.load();
+void AudioEngine::renderLive(float *buffer, unsigned int nFrames)
+{
+    // Simple envelope: fast attack, slow release
+    const double attackRate = 0.01;   // Rise quickly
+    const double releaseRate = 0.001; // Fall slowly
+
+    // Silent and released: nothing to render
+    if (!live.gateOpen && live.amplitude <= 0.0) {
+        std::fill(buffer, buffer + nFrames * 2, 0.0f);
+        liveBus.startStream();  // The next note starts with an empty limiter
+        currentSample.fetch_add(nFrames);
+        return;
+    }
 
-            // Output to both stereo channels (clamp to prevent clipping)
-            float outputSample = static_cast<float>(std::clamp(sample * 0.3, -1.0, 1.0));
-            buffer[i * 2] = outputSample;      // Left channel
-            buffer[i * 2 + 1] = outputSample;  // Right channel
+    // Voices were republished (graph rebuilt, parameters or mix changed) or a
+    // new note started: take this track's voice from the current snapshot
+    const LiveVoices *voices = liveVoices.load(std::memory_order_acquire);
+    uint64_t generation = voices ? voices->generation : 0;
+    if (generation != live.voicesGeneration || live.voiceStale) {
+        live.voicesGeneration = generation;
+        live.voiceStale = false;
+        live.graph = nullptr;
+        if (voices) {
+            auto it = voices->graphs.find(live.trackIndex);
+            if (it != voices->graphs.end()) {
+                live.graph = it->second.get();
+                live.graph->reset(live.seed);
+            }
+        }
+    }
 
-            // Increment sample counter
-            engine->currentSample.fetch_add(1);
+    // Place the note on the track's bus
+    TrackMix mix;
+    if (voices) {
+        auto it = voices->mixes.find(live.trackIndex);
+        if (it != voices->mixes.end()) {
+            mix = it->second;
         }
     }
+    float gainLeft, gainRight;
+    mix.noteGains(live.pitchHz, gainLeft, gainRight);
 
-    return 0;
+    double blockPitch[SounitGraph::kMaxBlockFrames];
+    double blockProgress[SounitGraph::kMaxBlockFrames];
+    float blockSamples[SounitGraph::kMaxBlockFrames];
+
+    for (unsigned int done = 0; done < nFrames; done += SounitGraph::kMaxBlockFrames) {
+        int frames = static_cast<int>(std::min<unsigned int>(SounitGraph::kMaxBlockFrames, nFrames - done));
+
+        for (int j = 0; j < frames; j++) {
+            // Progress over the note duration drives the graph's envelopes
+            double progress = 0.5;  // Default fallback
+            if (live.durationSamples > 0) {
+                progress = std::clamp(static_cast<double>(live.elapsedSamples + j) / live.durationSamples, 0.0, 1.0);
+            }
+            blockPitch[j] = live.pitchHz;
+            blockProgress[j] = progress;
+        }
+
+        if (live.graph) {
+            live.graph->processBlock(blockSamples, frames, blockPitch, blockProgress);
+        } else {
+            liveGenerator.setFundamentalHz(live.pitchHz);
+            for (int j = 0; j < frames; j++) {
+                blockSamples[j] = static_cast<float>(liveGenerator.generateSample());
+            }
+        }
+
+        // Apply envelope and dynamics
+        for (int j = 0; j < frames; j++) {
+            if (live.gateOpen) {
+                live.amplitude += (1.0 - live.amplitude) * attackRate;
+            } else {
+                live.amplitude *= (1.0 - releaseRate);
+                if (live.amplitude < 0.0001) live.amplitude = 0.0;
+            }
+            blockSamples[j] = static_cast<float>(blockSamples[j] * live.amplitude * live.dynamics);
+        }
+
+        // Pan into the output and apply the master gain to both channels
+        float *out = buffer + done * 2;
+        std::fill(out, out + frames * 2, 0.0f);
+        MixBus::panInto(out, blockSamples, frames, gainLeft, gainRight);
+        liveBus.limitBlock(out, frames);
+
+        live.elapsedSamples += frames;
+        currentSample.fetch_add(frames);
+    }
 }
 
 void AudioEngine::renderNotes(const QVector<Note>& notes, int maxNotes)
@@ -302,36 +508,12 @@ void AudioEngine::renderNotes(const QVector<Note>& notes, int maxNotes)
     // Limit to maxNotes (-1 means render all notes)
     int notesToRender = (maxNotes < 0) ? notes.size() : qMin(notes.size(), maxNotes);
 
-    // Check if we can reuse cached render
-    bool notesChanged = (cachedNotes.size() != notesToRender);
-    if (!notesChanged) {
-        for (int i = 0; i < notesToRender; i++) {
-            // Check basic properties
-            if (cachedNotes[i].getPitchHz() != notes[i].getPitchHz() ||
-                cachedNotes[i].getDuration() != notes[i].getDuration() ||
-                cachedNotes[i].getStartTime() != notes[i].getStartTime() ||
-                cachedNotes[i].getDynamics() != notes[i].getDynamics()) {
-                notesChanged = true;
-                break;
-            }
+    // Check if we can reuse cached render: the note hashes cover every
+    // curve point, and graph edits set renderCacheDirty
+    std::vector<uint64_t> noteHashes = hashNotes(notes, notesToRender);
+    bool notesChanged = (noteHashes != cachedNoteHashes);
 
-            // Check if pitch curves differ (for continuous notes)
-            if (cachedNotes[i].getPitchCurve().getPoints().size() != notes[i].getPitchCurve().getPoints().size()) {
-                notesChanged = true;
-                break;
-            }
-
-            // Check if dynamics curves differ (for continuous notes)
-            if (cachedNotes[i].getDynamicsCurve().getPoints().size() != notes[i].getDynamicsCurve().getPoints().size()) {
-                notesChanged = true;
-                break;
-            }
-
-            // TODO: Could add deeper curve comparison (point values) if needed
-        }
-    }
-
-    if (!renderCacheDirty.load() && !notesChanged && !renderBuffer.empty()) {
+    if (!renderCacheDirty.load() && !notesChanged && renderBuffer.load()) {
         std::cout << "AudioEngine: Using cached render (no changes detected)" << std::endl;
         return;
     }
@@ -347,10 +529,13 @@ void AudioEngine::renderNotes(const QVector<Note>& notes, int maxNotes)
     // Show which synthesis mode we're using
     std::cout << " [Loaded graphs for tracks:";
     bool hasAnyGraph = false;
-    for (auto it = trackGraphs.constBegin(); it != trackGraphs.constEnd(); ++it) {
-        if (it.value() && it.value()->isValid()) {
-            std::cout << " " << it.key();
-            hasAnyGraph = true;
+    {
+        std::lock_guard<std::mutex> graphLock(graphMutex);
+        for (auto it = trackGraphs.constBegin(); it != trackGraphs.constEnd(); ++it) {
+            if (it.value() && it.value()->isValid()) {
+                std::cout << " " << it.key();
+                hasAnyGraph = true;
+            }
         }
     }
     if (!hasAnyGraph) {
@@ -358,47 +543,32 @@ void AudioEngine::renderNotes(const QVector<Note>& notes, int maxNotes)
     }
     std::cout << "]" << std::endl;
 
-    // Find the total duration (last note's end time)
-    double totalDurationMs = 0.0;
-    for (int i = 0; i < notesToRender; i++) {
-        double noteEndTime = notes[i].getStartTime() + notes[i].getDuration();
-        if (noteEndTime > totalDurationMs) {
-            totalDurationMs = noteEndTime;
-        }
+    // Create a voice of every track graph for the render workers while holding the graph lock,
+    // then render without it so the audio and UI threads aren't blocked
+    OfflineRenderer renderer(static_cast<double>(sampleRate));
+    renderer.setVoiceLimit(voiceLimit);
+    renderer.setStealPolicy(stealPolicy);
+    QMap<int, uint64_t> renderGraphVersions;
+    {
+        std::lock_guard<std::mutex> graphLock(graphMutex);
+        renderer.prepare(trackGraphs, generator);
+        renderer.setTrackMixes(trackMixes);
+        renderGraphVersions = graphVersions;
+
+        // Edits from here on dirty the cache again
+        renderCacheDirty.store(false);
     }
 
-    // Calculate total samples needed
-    double totalDurationSeconds = totalDurationMs / 1000.0;
-    size_t totalSamples = static_cast<size_t>(totalDurationSeconds * sampleRate);
-
-    std::cout << "AudioEngine: Total duration: " << totalDurationMs << " ms ("
-              << totalSamples << " samples)" << std::endl;
+    // Calculate total samples needed (end of the last note)
+    size_t totalSamples = renderer.totalSamples(notes, notesToRender);
 
-    // Lock both mutexes during rendering
-    std::lock_guard<std::mutex> graphLock(graphMutex);
-    std::lock_guard<std::mutex> renderLock(renderBufferMutex);
+    std::cout << "AudioEngine: Total duration: " << (totalSamples * 1000.0 / sampleRate) << " ms ("
+              << totalSamples << " frames)" << std::endl;
 
-    // Allocate render buffer
-    renderBuffer.clear();
-    renderBuffer.resize(totalSamples, 0.0f);  // Initialize with silence
-
-    // Envelope parameters
-    const double attackRate = 0.01;
-    const double releaseRate = 0.001;
-
-    // Render each note
+    // Log each note
     for (int noteIdx = 0; noteIdx < notesToRender; noteIdx++) {
         const Note& note = notes[noteIdx];
-
-        // Calculate sample positions for this note
-        size_t noteStartSample = static_cast<size_t>((note.getStartTime() / 1000.0) * sampleRate);
-        size_t noteDurationSamples = static_cast<size_t>((note.getDuration() / 1000.0) * sampleRate);
-
-        // Get note's track and check if it has a graph
         int noteTrackIndex = note.getTrackIndex();
-        bool noteHasGraph = trackGraphs.contains(noteTrackIndex)
-                            && trackGraphs[noteTrackIndex]
-                            && trackGraphs[noteTrackIndex]->isValid();
 
         std::cout << "  Note " << (noteIdx + 1) << ": track=" << noteTrackIndex
                   << ", " << note.getPitchHz() << " Hz, "
@@ -417,97 +587,302 @@ void AudioEngine::renderNotes(const QVector<Note>& notes, int maxNotes)
         } else {
             std::cout << " [WARNING: " << dynPoints << " dynamics points!]";
         }
-        std::cout << (noteHasGraph ? " [GRAPH]" : " [FALLBACK]") << std::endl;
+        std::cout << (renderer.hasGraph(noteTrackIndex) ? " [GRAPH]" : " [FALLBACK]") << std::endl;
+    }
 
-        // Reset synthesis for this note
-        if (noteHasGraph) {
-            trackGraphs[noteTrackIndex]->reset();
-        } else {
-            // For fallback generator, set initial pitch (will be updated per-sample for continuous notes)
-            generator.setFundamentalHz(note.getPitchHz());
-            generator.reset();
-        }
+    // Render only the segments whose notes changed, then mix
+    auto rendered = std::make_unique<std::vector<float>>();
+    renderDirtySegments(renderer, notes, notesToRender, totalSamples, renderGraphVersions, *rendered);
+    size_t renderedFrames = rendered->size() / 2;
 
-        double amplitude = 0.0;
+    // Swap the finished render in; the old one is freed once playback lets go of it
+    reclaimer.publish(renderBuffer, static_cast<const std::vector<float>*>(rendered.release()));
 
-        // Render this note's samples
-        for (size_t i = 0; i < noteDurationSamples; i++) {
-            size_t bufferPos = noteStartSample + i;
-            if (bufferPos >= totalSamples) break;  // Safety check
+    // Remember what was rendered
+    cachedNoteHashes.swap(noteHashes);
 
-            // Calculate note progress (0.0 to 1.0)
-            // Use noteDurationSamples - 1 as denominator to ensure we reach 1.0 at the last sample
-            double noteProgress;
-            if (noteDurationSamples > 1) {
-                noteProgress = static_cast<double>(i) / static_cast<double>(noteDurationSamples - 1);
-            } else {
-                noteProgress = 0.0;  // Single sample note
-            }
+    std::cout << "AudioEngine: Rendered " << renderedFrames << " frames (cached)" << std::endl;
+}
 
-            // Sample pitch curve at current time (supports continuous pitch variation)
-            double currentPitch = note.getPitchAt(noteProgress);
-
-            // Sample dynamics curve at current time (supports continuous dynamics variation)
-            double currentDynamics = note.getDynamicsAt(noteProgress);
-
-            // Update amplitude envelope (ADSR)
-            // Attack: first 5% of note
-            // Sustain: middle 85% of note
-            // Release: last 10% of note
-            if (noteProgress < 0.05) {
-                // Attack phase - ramp up quickly
-                amplitude += (1.0 - amplitude) * attackRate;
-            } else if (noteProgress < 0.90) {
-                // Sustain phase - maintain full amplitude
-                amplitude = 1.0;
-            } else {
-                // Release phase - fade out in last 10%
-                amplitude *= (1.0 - releaseRate);
-                if (amplitude < 0.0001) amplitude = 0.0;
-            }
+std::vector<uint64_t> AudioEngine::hashNotes(const QVector<Note> &notes, int count)
+{
+    std::vector<uint64_t> hashes(count);
+    for (int i = 0; i < count; i++) {
+        hashes[i] = notes[i].contentHash();
+    }
+    return hashes;
+}
 
-            // Generate sample using note's track graph
-            double sample;
-            if (noteHasGraph) {
-                // Use continuous pitch for graph-based synthesis
-                sample = trackGraphs[noteTrackIndex]->generateSample(currentPitch, noteProgress);
-            } else {
-                // Update fallback generator pitch for continuous notes
-                generator.setFundamentalHz(currentPitch);
-                sample = generator.generateSample();
-            }
+void AudioEngine::renderDirtySegments(OfflineRenderer &renderer, const QVector<Note> &notes, int count,
+                                      size_t totalSamples, const QMap<int, uint64_t> &versions,
+                                      std::vector<float> &output)
+{
+    std::vector<OfflineRenderer::NotePlacement> placements = renderer.placeNotes(notes, count, totalSamples);
+
+    // Key of each note's rendered audio: its content, its track's graph,
+    // where and how long it sounds after voice allocation and where it's panned
+    std::vector<uint64_t> noteKeys(count);
+    std::vector<float> gainsLeft(count), gainsRight(count);
+    for (int i = 0; i < count; i++) {
+        const OfflineRenderer::NotePlacement &placement = placements[i];
+        renderer.noteGains(notes[i], gainsLeft[i], gainsRight[i]);
+        uint64_t key = ContentHash::combine(notes[i].contentHash(), versions.value(notes[i].getTrackIndex(), 0));
+        key = ContentHash::combine(key, static_cast<uint64_t>(placement.startSample));
+        key = ContentHash::combine(key, static_cast<uint64_t>(placement.renderLength));
+        key = ContentHash::combine(key, static_cast<uint64_t>(placement.fadeOut));
+        key = ContentHash::combine(key, static_cast<double>(gainsLeft[i]));
+        key = ContentHash::combine(key, static_cast<double>(gainsRight[i]));
+        noteKeys[i] = key;
+    }
+
+    // Divide the timeline into fixed segments and find the notes overlapping
+    // each one, including tails that spill over from earlier segments
+    size_t segmentSamples = std::max<size_t>(1, static_cast<size_t>(segmentDurationMs / 1000.0 * sampleRate));
+    size_t segmentCount = (totalSamples + segmentSamples - 1) / segmentSamples;
+    renderSegments.resize(segmentCount);
+
+    // Notes are listed (and later summed) in start order, the order a
+    // RenderStream adds them, so streamed and cached playback match exactly
+    std::vector<int> byStart(count);
+    std::iota(byStart.begin(), byStart.end(), 0);
+    std::stable_sort(byStart.begin(), byStart.end(), [&](int a, int b) {
+        return placements[a].startSample < placements[b].startSample;
+    });
+
+    std::vector<std::vector<int>> segmentNotes(segmentCount);
+    for (int i : byStart) {
+        const OfflineRenderer::NotePlacement &placement = placements[i];
+        if (placement.renderLength == 0) {
+            continue;
+        }
+        size_t first = placement.startSample / segmentSamples;
+        size_t last = (placement.startSample + placement.renderLength - 1) / segmentSamples;
+        for (size_t seg = first; seg <= last && seg < segmentCount; seg++) {
+            segmentNotes[seg].push_back(i);
+        }
+    }
+
+    // A segment is dirty when its bounds or any overlapping note's key changed
+    std::vector<size_t> dirtySegments;
+    std::vector<bool> noteNeeded(count, false);
+    for (size_t seg = 0; seg < segmentCount; seg++) {
+        RenderSegment &segment = renderSegments[seg];
+        size_t segmentStart = seg * segmentSamples;
+        size_t segmentEnd = std::min(totalSamples, segmentStart + segmentSamples);
+
+        uint64_t hash = ContentHash::combine(static_cast<uint64_t>(segmentStart), static_cast<uint64_t>(segmentEnd));
+        for (int noteIdx : segmentNotes[seg]) {
+            hash = ContentHash::combine(hash, noteKeys[noteIdx]);
+        }
+
+        segment.startTimeMs = segmentStart * 1000.0 / sampleRate;
+        segment.endTimeMs = segmentEnd * 1000.0 / sampleRate;
+        segment.isDirty = (segment.hash != hash) || (segment.samples.size() != (segmentEnd - segmentStart) * 2);
+        segment.hash = hash;
+        if (!segment.isDirty) {
+            continue;
+        }
+
+        segment.noteIds.clear();
+        for (int noteIdx : segmentNotes[seg]) {
+            segment.noteIds.insert(notes[noteIdx].getId());
+            noteNeeded[noteIdx] = true;
+        }
+        dirtySegments.push_back(seg);
+    }
 
-            // Apply envelope, dynamics curve, and clamp
-            sample *= amplitude * currentDynamics;
-            float outputSample = static_cast<float>(std::clamp(sample * 0.3, -1.0, 1.0));
+    // Notes render whole (their state runs from the note start), so a note
+    // overlapping any dirty segment renders once and feeds each of them
+    std::vector<int> neededNotes;
+    for (int i = 0; i < count; i++) {
+        if (noteNeeded[i]) {
+            neededNotes.push_back(i);
+        }
+    }
 
-            // Mix into buffer (for now just overwrite, but could add overlapping notes later)
-            renderBuffer[bufferPos] = outputSample;
+    std::cout << "AudioEngine: " << dirtySegments.size() << " of " << segmentCount
+              << " segment(s) dirty, rendering " << neededNotes.size() << " note(s)" << std::endl;
+
+    std::vector<std::vector<float>> noteBuffers;
+    renderer.renderNotes(notes, placements, neededNotes, noteBuffers);
+
+    // Pan each dirty segment's notes in, in start order (before the mix bus gain)
+    for (size_t seg : dirtySegments) {
+        RenderSegment &segment = renderSegments[seg];
+        size_t segmentStart = seg * segmentSamples;
+        size_t segmentEnd = std::min(totalSamples, segmentStart + segmentSamples);
+        segment.samples.assign((segmentEnd - segmentStart) * 2, 0.0f);
+
+        for (int noteIdx : segmentNotes[seg]) {
+            const std::vector<float> &buffer = noteBuffers[noteIdx];
+            size_t noteStart = placements[noteIdx].startSample;
+            size_t from = std::max(segmentStart, noteStart);
+            size_t to = std::min(segmentEnd, noteStart + buffer.size());
+            if (from < to) {
+                MixBus::panInto(segment.samples.data() + (from - segmentStart) * 2, buffer.data() + (from - noteStart),
+                                to - from, gainsLeft[noteIdx], gainsRight[noteIdx]);
+            }
         }
+        segment.isDirty = false;
     }
 
-    // Cache the rendered notes and mark cache as clean
-    cachedNotes.clear();
-    for (int i = 0; i < notesToRender; i++) {
-        cachedNotes.append(notes[i]);
+    // Join the segments and apply the master gain and headroom to the whole mix
+    MixBus &mixBus = renderer.getMixBus();
+    mixBus.reset(totalSamples);
+    for (size_t seg = 0; seg < segmentCount; seg++) {
+        const RenderSegment &segment = renderSegments[seg];
+        mixBus.addStereo(segment.samples.data(), seg * segmentSamples, segment.samples.size() / 2);
     }
-    renderCacheDirty.store(false);
+    mixBus.finish(output);
+}
 
-    std::cout << "AudioEngine: Rendered " << renderBuffer.size() << " samples (cached)" << std::endl;
+void AudioEngine::setVoiceLimit(int voices)
+{
+    voices = std::max(voices, 1);
+    if (voices != voiceLimit) {
+        voiceLimit = voices;
+        renderCacheDirty.store(true);
+    }
 }
 
-void AudioEngine::playRenderedBuffer()
+void AudioEngine::setStealPolicy(VoiceAllocator::StealPolicy policy)
 {
-    if (renderBuffer.empty()) {
+    if (policy != stealPolicy) {
+        stealPolicy = policy;
+        renderCacheDirty.store(true);
+    }
+}
+
+void AudioEngine::playRenderedBuffer(const PlaybackRange &range)
+{
+    // Only the UI thread publishes, so the buffer can't be freed under us here
+    const std::vector<float> *rendered = renderBuffer.load();
+    if (!rendered || rendered->empty()) {
         std::cout << "AudioEngine: No rendered buffer to play" << std::endl;
         return;
     }
 
     // Reset playback position and enable buffer playback mode
-    renderPlaybackPosition.store(0);
+    stopStream();
+    useRenderBuffer.store(false);
+    startTransport(range);
     useRenderBuffer.store(true);
 
-    std::cout << "AudioEngine: Playing rendered buffer (" << renderBuffer.size()
-              << " samples, " << (renderBuffer.size() / static_cast<double>(sampleRate))
+    std::cout << "AudioEngine: Playing rendered buffer (" << rendered->size() / 2
+              << " frames, " << (rendered->size() / 2 / static_cast<double>(sampleRate))
               << " seconds)" << std::endl;
 }
+
+void AudioEngine::streamNotes(const QVector<Note>& notes, int maxNotes, const PlaybackRange &range)
+{
+    if (notes.isEmpty()) {
+        std::cout << "AudioEngine: No notes to stream" << std::endl;
+        return;
+    }
+
+    int notesToPlay = (maxNotes < 0) ? notes.size() : qMin(notes.size(), maxNotes);
+
+    // Nothing changed since the last render: it's ready to play right now
+    if (!renderCacheDirty.load() && renderBuffer.load() && hashNotes(notes, notesToPlay) == cachedNoteHashes) {
+        std::cout << "AudioEngine: Render cache is current, playing it instead of streaming" << std::endl;
+        playRenderedBuffer(range);
+        return;
+    }
+
+    stopStream();
+    useRenderBuffer.store(false);
+
+    // Give the producer its own voices of the graphs, like renderNotes()
+    auto renderer = std::make_unique<OfflineRenderer>(static_cast<double>(sampleRate));
+    renderer->setVoiceLimit(voiceLimit);
+    renderer->setStealPolicy(stealPolicy);
+    {
+        std::lock_guard<std::mutex> graphLock(graphMutex);
+        renderer->prepare(trackGraphs, generator);
+        renderer->setTrackMixes(trackMixes);
+    }
+
+    // Blocks until the first block is rendered, then keeps rendering ahead
+    startTransport(range);
+    auto stream = std::make_unique<RenderStream>(std::move(renderer), notes, notesToPlay,
+                                                 static_cast<double>(sampleRate), renderAheadMs,
+                                                 transport.load()->clock);
+    stream->start();
+    size_t streamSamples = stream->getTotalSamples();
+
+    reclaimer.publish(playbackStream, stream.release());
+    useStream.store(true);
+
+    std::cout << "AudioEngine: Streaming " << notesToPlay << " note(s) ("
+              << (streamSamples / static_cast<double>(sampleRate)) << " seconds, "
+              << renderAheadMs << " ms ahead)" << std::endl;
+}
+
+bool AudioEngine::bounceNotes(const QVector<Note>& notes, const QString &path, WavWriter::Format format,
+                              const OfflineBounce::ProgressCallback &progress, QString *errorString)
+{
+    // Own voices of the graphs, like streamNotes(); playback can go on meanwhile
+    auto renderer = std::make_unique<OfflineRenderer>(static_cast<double>(sampleRate));
+    renderer->setVoiceLimit(voiceLimit);
+    renderer->setStealPolicy(stealPolicy);
+    {
+        std::lock_guard<std::mutex> graphLock(graphMutex);
+        renderer->prepare(trackGraphs, generator);
+        renderer->setTrackMixes(trackMixes);
+    }
+
+    std::cout << "AudioEngine: Bouncing " << notes.size() << " note(s) to " << path.toStdString() << std::endl;
+
+    OfflineBounce bounce(std::move(renderer), static_cast<double>(sampleRate));
+    bounce.setFormat(format);
+    bounce.setProgressCallback(progress);
+    bool ok = bounce.run(notes, notes.size(), path);
+    if (!ok) {
+        std::cerr << "AudioEngine: Bounce failed: " << bounce.getErrorString().toStdString() << std::endl;
+    }
+    if (errorString) {
+        *errorString = bounce.getErrorString();
+    }
+    return ok;
+}
+
+void AudioEngine::stopStream()
+{
+    useStream.store(false);
+
+    // Only the UI thread publishes, so the stream can't be freed under us here
+    RenderStream *stream = playbackStream.load();
+    if (stream) {
+        stream->stop();
+        reclaimer.publish(playbackStream, static_cast<RenderStream*>(nullptr));
+    }
+}
+
+void AudioEngine::startTransport(const PlaybackRange &range)
+{
+    auto toSamples = [this](double ms) {
+        return static_cast<uint64_t>(std::max(0.0, ms) / 1000.0 * sampleRate);
+    };
+
+    TransportSnapshot *snapshot = new TransportSnapshot();
+    snapshot->clock = PlaybackTransport(toSamples(range.startMs), toSamples(range.loopStartMs), toSamples(range.loopEndMs));
+    snapshot->generation = nextTransportGeneration++;
+    reclaimer.publish(transport, static_cast<const TransportSnapshot*>(snapshot));
+}
+
+double AudioEngine::getTransportTimeMs() const
+{
+    // Only the UI thread publishes, so the transport can't be freed under us here
+    const TransportSnapshot *playing = transport.load();
+    if (!playing) {
+        return transportPlayedSamples.load() * 1000.0 / sampleRate;
+    }
+
+    // The callback hasn't reached this playback yet: it is at its start
+    uint64_t played = 0;
+    if (transportPlayedGeneration.load() == playing->generation) {
+        played = transportPlayedSamples.load();
+    }
+    uint64_t position = playing->clock.timelineSample(played);
+    return position * 1000.0 / sampleRate;
+}
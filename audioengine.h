@@ -3,8 +3,16 @@
 
 #include "harmonicgenerator.h"
 #include "sounitgraph.h"
+#include "sounitdescription.h"
+#include "offlinerenderer.h"
+#include "offlinebounce.h"
+#include "realtimereclaimer.h"
+#include "renderstream.h"
+#include "playbacktransport.h"
+#include "spscqueue.h"
 #include "note.h"
 #include <RtAudio.h>
+#include <map>
 #include <memory>
 #include <atomic>
 #include <mutex>
@@ -19,14 +27,18 @@
  *
  * Enables partial re-rendering: only segments with changed notes need re-rendering.
  * Segments divide the timeline into fixed chunks (e.g., 1 second each).
+ * samples hold the unclipped stereo sum (interleaved) of every note
+ * overlapping the segment, before the mix bus gain; hash covers the
+ * segment bounds and, per overlapping note, its content, its track's graph
+ * version, its voice allocation and its pan gains.
  */
 struct RenderSegment {
     double startTimeMs;           // Segment start time in milliseconds
     double endTimeMs;             // Segment end time in milliseconds
-    std::vector<float> samples;   // Pre-rendered audio samples for this segment
+    std::vector<float> samples;   // Pre-rendered audio for this segment (interleaved stereo)
     QSet<QString> noteIds;        // IDs of notes affecting this segment
     bool isDirty;                 // True if segment needs re-rendering
-    uint64_t hash;                // Hash of note states for quick comparison (future use)
+    uint64_t hash;                // Hash of the overlapping notes and graphs (see above)
 
     RenderSegment()
         : startTimeMs(0.0)
@@ -44,6 +56,19 @@ struct RenderSegment {
  *
  * Each track (identified by trackIndex) can have its own SounitGraph.
  * During rendering, notes use the graph associated with their trackIndex.
+ *
+ * The audio callback never takes a lock. The rendered buffer and a set of
+ * live voices of the track graphs are immutable snapshots published by
+ * atomic pointer swap; replaced snapshots are freed on the UI thread by
+ * the RealtimeReclaimer once the callback can no longer see them.
+ *
+ * Everything is mixed in stereo: each track has a TrackMix (pan and
+ * width) that places its notes on the master bus, for rendered, streamed
+ * and live playback alike.
+ *
+ * Live playback (playNote) renders the note's track graph in the callback
+ * itself. The UI thread only sends LiveCommands through a lock-free
+ * queue; the voice, its envelope and timing belong to the audio thread.
  */
 class AudioEngine
 {
@@ -56,16 +81,51 @@ public:
     void shutdown();
     bool isRunning() const;
 
-    // Note playback (simple gate on/off for now)
+    // Live note playback on the note's track graph (for auditioning while drawing)
     void playNote(const Note& note);
-    void stopNote();
+    void updateLiveNote(double pitchHz, double dynamics);  // Glide the playing note
+    void releaseNote();  // Close the gate and let the note fade out
+    void stopNote();     // Silence everything now (live note, buffer and stream)
 
     // Pre-rendering (render notes to buffer, then play from buffer)
     void renderNotes(const QVector<Note>& notes, int maxNotes = -1);  // -1 = all notes
-    void playRenderedBuffer();
+    void playRenderedBuffer(const PlaybackRange &range = PlaybackRange());
+
+    // Streaming playback: render the notes a little ahead of the playhead on a
+    // background thread and start playing as soon as the first block is ready.
+    // Plays the cached render instead if it's already up to date for these notes
+    void streamNotes(const QVector<Note>& notes, int maxNotes = -1,
+                     const PlaybackRange &range = PlaybackRange());
+    void setRenderAheadMs(double ms) { renderAheadMs = ms; }
+    double getRenderAheadMs() const { return renderAheadMs; }
+
+    // Export: render the notes straight to a WAV file, faster than real time and
+    // in bounded memory. Needs no audio device (the sample rate given to
+    // initialize() is used even if opening the device failed)
+    bool bounceNotes(const QVector<Note>& notes, const QString &path,
+                     WavWriter::Format format = WavWriter::Format::Pcm24,
+                     const OfflineBounce::ProgressCallback &progress = OfflineBounce::ProgressCallback(),
+                     QString *errorString = nullptr);
+
+    // Transport: timeline position (ms) of the audio handed to the device, counted
+    // in samples by the audio callback, with loops applied. Poll it for the playhead
+    double getTransportTimeMs() const;
+    bool isTransportRunning() const { return useStream.load() || useRenderBuffer.load(); }
 
-    // Graph-based synthesis (multi-track support)
-    bool buildGraph(class Canvas *canvas, int trackIndex);  // Build graph for specific track
+    // Polyphony: simultaneous notes per track, and which voice a note steals when all are busy
+    void setVoiceLimit(int voices);
+    int getVoiceLimit() const { return voiceLimit; }
+    void setStealPolicy(VoiceAllocator::StealPolicy policy);
+    VoiceAllocator::StealPolicy getStealPolicy() const { return stealPolicy; }
+
+    // Stereo placement of a track's notes (tracks never set play centred)
+    void setTrackMix(int trackIndex, const TrackMix &mix);
+    TrackMix getTrackMix(int trackIndex) const;
+
+    // Graph-based synthesis (multi-track support). Graphs are compiled from plain
+    // SounitDescriptions (Canvas::describe() or a .sounit file), never from widgets
+    bool buildGraph(const SounitDescription &description, int trackIndex);  // Build graph for specific track (any thread)
+    bool updateGraphParameters(const SounitDescription::Node &node, int trackIndex);  // Refresh one node's parameters (false = not in graph)
     void clearGraph(int trackIndex);   // Clear graph for specific track
     void clearAllGraphs();              // Clear all track graphs
     bool hasGraph(int trackIndex) const;  // Check if track has a valid graph
@@ -79,32 +139,119 @@ private:
                             unsigned int nFrames, double streamTime,
                             RtAudioStreamStatus status, void *userData);
 
+    // Voices of the track graphs and the track mixes for the audio thread,
+    // published as a whole. Only the audio thread plays (and so mutates) the voices
+    struct LiveVoices {
+        std::map<int, std::unique_ptr<SounitGraph>> graphs;  // By track index
+        std::map<int, TrackMix> mixes;  // By track index
+        uint64_t generation = 0;  // Unique per publish (addresses can be reused)
+    };
+
+    // Message from the UI thread to the live voice
+    struct LiveCommand {
+        enum class Type {
+            NoteOn,   // Start trackIndex's voice at pitchHz/dynamics for durationMs
+            Update,   // New pitchHz/dynamics for the playing note
+            NoteOff,  // Release (gate closes, amplitude fades)
+            Stop      // Silence immediately
+        };
+        Type type = Type::Stop;
+        int trackIndex = 0;
+        double pitchHz = 0.0;
+        double dynamics = 1.0;
+        double durationMs = 0.0;
+    };
+
+    // Transport of one playback, published as a whole
+    struct TransportSnapshot {
+        PlaybackTransport clock;
+        uint64_t generation = 0;  // Unique per playback (addresses can be reused)
+    };
+
+    // State of the live voice, owned by the audio thread
+    struct LiveState {
+        uint64_t voicesGeneration = 0;  // Snapshot graph belongs to (0 = none)
+        SounitGraph *graph = nullptr;  // Voice of the playing track (null = fallback generator)
+        bool voiceStale = true;  // Pick (and reset) the voice before the next block
+        uint64_t seed = 0;       // Random seed of the current note
+        int trackIndex = 0;
+        double pitchHz = 261.63;
+        double dynamics = 1.0;
+        uint64_t durationSamples = 0;
+        uint64_t elapsedSamples = 0;
+        bool gateOpen = false;
+        double amplitude = 0.0;  // Envelope state
+    };
+
+    // Audio thread: apply one command to the live voice
+    void applyLiveCommand(const LiveCommand &command);
+
+    // Audio thread: samples played so far of playing's playback, rewound to 0 the
+    // first time a new playback is seen (the UI thread never writes the counter)
+    uint64_t playedSamples(const TransportSnapshot *playing);
+
+    // Audio thread: render nFrames of the live voice into buffer (interleaved stereo)
+    void renderLive(float *buffer, unsigned int nFrames);
+
+    // Queue a command for the audio thread (UI thread)
+    void sendLiveCommand(const LiveCommand &command);
+
+    // Note::contentHash() of the first count notes
+    static std::vector<uint64_t> hashNotes(const QVector<Note> &notes, int count);
+
+    // Stop and release the streaming producer, if any
+    void stopStream();
+
+    // Publish the transport for a new playback; the callback rewinds the sample
+    // counter when it first sees it (call with both playback modes off)
+    void startTransport(const PlaybackRange &range);
+
+    // Publish fresh voices of the current track graphs, with the track mixes (call with graphMutex held)
+    void publishLiveVoices();
+
+    // Re-render the segments whose notes or graphs changed and mix all segments into output
+    void renderDirtySegments(OfflineRenderer &renderer, const QVector<Note> &notes, int count,
+                             size_t totalSamples, const QMap<int, uint64_t> &versions,
+                             std::vector<float> &output);
+
     RtAudio audioDevice;
-    HarmonicGenerator generator;  // Fallback for direct playback
+    HarmonicGenerator generator;  // Fallback for rendering tracks without a graph
     QMap<int, SounitGraph*> trackGraphs;  // Graph-based synthesis (one per track)
 
-    std::atomic<bool> gateOpen;  // Simple gate for now
-    std::atomic<double> amplitude;  // Envelope state
-    std::atomic<double> currentPitch;  // Current note pitch in Hz
-
-    // Note timing for envelope engine
-    std::atomic<double> noteDuration;  // Note duration in milliseconds
-    std::atomic<uint64_t> noteStartSample;  // Sample number when note started
+    // Live playback
+    SpscQueue<LiveCommand> liveCommands;  // UI thread -> audio thread
+    LiveState live;  // Audio thread only
+    HarmonicGenerator liveGenerator;  // Audio thread's own fallback generator
+    MixBus liveBus;  // Master gain and limiter of the live voice (sized in initialize())
     std::atomic<uint64_t> currentSample;  // Current sample number (for timing)
 
     // Pre-rendered buffer playback (segment-based)
+    RealtimeReclaimer reclaimer;  // Frees snapshots the audio thread has let go of
+    std::atomic<const std::vector<float>*> renderBuffer;  // Pre-rendered stereo audio for the whole timeline, interleaved (null = none)
+    std::atomic<LiveVoices*> liveVoices;  // Track graph voices for live playback (null = none)
+    uint64_t nextLiveVoicesGeneration;
     std::vector<RenderSegment> renderSegments;  // Pre-rendered audio segments
     double segmentDurationMs;  // Duration of each segment in milliseconds (default: 1000ms)
     std::atomic<bool> useRenderBuffer;  // true = play from buffer, false = live synthesis
-    std::atomic<size_t> renderPlaybackPosition;  // Current position in render buffer (global sample index)
+    std::atomic<RenderStream*> playbackStream;  // Streaming render being played (null = none)
+    std::atomic<bool> useStream;  // true = play from playbackStream (takes priority over the buffer)
+    double renderAheadMs;  // How far the streaming producer renders ahead of playback
+    std::atomic<const TransportSnapshot*> transport;  // Start and loop of the current playback (null = none)
+    uint64_t nextTransportGeneration;
+    std::atomic<uint64_t> transportPlayedSamples;  // Samples played since the playback started (audio thread)
+    std::atomic<uint64_t> transportPlayedGeneration;  // Playback transportPlayedSamples counts (audio thread)
     std::atomic<size_t> renderPlaybackSegmentIndex;  // Current segment being played
-    std::mutex renderBufferMutex;  // Protect render buffer during creation/playback
     std::atomic<bool> renderCacheDirty;  // true = need to re-render, false = can reuse buffer
-    QVector<Note> cachedNotes;  // The notes that were last rendered (for comparison)
+    std::vector<uint64_t> cachedNoteHashes;  // Note::contentHash() of the notes last rendered
+    QMap<int, uint64_t> graphVersions;  // Bumped whenever a track's graph or its parameters change
+    QMap<int, TrackMix> trackMixes;  // Pan and width per track (guarded by graphMutex)
+    uint64_t nextGraphVersion;  // Never reused, so a rebuilt graph never matches an old segment
+    int voiceLimit;  // Voices per track when rendering
+    VoiceAllocator::StealPolicy stealPolicy;
 
     unsigned int sampleRate;
     bool initialized;
-    std::mutex graphMutex;  // Protect graph access between audio thread and UI thread
+    mutable std::mutex graphMutex;  // Protect trackGraphs between the UI and render threads (never taken by the audio thread)
 };
 
 #endif // AUDIOENGINE_H
@@ -0,0 +1,391 @@
+#include "biquadbank.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BIQUADBANK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX (four filters per register) is picked at runtime. Left out on MinGW
+// for the same stack alignment bug as OscillatorBank (GCC bug 54412)
+#if defined(BIQUADBANK_SSE2) && (defined(__x86_64__) || defined(_M_X64)) \
+    && !(defined(__GNUC__) && defined(_WIN32))
+#define BIQUADBANK_AVX 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BIQUADBANK_TARGET_AVX
+#else
+#define BIQUADBANK_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace {
+
+constexpr int kStride = BiquadBank::kMaxFilters;
+
+struct KernelArgs {
+    double (*coeffs)[kStride];        // B0, B1, B2, A1, A2 rows
+    const double (*steps)[kStride];
+    double *state1;
+    double *state2;
+    const double *gains;              // Padded to kStride
+};
+
+// Filter numFrames samples with Pairs pairs of filters held in SSE2 registers.
+// Glide adds each coefficient's step every sample; Lanes writes every
+// filter's output instead of the weighted sum.
+template <int Pairs, bool Glide, bool Lanes>
+void runKernel(const KernelArgs &args, const double *input, double *output, int numFrames)
+{
+#ifdef BIQUADBANK_SSE2
+    __m128d b0[Pairs], b1[Pairs], b2[Pairs], a1[Pairs], a2[Pairs];
+    __m128d db0[Pairs], db1[Pairs], db2[Pairs], da1[Pairs], da2[Pairs];
+    __m128d s1[Pairs], s2[Pairs], gain[Pairs];
+    for (int p = 0; p < Pairs; p++) {
+        const int k = p * 2;
+        b0[p] = _mm_load_pd(args.coeffs[0] + k);
+        b1[p] = _mm_load_pd(args.coeffs[1] + k);
+        b2[p] = _mm_load_pd(args.coeffs[2] + k);
+        a1[p] = _mm_load_pd(args.coeffs[3] + k);
+        a2[p] = _mm_load_pd(args.coeffs[4] + k);
+        if (Glide) {
+            db0[p] = _mm_load_pd(args.steps[0] + k);
+            db1[p] = _mm_load_pd(args.steps[1] + k);
+            db2[p] = _mm_load_pd(args.steps[2] + k);
+            da1[p] = _mm_load_pd(args.steps[3] + k);
+            da2[p] = _mm_load_pd(args.steps[4] + k);
+        }
+        s1[p] = _mm_load_pd(args.state1 + k);
+        s2[p] = _mm_load_pd(args.state2 + k);
+        gain[p] = _mm_load_pd(args.gains + k);
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        const __m128d x = _mm_set1_pd(input[i]);
+        __m128d sum = _mm_setzero_pd();
+#pragma GCC unroll 4
+        for (int p = 0; p < Pairs; p++) {
+            if (Glide) {
+                b0[p] = _mm_add_pd(b0[p], db0[p]);
+                b1[p] = _mm_add_pd(b1[p], db1[p]);
+                b2[p] = _mm_add_pd(b2[p], db2[p]);
+                a1[p] = _mm_add_pd(a1[p], da1[p]);
+                a2[p] = _mm_add_pd(a2[p], da2[p]);
+            }
+
+            // Transposed Direct Form II:
+            // y = b0*x + s1, s1 = (b1*x + s2) - a1*y, s2 = b2*x - a2*y
+            // (b1*x + s2 doesn't wait for y, which keeps the recursion short)
+            __m128d y = _mm_add_pd(_mm_mul_pd(b0[p], x), s1[p]);
+            __m128d feedForward = _mm_add_pd(_mm_mul_pd(b1[p], x), s2[p]);
+            s1[p] = _mm_sub_pd(feedForward, _mm_mul_pd(a1[p], y));
+            s2[p] = _mm_sub_pd(_mm_mul_pd(b2[p], x), _mm_mul_pd(a2[p], y));
+
+            if (Lanes) {
+                _mm_storeu_pd(output + i * kStride + p * 2, y);
+            } else {
+                sum = _mm_add_pd(sum, _mm_mul_pd(gain[p], y));
+            }
+        }
+        if (!Lanes) {
+            output[i] = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+        }
+    }
+
+    for (int p = 0; p < Pairs; p++) {
+        const int k = p * 2;
+        if (Glide) {
+            _mm_store_pd(args.coeffs[0] + k, b0[p]);
+            _mm_store_pd(args.coeffs[1] + k, b1[p]);
+            _mm_store_pd(args.coeffs[2] + k, b2[p]);
+            _mm_store_pd(args.coeffs[3] + k, a1[p]);
+            _mm_store_pd(args.coeffs[4] + k, a2[p]);
+        }
+        _mm_store_pd(args.state1 + k, s1[p]);
+        _mm_store_pd(args.state2 + k, s2[p]);
+    }
+#else
+    constexpr int Filters = Pairs * 2;
+    double c[5][Filters], s1[Filters], s2[Filters];
+    for (int k = 0; k < Filters; k++) {
+        for (int j = 0; j < 5; j++) {
+            c[j][k] = args.coeffs[j][k];
+        }
+        s1[k] = args.state1[k];
+        s2[k] = args.state2[k];
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        const double x = input[i];
+        double sum = 0.0;
+        for (int k = 0; k < Filters; k++) {
+            if (Glide) {
+                for (int j = 0; j < 5; j++) {
+                    c[j][k] += args.steps[j][k];
+                }
+            }
+
+            // Transposed Direct Form II
+            double y = c[0][k] * x + s1[k];
+            s1[k] = (c[1][k] * x + s2[k]) - c[3][k] * y;
+            s2[k] = c[2][k] * x - c[4][k] * y;
+
+            if (Lanes) {
+                output[i * kStride + k] = y;
+            } else {
+                sum += args.gains[k] * y;
+            }
+        }
+        if (!Lanes) {
+            output[i] = sum;
+        }
+    }
+
+    for (int k = 0; k < Filters; k++) {
+        if (Glide) {
+            for (int j = 0; j < 5; j++) {
+                args.coeffs[j][k] = c[j][k];
+            }
+        }
+        args.state1[k] = s1[k];
+        args.state2[k] = s2[k];
+    }
+#endif
+}
+
+#ifdef BIQUADBANK_AVX
+// Same as runKernel with Quads groups of four filters per register
+template <int Quads, bool Glide, bool Lanes>
+BIQUADBANK_TARGET_AVX
+void runKernelAvx(const KernelArgs &args, const double *input, double *output, int numFrames)
+{
+    __m256d b0[Quads], b1[Quads], b2[Quads], a1[Quads], a2[Quads];
+    __m256d db0[Quads], db1[Quads], db2[Quads], da1[Quads], da2[Quads];
+    __m256d s1[Quads], s2[Quads], gain[Quads];
+    for (int q = 0; q < Quads; q++) {
+        const int k = q * 4;
+        b0[q] = _mm256_load_pd(args.coeffs[0] + k);
+        b1[q] = _mm256_load_pd(args.coeffs[1] + k);
+        b2[q] = _mm256_load_pd(args.coeffs[2] + k);
+        a1[q] = _mm256_load_pd(args.coeffs[3] + k);
+        a2[q] = _mm256_load_pd(args.coeffs[4] + k);
+        if (Glide) {
+            db0[q] = _mm256_load_pd(args.steps[0] + k);
+            db1[q] = _mm256_load_pd(args.steps[1] + k);
+            db2[q] = _mm256_load_pd(args.steps[2] + k);
+            da1[q] = _mm256_load_pd(args.steps[3] + k);
+            da2[q] = _mm256_load_pd(args.steps[4] + k);
+        }
+        s1[q] = _mm256_load_pd(args.state1 + k);
+        s2[q] = _mm256_load_pd(args.state2 + k);
+        gain[q] = _mm256_load_pd(args.gains + k);
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        const __m256d x = _mm256_set1_pd(input[i]);
+        __m256d sum = _mm256_setzero_pd();
+#pragma GCC unroll 2
+        for (int q = 0; q < Quads; q++) {
+            if (Glide) {
+                b0[q] = _mm256_add_pd(b0[q], db0[q]);
+                b1[q] = _mm256_add_pd(b1[q], db1[q]);
+                b2[q] = _mm256_add_pd(b2[q], db2[q]);
+                a1[q] = _mm256_add_pd(a1[q], da1[q]);
+                a2[q] = _mm256_add_pd(a2[q], da2[q]);
+            }
+
+            __m256d y = _mm256_add_pd(_mm256_mul_pd(b0[q], x), s1[q]);
+            __m256d feedForward = _mm256_add_pd(_mm256_mul_pd(b1[q], x), s2[q]);
+            s1[q] = _mm256_sub_pd(feedForward, _mm256_mul_pd(a1[q], y));
+            s2[q] = _mm256_sub_pd(_mm256_mul_pd(b2[q], x), _mm256_mul_pd(a2[q], y));
+
+            if (Lanes) {
+                _mm256_storeu_pd(output + i * kStride + q * 4, y);
+            } else {
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(gain[q], y));
+            }
+        }
+        if (!Lanes) {
+            __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+            output[i] = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+        }
+    }
+
+    for (int q = 0; q < Quads; q++) {
+        const int k = q * 4;
+        if (Glide) {
+            _mm256_store_pd(args.coeffs[0] + k, b0[q]);
+            _mm256_store_pd(args.coeffs[1] + k, b1[q]);
+            _mm256_store_pd(args.coeffs[2] + k, b2[q]);
+            _mm256_store_pd(args.coeffs[3] + k, a1[q]);
+            _mm256_store_pd(args.coeffs[4] + k, a2[q]);
+        }
+        _mm256_store_pd(args.state1 + k, s1[q]);
+        _mm256_store_pd(args.state2 + k, s2[q]);
+    }
+}
+
+bool cpuSupportsAvx()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#elif defined(_MSC_VER)
+    // OSXSAVE + AVX, and the OS saves YMM state
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return false;
+#endif
+}
+#endif
+
+template <bool Glide, bool Lanes>
+void dispatchKernel(int numFilters, const KernelArgs &args, const double *input, double *output, int numFrames)
+{
+    static_assert(kStride == 8, "dispatch covers up to 2 quads or 4 pairs");
+#ifdef BIQUADBANK_AVX
+    static const bool useAvx = cpuSupportsAvx();
+    if (useAvx) {
+        if (numFilters <= 4) {
+            runKernelAvx<1, Glide, Lanes>(args, input, output, numFrames);
+        } else {
+            runKernelAvx<2, Glide, Lanes>(args, input, output, numFrames);
+        }
+        return;
+    }
+#endif
+    switch ((numFilters + 1) / 2) {
+    case 1: runKernel<1, Glide, Lanes>(args, input, output, numFrames); break;
+    case 2: runKernel<2, Glide, Lanes>(args, input, output, numFrames); break;
+    case 3: runKernel<3, Glide, Lanes>(args, input, output, numFrames); break;
+    default: runKernel<4, Glide, Lanes>(args, input, output, numFrames); break;
+    }
+}
+
+} // namespace
+
+BiquadBank::BiquadBank(int numFilters)
+    : numFilters(1)
+    , glideRemaining(0)
+{
+    // Every filter starts as a passthrough
+    for (int k = 0; k < kMaxFilters; k++) {
+        for (int j = 0; j < NumCoefficients; j++) {
+            coeffs[j][k] = 0.0;
+            steps[j][k] = 0.0;
+        }
+        coeffs[B0][k] = 1.0;
+        for (int j = 0; j < NumCoefficients; j++) {
+            targets[j][k] = coeffs[j][k];
+        }
+    }
+    reset();
+    setNumFilters(numFilters);
+}
+
+void BiquadBank::setNumFilters(int count)
+{
+    numFilters = std::clamp(count, 1, kMaxFilters);
+}
+
+void BiquadBank::setCoefficients(int index, double b0, double b1, double b2, double a1, double a2)
+{
+    if (index < 0 || index >= kMaxFilters) return;
+
+    const double values[NumCoefficients] = {b0, b1, b2, a1, a2};
+    for (int j = 0; j < NumCoefficients; j++) {
+        coeffs[j][index] = values[j];
+        targets[j][index] = values[j];
+        steps[j][index] = 0.0;
+    }
+}
+
+void BiquadBank::setTarget(int index, double b0, double b1, double b2, double a1, double a2)
+{
+    if (index < 0 || index >= kMaxFilters) return;
+
+    const double values[NumCoefficients] = {b0, b1, b2, a1, a2};
+    for (int j = 0; j < NumCoefficients; j++) {
+        targets[j][index] = values[j];
+    }
+}
+
+void BiquadBank::startGlide(int frames)
+{
+    if (frames <= 0) {
+        finishGlide();
+        return;
+    }
+
+    // Filters already at their target get a zero step
+    const double scale = 1.0 / frames;
+    for (int j = 0; j < NumCoefficients; j++) {
+        for (int k = 0; k < kMaxFilters; k++) {
+            steps[j][k] = (targets[j][k] - coeffs[j][k]) * scale;
+        }
+    }
+    glideRemaining = frames;
+}
+
+void BiquadBank::finishGlide()
+{
+    // Land exactly on the targets, whatever rounding the steps left
+    for (int j = 0; j < NumCoefficients; j++) {
+        for (int k = 0; k < kMaxFilters; k++) {
+            coeffs[j][k] = targets[j][k];
+            steps[j][k] = 0.0;
+        }
+    }
+    glideRemaining = 0;
+}
+
+void BiquadBank::reset()
+{
+    for (int k = 0; k < kMaxFilters; k++) {
+        state1[k] = 0.0;
+        state2[k] = 0.0;
+    }
+}
+
+void BiquadBank::process(const double *input, double *output, int numFrames, const double *gains)
+{
+    // Unused lanes of the last register are muted
+    alignas(32) double paddedGains[kMaxFilters] = {};
+    std::copy(gains, gains + numFilters, paddedGains);
+    const KernelArgs args{coeffs, steps, state1, state2, paddedGains};
+
+    int i = 0;
+    if (glideRemaining > 0) {
+        int frames = std::min(numFrames, glideRemaining);
+        dispatchKernel<true, false>(numFilters, args, input, output, frames);
+        glideRemaining -= frames;
+        if (glideRemaining == 0) finishGlide();
+        i = frames;
+    }
+    if (i < numFrames) {
+        dispatchKernel<false, false>(numFilters, args, input + i, output + i, numFrames - i);
+    }
+}
+
+void BiquadBank::processLanes(const double *input, double *laneOutput, int numFrames)
+{
+    alignas(32) double noGains[kMaxFilters] = {};
+    const KernelArgs args{coeffs, steps, state1, state2, noGains};
+
+    int i = 0;
+    if (glideRemaining > 0) {
+        int frames = std::min(numFrames, glideRemaining);
+        dispatchKernel<true, true>(numFilters, args, input, laneOutput, frames);
+        glideRemaining -= frames;
+        if (glideRemaining == 0) finishGlide();
+        i = frames;
+    }
+    if (i < numFrames) {
+        dispatchKernel<false, true>(numFilters, args, input + i, laneOutput + i * kMaxFilters, numFrames - i);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BIQUADBANK_H
+#define BIQUADBANK_H
+
+/**
+ * BiquadBank - Parallel biquad filters fed by one input
+ *
+ * Shared filter kernel for FormantBody and NoiseColorFilter. Up to
+ * kMaxFilters biquads run side by side on the same input, each in
+ * Transposed Direct Form II (two state values, better behaved than
+ * Direct Form I when the coefficients move). Coefficients and state are
+ * kept as separate arrays so one register updates several filters at
+ * once: four with AVX (chosen at runtime), two with SSE2. The recursion
+ * is latency-bound, so filters sharing a register cost about the same
+ * as one - on AVX, a bank of 1-4 filters runs at single-filter speed.
+ *
+ * Coefficients can be set at once or glided: setTarget() the filters
+ * that change, then startGlide(frames) steps every coefficient linearly
+ * towards its target once per sample.
+ */
+class BiquadBank
+{
+public:
+    static constexpr int kMaxFilters = 8;
+
+    explicit BiquadBank(int numFilters = 1);
+
+    // Number of filters in use (1 to kMaxFilters)
+    void setNumFilters(int count);
+    int getNumFilters() const { return numFilters; }
+
+    // Set one filter's coefficients at once (a0 normalized to 1)
+    void setCoefficients(int index, double b0, double b1, double b2, double a1, double a2);
+
+    // Set one filter's glide target; takes effect at the next startGlide()
+    void setTarget(int index, double b0, double b1, double b2, double a1, double a2);
+
+    // Glide every filter to its target over frames samples (0 = jump now)
+    void startGlide(int frames);
+    bool isGliding() const { return glideRemaining > 0; }
+
+    // Clear filter state (coefficients are kept)
+    void reset();
+
+    // output[i] = sum over filters of gains[k] * y_k[i]
+    void process(const double *input, double *output, int numFrames, const double *gains);
+
+    // Each filter's output separately: laneOutput[i * kMaxFilters + k] = y_k[i]
+    void processLanes(const double *input, double *laneOutput, int numFrames);
+
+private:
+    enum Coefficient { B0, B1, B2, A1, A2, NumCoefficients };
+
+    void finishGlide();
+
+    int numFilters;
+
+    // Current, target and per-sample step of each coefficient, per filter
+    alignas(32) double coeffs[NumCoefficients][kMaxFilters];
+    alignas(32) double targets[NumCoefficients][kMaxFilters];
+    alignas(32) double steps[NumCoefficients][kMaxFilters];
+
+    // Transposed Direct Form II state per filter
+    alignas(32) double state1[kMaxFilters];
+    alignas(32) double state2[kMaxFilters];
+
+    int glideRemaining;
+};
+
+#endif // BIQUADBANK_H
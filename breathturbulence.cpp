@@ -49,3 +49,14 @@ double BreathTurbulence::processSample(double voiceIn, double noiseIn)
 
     return output;
 }
+
+void BreathTurbulence::processBlock(const double *voiceIn, const double *noiseIn,
+                                    double *output, int numFrames)
+{
+    // Blend curve is evaluated once for the whole block
+    double effectiveBlend = applyBlendCurve(blend);
+
+    for (int i = 0; i < numFrames; i++) {
+        output[i] = voiceIn[i] * (1.0 - effectiveBlend) + noiseIn[i] * effectiveBlend;
+    }
+}
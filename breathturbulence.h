@@ -30,6 +30,9 @@ public:
     // Process a single sample (blend voice and noise)
     double processSample(double voiceIn, double noiseIn);
 
+    // Process a block of samples with the current (fixed) blend
+    void processBlock(const double *voiceIn, const double *noiseIn, double *output, int numFrames);
+
     // Parameter setters
     void setBlend(double blend);
     void setBlendCurve(BlendCurve curve);
@@ -0,0 +1,185 @@
+/**
+ * calamus-render - Renders a score to a WAV file without the editor
+ *
+ *   calamus-render [options] <score.json> <output.wav>
+ *
+ * Loads each track's .sounit straight into a SounitGraph (no widgets, no
+ * QApplication) and bounces the score with OfflineBounce, so batches of
+ * variations can be rendered on machines without a display or audio
+ * device. Options override the score's sounits per track and set the
+ * render format. Ctrl+C cancels and deletes the partial file.
+ */
+
+#include "harmonicgenerator.h"
+#include "offlinebounce.h"
+#include "offlinerenderer.h"
+#include "scorefile.h"
+#include "sounitdescription.h"
+#include "sounitgraph.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QMap>
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <memory>
+
+static std::atomic<bool> interrupted(false);
+
+static void onInterrupt(int)
+{
+    interrupted.store(true);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("calamus-render");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render a Calamus score to a WAV file");
+    parser.addHelpOption();
+    parser.addPositionalArgument("score", "Score file (JSON)");
+    parser.addPositionalArgument("output", "WAV file to write");
+
+    QCommandLineOption sounitOption("sounit", "Sounit for a track, overriding the score (repeatable).", "track=file");
+    QCommandLineOption formatOption("format", "Sample format: pcm24 or float32 (default pcm24).", "format", "pcm24");
+    QCommandLineOption rateOption("sample-rate", "Sample rate in Hz (default 44100).", "hz", "44100");
+    QCommandLineOption threadsOption("threads", "Render threads (default: one per core).", "count", "0");
+    QCommandLineOption voicesOption("voices", "Voices per track (default 16).", "count", "16");
+    QCommandLineOption oversampleOption("oversample", "Oversample the harmonics: 1, 2 or 4 (default 1).", "factor", "1");
+    QCommandLineOption quietOption(QStringList{"q", "quiet"}, "Don't print progress.");
+    parser.addOption(sounitOption);
+    parser.addOption(formatOption);
+    parser.addOption(rateOption);
+    parser.addOption(threadsOption);
+    parser.addOption(voicesOption);
+    parser.addOption(oversampleOption);
+    parser.addOption(quietOption);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2) {
+        parser.showHelp(1);
+    }
+    const QString scorePath = args[0];
+    const QString outputPath = args[1];
+
+    WavWriter::Format format;
+    QString formatName = parser.value(formatOption).toLower();
+    if (formatName == "pcm24") {
+        format = WavWriter::Format::Pcm24;
+    } else if (formatName == "float32") {
+        format = WavWriter::Format::Float32;
+    } else {
+        std::cerr << "Unknown format: " << formatName.toStdString() << std::endl;
+        return 1;
+    }
+
+    bool ok = false;
+    double sampleRate = parser.value(rateOption).toDouble(&ok);
+    if (!ok || sampleRate < 8000.0 || sampleRate > 384000.0) {
+        std::cerr << "Invalid sample rate: " << parser.value(rateOption).toStdString() << std::endl;
+        return 1;
+    }
+    int threads = parser.value(threadsOption).toInt(&ok);
+    if (!ok || threads < 0) {
+        std::cerr << "Invalid thread count: " << parser.value(threadsOption).toStdString() << std::endl;
+        return 1;
+    }
+    int voices = parser.value(voicesOption).toInt(&ok);
+    if (!ok || voices < 1) {
+        std::cerr << "Invalid voice count: " << parser.value(voicesOption).toStdString() << std::endl;
+        return 1;
+    }
+    int oversample = parser.value(oversampleOption).toInt(&ok);
+    if (!ok || (oversample != 1 && oversample != 2 && oversample != 4)) {
+        std::cerr << "Invalid oversampling factor: " << parser.value(oversampleOption).toStdString() << std::endl;
+        return 1;
+    }
+
+    ScoreFile score;
+    QString errorString;
+    if (!score.loadFromFile(scorePath, &errorString)) {
+        std::cerr << errorString.toStdString() << std::endl;
+        return 1;
+    }
+
+    // Sounit per track: the score's, then the command line's
+    QMap<int, QString> sounitPaths;
+    for (const ScoreFile::Track &track : score.tracks) {
+        if (!track.sounitPath.isEmpty()) {
+            sounitPaths[track.index] = track.sounitPath;
+        }
+    }
+    for (const QString &spec : parser.values(sounitOption)) {
+        int split = spec.indexOf('=');
+        int track = split > 0 ? spec.left(split).toInt(&ok) : -1;
+        if (split <= 0 || !ok || track < 0) {
+            std::cerr << "Invalid --sounit (expected track=file): " << spec.toStdString() << std::endl;
+            return 1;
+        }
+        sounitPaths[track] = spec.mid(split + 1);
+    }
+
+    // Compile each track's graph straight from its file
+    std::map<int, std::unique_ptr<SounitGraph>> graphs;
+    QMap<int, SounitGraph*> trackGraphs;
+    for (auto it = sounitPaths.constBegin(); it != sounitPaths.constEnd(); ++it) {
+        SounitDescription description;
+        if (!description.loadFromFile(it.value(), &errorString)) {
+            std::cerr << errorString.toStdString() << std::endl;
+            return 1;
+        }
+        auto graph = std::make_unique<SounitGraph>(sampleRate);
+        graph->setOversampling(oversample);
+        graph->build(description);
+        if (!graph->isValid()) {
+            std::cerr << "Sounit for track " << it.key() << " has no valid signal path: "
+                      << it.value().toStdString() << std::endl;
+            return 1;
+        }
+        trackGraphs[it.key()] = graph.get();
+        graphs[it.key()] = std::move(graph);
+    }
+
+    for (const Note &note : score.notes) {
+        if (!trackGraphs.contains(note.getTrackIndex())) {
+            std::cerr << "Warning: no sounit for track " << note.getTrackIndex()
+                      << ", its notes play the default generator" << std::endl;
+            break;
+        }
+    }
+
+    HarmonicGenerator fallback(sampleRate);
+    auto renderer = std::make_unique<OfflineRenderer>(sampleRate);
+    renderer->setThreadCount(threads);
+    renderer->setVoiceLimit(voices);
+    renderer->prepare(trackGraphs, fallback);
+    renderer->setTrackMixes(score.trackMixes());
+
+    std::signal(SIGINT, onInterrupt);
+
+    const bool quiet = parser.isSet(quietOption);
+    int lastPercent = -1;
+    OfflineBounce bounce(std::move(renderer), sampleRate);
+    bounce.setFormat(format);
+    bounce.setProgressCallback([&](double fraction) {
+        int percent = static_cast<int>(fraction * 100.0);
+        if (!quiet && percent != lastPercent) {
+            std::cerr << "\rRendering: " << percent << "%" << std::flush;
+            lastPercent = percent;
+        }
+        return !interrupted.load();
+    });
+
+    bool rendered = bounce.run(score.notes, score.notes.size(), outputPath);
+    if (!quiet) {
+        std::cerr << std::endl;
+    }
+    if (!rendered) {
+        std::cerr << "Render failed: " << bounce.getErrorString().toStdString() << std::endl;
+        return bounce.wasCancelled() ? 130 : 1;
+    }
+    return 0;
+}
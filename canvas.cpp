@@ -317,6 +317,36 @@ QJsonObject Canvas::serializeConnection(const Connection &conn) const
     return json;
 }
 
+SounitDescription Canvas::describe() const
+{
+    SounitDescription description;
+    description.name = sounitName;
+    description.comment = sounitComment;
+
+    QList<Container*> containers = findChildren<Container*>();
+    QMap<const Container*, int> nodeIndex;
+    for (const Container *container : containers) {
+        nodeIndex[container] = description.nodes.size();
+        description.nodes.append(container->describe());
+    }
+
+    for (const Connection &conn : connections) {
+        if (!nodeIndex.contains(conn.fromContainer) || !nodeIndex.contains(conn.toContainer)) {
+            continue;
+        }
+        SounitDescription::Connection described;
+        described.fromNode = nodeIndex[conn.fromContainer];
+        described.fromPort = conn.fromPort;
+        described.toNode = nodeIndex[conn.toContainer];
+        described.toPort = conn.toPort;
+        described.function = conn.function;
+        described.weight = conn.weight;
+        description.connections.append(described);
+    }
+
+    return description;
+}
+
 bool Canvas::saveToJson(const QString &filePath, const QString &sounitName) const
 {
     QJsonObject root;
@@ -358,47 +388,6 @@ bool Canvas::saveToJson(const QString &filePath, const QString &sounitName) cons
     return true;
 }
 
-// Static helper to map container type to port lists
-static void getPortsForContainerType(const QString &type, QStringList &inputs, QStringList &outputs)
-{
-    if (type == "Harmonic Generator") {
-        inputs = {"purity", "drift"};
-        outputs = {"spectrum"};
-    } else if (type == "Spectrum to Signal") {
-        inputs = {"spectrumIn", "pitch", "normalize"};
-        outputs = {"signalOut"};
-    } else if (type == "Rolloff Processor") {
-        inputs = {"spectrumIn", "rolloff"};
-        outputs = {"spectrumOut"};
-    } else if (type == "Formant Body") {
-        inputs = {"signalIn", "f1Freq", "f2Freq", "f1Q", "f2Q", "directMix", "f1f2Balance"};
-        outputs = {"signalOut"};
-    } else if (type == "Breath Turbulence") {
-        inputs = {"voiceIn", "noiseIn", "blend"};
-        outputs = {"signalOut"};
-    } else if (type == "Noise Color Filter") {
-        inputs = {"audioIn", "color", "filterQ"};
-        outputs = {"noiseOut"};
-    } else if (type == "Physics System") {
-        inputs = {"targetValue", "mass", "springK", "damping", "impulse", "impulseAmount"};
-        outputs = {"currentValue"};
-    } else if (type == "Easing Applicator") {
-        inputs = {"startValue", "endValue", "progress", "easingSelect"};
-        outputs = {"easedValue"};
-    } else if (type == "Envelope Engine") {
-        inputs = {"timeScale", "valueScale", "valueOffset"};
-        outputs = {"envelopeValue"};
-    } else if (type == "Drift Engine") {
-        inputs = {"amount", "rate"};
-        outputs = {"driftOut"};
-    } else if (type == "Gate Processor") {
-        inputs = {"velocity", "attackTime", "releaseTime", "attackCurve", "releaseCurve", "velocitySens"};
-        outputs = {"envelopeOut", "stateOut", "attackTrigger", "releaseTrigger"};
-    } else {
-        qWarning() << "Unknown container type:" << type;
-    }
-}
-
 Container* Canvas::deserializeContainer(const QJsonObject &json, QWidget *parent)
 {
     QString type = json["type"].toString();
@@ -411,9 +400,7 @@ Container* Canvas::deserializeContainer(const QJsonObject &json, QWidget *parent
 
     // Determine inputs/outputs based on type
     QStringList inputs, outputs;
-    getPortsForContainerType(type, inputs, outputs);
-
-    if (inputs.isEmpty() && outputs.isEmpty()) {
+    if (!SounitDescription::portsForType(type, inputs, outputs)) {
         qWarning() << "Cannot deserialize unknown container type:" << type;
         return nullptr;
     }
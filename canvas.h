@@ -7,6 +7,7 @@
 #include <QVector>
 #include <QJsonObject>
 #include "container.h"
+#include "sounitdescription.h"
 #include <QKeyEvent>
 
 class Canvas : public QWidget
@@ -49,6 +50,9 @@ public:
         return nullptr;
     }
 
+    // Plain-data copy of the containers and connections, for SounitGraph
+    SounitDescription describe() const;
+
     // Sounit save/load
     bool saveToJson(const QString &filePath, const QString &sounitName) const;
     bool loadFromJson(const QString &filePath, QString &outSounitName);
@@ -12,6 +12,9 @@ Container::Container(QWidget *parent, const QString &name, const QColor &color,
     , ui(new Ui::Container)
     , dragging(false)
 {
+    static uint64_t nextNodeId = 1;
+    nodeId = nextNodeId++;
+
     ui->setupUi(this);
     containerColor = color;
     // Set the container name
@@ -218,6 +221,17 @@ double Container::getParameter(const QString &name, double defaultValue) const
     return parameters.value(name, defaultValue);
 }
 
+SounitDescription::Node Container::describe() const
+{
+    SounitDescription::Node node;
+    node.id = nodeId;
+    node.type = containerName;
+    node.instanceName = instanceName;
+    node.parameters = parameters;
+    node.customEnvelope = customEnvelopeData.points;
+    return node;
+}
+
 void Container::beginParameterUpdate()
 {
     batchUpdateInProgress = true;
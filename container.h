@@ -11,6 +11,8 @@
 #include <QMoveEvent>
 #include <QMap>
 #include "envelopelibraryDialog.h"
+#include "sounitdescription.h"
+#include <cstdint>
 
 namespace Ui {
 class Container;
@@ -35,6 +37,7 @@ public:
     QVector<PortInfo> getPorts() const { return ports; }
     QString getName() const { return containerName; }
     QString getInstanceName() const { return instanceName; }
+    uint64_t getNodeId() const { return nodeId; }  // Unique per container for the session
     void setInstanceName(const QString &name) { instanceName = name; }
     QColor getColor() const { return containerColor; }
     void setSelected(bool selected);
@@ -57,6 +60,9 @@ public:
     EnvelopeData getCustomEnvelopeData() const { return customEnvelopeData; }
     bool hasCustomEnvelopeData() const { return customEnvelopeData.points.size() > 0; }
 
+    // Plain-data copy of this container for SounitDescription
+    SounitDescription::Node describe() const;
+
 
 protected:
     void mousePressEvent(QMouseEvent *event) override;
@@ -82,6 +88,7 @@ private:
     QVector<PortInfo> ports;
     QString containerName;
     QString instanceName;  // User-editable instance name
+    uint64_t nodeId;       // Identity in SounitDescription
     bool isSelected = false;
     QMap<QString, double> parameters;  // Internal parameters (config)
     EnvelopeData customEnvelopeData;  // Custom envelope data (for Envelope Engine)
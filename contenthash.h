@@ -0,0 +1,39 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * ContentHash - 64-bit hashing of note and curve content
+ *
+ * combine() folds one value into a running hash (splitmix64 finalizer).
+ * Doubles are hashed by their bit pattern, so hashes are stable across
+ * runs and only equal values compare equal (-0.0 and 0.0 differ, which
+ * at worst costs one extra re-render).
+ */
+class ContentHash
+{
+public:
+    static uint64_t combine(uint64_t seed, uint64_t value)
+    {
+        uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    static uint64_t combine(uint64_t seed, double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return combine(seed, bits);
+    }
+
+    static uint64_t combine(uint64_t seed, int value)
+    {
+        return combine(seed, static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+};
+
+#endif // CONTENTHASH_H
@@ -1,11 +1,14 @@
 #include "curve.h"
+#include "contenthash.h"
 #include <algorithm>
 
 Curve::Curve()
+    : pointsHash(0)
 {
 }
 
 Curve::Curve(double constantValue)
+    : pointsHash(0)
 {
     // Create a flat curve with two points
     addPoint(0.0, constantValue);
@@ -15,27 +18,49 @@ Curve::Curve(double constantValue)
 void Curve::addPoint(double time, double value)
 {
     points.append(Point(time, value, 1.0));  // Default pressure = 1.0
+    hashPoint(points.last());
 }
 
 void Curve::addPoint(double time, double value, double pressure)
 {
     points.append(Point(time, value, pressure));
+    hashPoint(points.last());
 }
 
 void Curve::addPoint(const Point &point)
 {
     points.append(point);
+    hashPoint(point);
 }
 
 void Curve::clearPoints()
 {
     points.clear();
+    pointsHash = 0;
 }
 
 void Curve::sortPoints()
 {
     std::sort(points.begin(), points.end(),
               [](const Point &a, const Point &b) { return a.time < b.time; });
+
+    // Order changed, so the running hash has to be rebuilt
+    pointsHash = 0;
+    for (const Point &point : points) {
+        hashPoint(point);
+    }
+}
+
+uint64_t Curve::contentHash() const
+{
+    return ContentHash::combine(pointsHash, static_cast<uint64_t>(points.size()));
+}
+
+void Curve::hashPoint(const Point &point)
+{
+    pointsHash = ContentHash::combine(pointsHash, point.time);
+    pointsHash = ContentHash::combine(pointsHash, point.value);
+    pointsHash = ContentHash::combine(pointsHash, point.pressure);
 }
 
 double Curve::valueAt(double time) const
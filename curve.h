@@ -3,12 +3,16 @@
 
 #include <QVector>
 #include <QPair>
+#include <cstdint>
 
 /**
  * Curve - Stores parameter values over time
  *
  * Used for dynamics, pitch modulation, and other time-varying parameters.
  * Stores (time, value) pairs and provides linear interpolation between points.
+ *
+ * A hash of the points is kept up to date as points are added, so
+ * contentHash() is O(1) however long the curve is.
  */
 class Curve
 {
@@ -42,8 +46,14 @@ public:
     bool isEmpty() const { return points.isEmpty(); }
     void sortPoints();  // Ensure points are sorted by time
 
+    // Hash of every point (time, value, pressure) in order
+    uint64_t contentHash() const;
+
 private:
+    void hashPoint(const Point &point);
+
     QVector<Point> points;
+    uint64_t pointsHash;  // Running hash of points, extended by each addPoint
 };
 
 #endif // CURVE_H
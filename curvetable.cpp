@@ -0,0 +1,18 @@
+#include "curvetable.h"
+
+CurveTable::CurveTable()
+    : values(nullptr)
+{
+    bake([](double x) { return x; });
+}
+
+void CurveTable::bake(const std::function<double(double)> &shape)
+{
+    // A fresh table, so copies still holding the old one are unaffected
+    auto baked = std::make_shared<std::vector<double>>(kSize + 1);
+    for (int i = 0; i <= kSize; i++) {
+        (*baked)[i] = shape(static_cast<double>(i) / kSize);
+    }
+    values = baked->data();
+    samples = std::move(baked);
+}
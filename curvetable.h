@@ -0,0 +1,45 @@
+#ifndef CURVETABLE_H
+#define CURVETABLE_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * CurveTable - A shape on [0, 1] baked into a lookup table
+ *
+ * Shared by EnvelopeEngine and EasingApplicator. bake() samples the shape
+ * at kSize + 1 evenly spaced points whenever its parameters change, and
+ * lookup() interpolates linearly between the two nearest samples, so a
+ * curve costs the same to evaluate whatever its shape: no transcendental
+ * calls, no segment search.
+ *
+ * The samples are immutable once baked and shared between copies, so
+ * copying a configured processor into each voice doesn't copy the table.
+ */
+class CurveTable
+{
+public:
+    static constexpr int kSize = 4096;
+
+    CurveTable();  // Identity curve
+
+    // Sample shape(x) for x in [0, 1]
+    void bake(const std::function<double(double)> &shape);
+
+    // Interpolated shape value at x, clamped to [0, 1] (NaN reads as 0)
+    double lookup(double x) const
+    {
+        const double position = std::min(std::max(0.0, x), 1.0) * kSize;
+        const int index = std::min(static_cast<int>(position), kSize - 1);
+        const double fraction = position - index;
+        return values[index] + fraction * (values[index + 1] - values[index]);
+    }
+
+private:
+    std::shared_ptr<const std::vector<double>> samples;
+    const double *values;  // samples->data(), saving an indirection per lookup
+};
+
+#endif // CURVETABLE_H
@@ -0,0 +1,111 @@
+#include "decimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Kaiser window shape; beta 9 gives about 90 dB of stopband rejection
+constexpr double kKaiserBeta = 9.0;
+constexpr double kStopbandDb = 90.0;
+
+// Zeroth-order modified Bessel function of the first kind (power series)
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = 0.5 * x;
+    for (int k = 1; k < 50; k++) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+Decimator::Decimator(int factor)
+    : factor(std::max(factor, 1))
+    , writePos(0)
+{
+    if (this->factor == 1) {
+        return;
+    }
+
+    // Windowed-sinc low-pass whose stopband starts at the output Nyquist
+    // frequency (nothing folds back), normalized for unity gain at DC.
+    // Transition width from Kaiser's estimate, in cycles per input sample
+    int length = this->factor * kTapsPerPhase;
+    std::vector<double> taps(length);
+    double centre = 0.5 * (length - 1);
+    double transition = (kStopbandDb - 7.95) / (14.36 * (length - 1));
+    double cutoff = 0.5 / this->factor - 0.5 * transition;
+    double windowNorm = besselI0(kKaiserBeta);
+    double sum = 0.0;
+    for (int k = 0; k < length; k++) {
+        double t = k - centre;
+        double sinc = (t == 0.0) ? 2.0 * cutoff
+                                 : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double r = t / centre;
+        double window = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / windowNorm;
+        taps[k] = sinc * window;
+        sum += taps[k];
+    }
+
+    // Split into branches; each branch's taps are stored oldest sample first
+    // to match the delay line order
+    branchTaps.assign(this->factor * kTapsPerPhase, 0.0);
+    for (int p = 0; p < this->factor; p++) {
+        for (int j = 0; j < kTapsPerPhase; j++) {
+            branchTaps[p * kTapsPerPhase + (kTapsPerPhase - 1 - j)] = taps[j * this->factor + p] / sum;
+        }
+    }
+    branchHistory.assign(this->factor * 2 * kTapsPerPhase, 0.0);
+}
+
+double Decimator::getLatency() const
+{
+    if (factor == 1) {
+        return 0.0;
+    }
+    return 0.5 * (factor * kTapsPerPhase - 1) / factor;
+}
+
+void Decimator::reset()
+{
+    std::fill(branchHistory.begin(), branchHistory.end(), 0.0);
+    writePos = 0;
+}
+
+void Decimator::process(const double *input, double *output, int numFrames)
+{
+    if (factor == 1) {
+        std::copy(input, input + numFrames, output);
+        return;
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        const double *frame = input + i * factor;
+        double sum = 0.0;
+
+        for (int p = 0; p < factor; p++) {
+            // Push this branch's input sample into both copies of its delay line
+            double *history = branchHistory.data() + p * 2 * kTapsPerPhase;
+            double sample = frame[factor - 1 - p];
+            history[writePos] = sample;
+            history[writePos + kTapsPerPhase] = sample;
+
+            // Newest kTapsPerPhase samples, oldest first
+            const double *window = history + writePos + 1;
+            const double *taps = branchTaps.data() + p * kTapsPerPhase;
+            for (int j = 0; j < kTapsPerPhase; j++) {
+                sum += taps[j] * window[j];
+            }
+        }
+
+        output[i] = sum;
+        writePos = (writePos + 1) % kTapsPerPhase;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <vector>
+
+/**
+ * Decimator - Polyphase FIR decimator for oversampled signals
+ *
+ * Low-pass filters a signal running at factor x the output rate and keeps
+ * every factor-th sample. The linear-phase (Kaiser-windowed sinc) filter
+ * is split into factor branches, one per input phase, so only the kept
+ * outputs are ever computed: kTapsPerPhase multiply-adds per branch per
+ * output sample. The stopband starts at the output Nyquist frequency, so
+ * nothing aliases; the passband ends about 0.09 x the output rate below it.
+ *
+ * Delays the signal by getLatency() output samples.
+ */
+class Decimator
+{
+public:
+    // factor 1 passes the signal through unchanged
+    explicit Decimator(int factor = 1);
+
+    int getFactor() const { return factor; }
+
+    // Filter delay in output samples
+    double getLatency() const;
+
+    // Clear the filter history (call when starting a new note)
+    void reset();
+
+    // Consume numFrames * factor input samples, write numFrames output samples
+    void process(const double *input, double *output, int numFrames);
+
+    // Taps per polyphase branch (filter length is factor * kTapsPerPhase)
+    static constexpr int kTapsPerPhase = 64;
+
+private:
+    int factor;
+
+    // Branch p filters input samples at position factor - 1 - p within each
+    // output period with taps h[j * factor + p]. Each branch's delay line is
+    // stored twice over so the newest kTapsPerPhase samples are contiguous
+    std::vector<double> branchTaps;     // factor rows of kTapsPerPhase taps
+    std::vector<double> branchHistory;  // factor rows of 2 * kTapsPerPhase samples
+    int writePos;                       // Next slot in every branch's delay line
+};
+
+#endif // DECIMATOR_H
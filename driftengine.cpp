@@ -1,6 +1,4 @@
 #include "driftengine.h"
-#include <cstdlib>
-#include <ctime>
 
 DriftEngine::DriftEngine(double sampleRate)
     : sampleRate(sampleRate)
@@ -13,9 +11,8 @@ DriftEngine::DriftEngine(double sampleRate)
     , randomValue(0.0)
     , randomCounter(0.0)
     , randomUpdateRate(0.1)
+    , random(0)
 {
-    // Seed random number generator
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
 }
 
 void DriftEngine::reset()
@@ -47,6 +44,11 @@ void DriftEngine::setSampleRate(double rate)
     this->sampleRate = rate;
 }
 
+void DriftEngine::setSeed(uint64_t seed)
+{
+    random.seed(seed);
+}
+
 double DriftEngine::generateSample()
 {
     double driftValue = 0.0;
@@ -70,7 +72,7 @@ double DriftEngine::generateSample()
 
             // Update random value at specified rate
             if (randomCounter >= randomUpdateRate) {
-                randomValue = (static_cast<double>(std::rand()) / RAND_MAX) * 2.0 - 1.0;
+                randomValue = random.next();
                 randomCounter = 0.0;
             }
 
@@ -1,8 +1,10 @@
 #ifndef DRIFTENGINE_H
 #define DRIFTENGINE_H
 
+#include "noisegenerator.h"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <vector>
 
 /**
@@ -19,6 +21,10 @@
  * - Generates slow LFO oscillations
  * - Output: detuning multiplier (around 1.0 ± amount)
  * - Future: Support per-harmonic drift for richer beating
+ *
+ * The Random pattern draws from the engine's own seeded stream (seed 0
+ * until setSeed()), so a render is reproducible and engines on different
+ * threads never share generator state.
  */
 class DriftEngine
 {
@@ -43,6 +49,9 @@ public:
     void setDriftPattern(DriftPattern pattern);
     void setSampleRate(double rate);
 
+    // Restart the Random pattern's stream from seed
+    void setSeed(uint64_t seed);
+
     // Parameter getters
     double getAmount() const { return amount; }
     double getRate() const { return rate; }
@@ -63,6 +72,7 @@ private:
     double randomValue;
     double randomCounter;
     double randomUpdateRate;
+    NoiseGenerator random;
 };
 
 #endif // DRIFTENGINE_H
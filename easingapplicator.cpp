@@ -3,12 +3,14 @@
 EasingApplicator::EasingApplicator()
     : easingType(EasingType::Linear)
     , easingMode(EasingMode::InOut)
+    , tableDirty(false)  // The table starts as the identity curve, i.e. Linear
 {
 }
 
 void EasingApplicator::setEasingType(EasingType type)
 {
     easingType = type;
+    tableDirty = true;
 }
 
 void EasingApplicator::setEasingSelect(int index)
@@ -44,11 +46,22 @@ void EasingApplicator::setEasingSelect(int index)
             easingMode = EasingMode::InOut;
             break;
     }
+    tableDirty = true;
 }
 
 void EasingApplicator::setEasingMode(EasingMode mode)
 {
     easingMode = mode;
+    tableDirty = true;
+}
+
+void EasingApplicator::updateTable()
+{
+    if (!tableDirty) {
+        return;
+    }
+    table.bake([this](double t) { return applyEasing(t); });
+    tableDirty = false;
 }
 
 double EasingApplicator::easeLinear(double t) const
@@ -220,8 +233,9 @@ double EasingApplicator::applyEasing(double t) const
 
 double EasingApplicator::process(double startValue, double endValue, double progress)
 {
-    // Apply easing function to progress
-    double easedProgress = applyEasing(progress);
+    // Look up the easing function at progress
+    updateTable();
+    double easedProgress = table.lookup(progress);
 
     // Interpolate between start and end
     double output = startValue + (endValue - startValue) * easedProgress;
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include "curvetable.h"
 
 /**
  * EasingApplicator - Shapes parameter transitions using easing functions
@@ -27,6 +28,10 @@
  * - Pitch glide between notes
  * - Formant sweeps for consonants
  * - Brightness bloom on attack
+ *
+ * The selected easing function is baked into a CurveTable when the type
+ * or mode changes, so process() costs a table lookup instead of the
+ * pow/trig calls of the elastic, back and sine curves.
  */
 class EasingApplicator
 {
@@ -58,6 +63,10 @@ public:
     // Apply easing to interpolate between start and end
     double process(double startValue, double endValue, double progress);
 
+    // Bake the curve table now if the easing changed (process() otherwise
+    // does it on its next call)
+    void updateTable();
+
     // Parameter setters
     void setEasingType(EasingType type);
     void setEasingSelect(int index);  // Select by index
@@ -79,6 +88,10 @@ private:
 
     EasingType easingType;
     EasingMode easingMode;
+
+    // applyEasing() over [0, 1], baked when the type or mode changes
+    CurveTable table;
+    bool tableDirty;
 };
 
 #endif // EASINGAPPLICATOR_H
@@ -0,0 +1,31 @@
+#ifndef ENVELOPEDATA_H
+#define ENVELOPEDATA_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * EnvelopePoint - Single control point in an envelope
+ */
+struct EnvelopePoint {
+    double time;        // 0.0 to 1.0
+    double value;       // 0.0 to 1.0
+    int curveType;      // 0=Linear, 1=Smooth, 2=Step
+    
+    EnvelopePoint(double t = 0.0, double v = 0.0, int c = 0)
+        : time(t), value(v), curveType(c) {}
+};
+
+/**
+ * EnvelopeData - Complete envelope curve definition
+ */
+struct EnvelopeData {
+    QString name;
+    QVector<EnvelopePoint> points;
+    int loopMode;       // 0=None, 1=Loop, 2=Ping-pong
+    bool isFactory;
+    
+    EnvelopeData() : loopMode(0), isFactory(false) {}
+};
+
+#endif // ENVELOPEDATA_H
@@ -11,12 +11,14 @@ EnvelopeEngine::EnvelopeEngine()
     , sustainLevel(0.7)
     , releaseTime(0.2)
     , fadeTime(0.5)
+    , tableDirty(false)  // The table starts as the identity curve, i.e. Linear
 {
 }
 
 void EnvelopeEngine::setEnvelopeType(EnvelopeType type)
 {
     envelopeType = type;
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setEnvelopeSelect(int index)
@@ -31,6 +33,7 @@ void EnvelopeEngine::setEnvelopeSelect(int index)
         case 5: envelopeType = EnvelopeType::Custom; break;  // Custom envelope
         default: envelopeType = EnvelopeType::Linear; break;
     }
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setTimeScale(double scale)
@@ -56,26 +59,31 @@ void EnvelopeEngine::setLoopMode(LoopMode mode)
 void EnvelopeEngine::setAttackTime(double time)
 {
     attackTime = std::clamp(time, 0.001, 5.0);
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setDecayTime(double time)
 {
     decayTime = std::clamp(time, 0.001, 5.0);
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setSustainLevel(double level)
 {
     sustainLevel = std::clamp(level, 0.0, 1.0);
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setReleaseTime(double time)
 {
     releaseTime = std::clamp(time, 0.001, 5.0);
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setFadeTime(double time)
 {
     fadeTime = std::clamp(time, 0.0, 1.0);
+    tableDirty = true;
 }
 
 void EnvelopeEngine::setCustomEnvelope(const QVector<EnvelopePoint> &points)
@@ -86,6 +94,16 @@ void EnvelopeEngine::setCustomEnvelope(const QVector<EnvelopePoint> &points)
               [](const EnvelopePoint &a, const EnvelopePoint &b) {
                   return a.time < b.time;
               });
+    tableDirty = true;
+}
+
+void EnvelopeEngine::updateTable()
+{
+    if (!tableDirty) {
+        return;
+    }
+    table.bake([this](double position) { return evaluateEnvelope(position); });
+    tableDirty = false;
 }
 
 double EnvelopeEngine::applyLoopMode(double position) const
@@ -264,8 +282,9 @@ double EnvelopeEngine::process(double noteProgress)
     // Apply loop mode
     double loopedPosition = applyLoopMode(scaledPosition);
 
-    // Evaluate envelope curve
-    double envelopeValue = evaluateEnvelope(loopedPosition);
+    // Look up the envelope curve
+    updateTable();
+    double envelopeValue = table.lookup(loopedPosition);
 
     // Apply value scaling and offset
     double finalValue = envelopeValue * valueScale + valueOffset;
@@ -4,7 +4,8 @@
 #include <algorithm>
 #include <cmath>
 #include <QVector>
-#include "envelopelibraryDialog.h"
+#include "curvetable.h"
+#include "envelopedata.h"
 
 /**
  * EnvelopeEngine - Applies arbitrary envelope shapes to parameters over note lifetime
@@ -26,6 +27,10 @@
  * - None: Hold at final value after completion
  * - Loop: Restart from beginning
  * - Pingpong: Reverse direction and bounce
+ *
+ * The selected shape (type, timing parameters or custom points) is baked
+ * into a CurveTable when it changes, so process() is a table lookup
+ * rather than a curve evaluation or a search through the custom points.
  */
 class EnvelopeEngine
 {
@@ -51,6 +56,10 @@ public:
     // Process and return envelope value for given note progress
     double process(double noteProgress);
 
+    // Bake the curve table now if the shape changed (process() otherwise
+    // does it on its next call)
+    void updateTable();
+
     // Parameter setters
     void setEnvelopeType(EnvelopeType type);
     void setEnvelopeSelect(int index);  // Select by index (0-5)
@@ -98,6 +107,10 @@ private:
 
     // Custom envelope data
     QVector<EnvelopePoint> customEnvelopePoints;
+
+    // evaluateEnvelope() over [0, 1], baked when the shape changes
+    CurveTable table;
+    bool tableDirty;
 };
 
 #endif // ENVELOPEENGINE_H
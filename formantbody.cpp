@@ -1,47 +1,102 @@
 #include "formantbody.h"
 #include <algorithm>
+#include <array>
+
+namespace {
+
+// sin/cos of 2*pi*x for normalized frequency x in [0, 0.5]: the nearest table
+// entry, corrected by angle addition with a short series for the remainder
+constexpr int kTrigTableSize = 1024;
+
+struct TrigTable {
+    std::array<double, kTrigTableSize + 1> sinValues;
+    std::array<double, kTrigTableSize + 1> cosValues;
+
+    TrigTable()
+    {
+        for (int i = 0; i <= kTrigTableSize; i++) {
+            double omega = M_PI * i / kTrigTableSize;
+            sinValues[i] = std::sin(omega);
+            cosValues[i] = std::cos(omega);
+        }
+    }
+};
+
+const TrigTable &trigTable()
+{
+    static const TrigTable table;
+    return table;
+}
+
+void sinCos(double normalizedFreq, double &sinOmega, double &cosOmega)
+{
+    const TrigTable &table = trigTable();
+    double pos = std::clamp(normalizedFreq, 0.0, 0.5) * (2.0 * kTrigTableSize);
+    int index = static_cast<int>(pos + 0.5);
+
+    // Remainder is at most half a step (~0.0015 rad), so these terms are exact to ~1e-13
+    double d = (pos - index) * (M_PI / kTrigTableSize);
+    double d2 = d * d;
+    double sinD = d * (1.0 - d2 / 6.0);
+    double cosD = 1.0 - d2 * (0.5 - d2 / 24.0);
+
+    sinOmega = table.sinValues[index] * cosD + table.cosValues[index] * sinD;
+    cosOmega = table.cosValues[index] * cosD - table.sinValues[index] * sinD;
+}
+
+bool movedPastThreshold(double designed, double current, double threshold)
+{
+    return std::abs(current - designed) > threshold * designed;
+}
+
+} // namespace
 
 FormantBody::FormantBody(double sampleRate)
     : sampleRate(sampleRate)
-    , f1Freq(500.0)
-    , f2Freq(1500.0)
-    , f1Q(8.0)
-    , f2Q(10.0)
     , directMix(0.3)
     , f1f2Balance(0.6)
+    , formants{{500.0, 8.0, 1.0}, {1500.0, 10.0, 1.0},
+               {2500.0, 12.0, 0.0}, {3500.0, 12.0, 0.0}, {4500.0, 12.0, 0.0}}
+    , numFormants(2)
+    , filters(2)
+    , coefficientsDirty(true)
+    , primed(false)
+    , glideFrames(0)
 {
-    updateF1Coefficients();
-    updateF2Coefficients();
+    updateCoefficients();
 }
 
 void FormantBody::reset()
 {
-    f1Filter.reset();
-    f2Filter.reset();
+    filters.reset();
+
+    // The next note starts on its own settings rather than gliding from the last one
+    primed = false;
+    coefficientsDirty = true;
 }
 
 void FormantBody::setF1Freq(double freq)
 {
-    f1Freq = std::clamp(freq, 200.0, 1000.0);
-    updateF1Coefficients();
+    formants[0].freq = std::clamp(freq, 200.0, 1000.0);
+    coefficientsDirty = true;
 }
 
 void FormantBody::setF2Freq(double freq)
 {
-    f2Freq = std::clamp(freq, 500.0, 3000.0);
-    updateF2Coefficients();
+    formants[1].freq = std::clamp(freq, 500.0, 3000.0);
+    coefficientsDirty = true;
 }
 
 void FormantBody::setF1Q(double q)
 {
-    f1Q = std::clamp(q, 1.0, 20.0);
-    updateF1Coefficients();
+    formants[0].q = std::clamp(q, 1.0, 20.0);
+    coefficientsDirty = true;
 }
 
 void FormantBody::setF2Q(double q)
 {
-    f2Q = std::clamp(q, 1.0, 20.0);
-    updateF2Coefficients();
+    formants[1].q = std::clamp(q, 1.0, 20.0);
+    coefficientsDirty = true;
 }
 
 void FormantBody::setDirectMix(double mix)
@@ -57,60 +112,142 @@ void FormantBody::setF1F2Balance(double balance)
 void FormantBody::setSampleRate(double rate)
 {
     sampleRate = rate;
-    updateF1Coefficients();
-    updateF2Coefficients();
+
+    // Force a full redesign for the new rate
+    for (Formant &formant : formants) {
+        formant.designedFreq = -1.0;
+    }
+    coefficientsDirty = true;
 }
 
-void FormantBody::updateF1Coefficients()
+void FormantBody::setNumFormants(int count)
 {
-    // Bandpass biquad filter coefficients
-    // Reference: Audio EQ Cookbook by Robert Bristow-Johnson
+    numFormants = std::clamp(count, 2, kMaxFormants);
+    filters.setNumFilters(numFormants);
+    coefficientsDirty = true;
+}
 
-    double omega = 2.0 * M_PI * f1Freq / sampleRate;
-    double sinOmega = std::sin(omega);
-    double cosOmega = std::cos(omega);
-    double alpha = sinOmega / (2.0 * f1Q);
+void FormantBody::setFormant(int index, double freq, double q, double gain)
+{
+    if (index < 2 || index >= kMaxFormants) return;
 
-    // Bandpass filter (constant 0 dB peak gain)
-    double a0 = 1.0 + alpha;
-    f1Filter.b0 = alpha / a0;
-    f1Filter.b1 = 0.0;
-    f1Filter.b2 = -alpha / a0;
-    f1Filter.a1 = -2.0 * cosOmega / a0;
-    f1Filter.a2 = (1.0 - alpha) / a0;
+    formants[index].freq = std::clamp(freq, 500.0, 8000.0);
+    formants[index].q = std::clamp(q, 1.0, 20.0);
+    formants[index].gain = std::clamp(gain, 0.0, 1.0);
+    coefficientsDirty = true;
 }
 
-void FormantBody::updateF2Coefficients()
+void FormantBody::updateCoefficients()
 {
-    // Bandpass biquad filter coefficients
+    if (!coefficientsDirty) {
+        return;
+    }
+    coefficientsDirty = false;
+
+    bool jump = !primed || glideFrames == 0;
+    bool redesigned = false;
+    for (int k = 0; k < numFormants; k++) {
+        redesigned |= designFormant(k, jump);
+    }
+    if (redesigned && !jump) {
+        filters.startGlide(glideFrames);
+    }
+}
 
-    double omega = 2.0 * M_PI * f2Freq / sampleRate;
-    double sinOmega = std::sin(omega);
-    double cosOmega = std::cos(omega);
-    double alpha = sinOmega / (2.0 * f2Q);
+bool FormantBody::designFormant(int index, bool jump)
+{
+    Formant &formant = formants[index];
+    bool designed = formant.designedFreq > 0.0;
+    if (designed && !jump
+        && !movedPastThreshold(formant.designedFreq, formant.freq, kRedesignThreshold)
+        && !movedPastThreshold(formant.designedQ, formant.q, kRedesignThreshold)) {
+        return false;
+    }
+    formant.designedFreq = formant.freq;
+    formant.designedQ = formant.q;
+
+    // Bandpass biquad filter coefficients (constant 0 dB peak gain)
+    // Reference: Audio EQ Cookbook by Robert Bristow-Johnson
+    double sinOmega, cosOmega;
+    sinCos(formant.freq / sampleRate, sinOmega, cosOmega);
+    double alpha = sinOmega / (2.0 * formant.q);
 
-    // Bandpass filter (constant 0 dB peak gain)
     double a0 = 1.0 + alpha;
-    f2Filter.b0 = alpha / a0;
-    f2Filter.b1 = 0.0;
-    f2Filter.b2 = -alpha / a0;
-    f2Filter.a1 = -2.0 * cosOmega / a0;
-    f2Filter.a2 = (1.0 - alpha) / a0;
+    double b0 = alpha / a0;
+    double a1 = -2.0 * cosOmega / a0;
+    double a2 = (1.0 - alpha) / a0;
+
+    // A filter that has never sounded starts on its design rather than gliding in
+    if (jump || !designed) {
+        filters.setCoefficients(index, b0, 0.0, -b0, a1, a2);
+    } else {
+        filters.setTarget(index, b0, 0.0, -b0, a1, a2);
+    }
+    return true;
 }
 
-double FormantBody::processSample(double input)
+void FormantBody::wetGains(double balance, double *gains) const
 {
-    // Process both formant filters in parallel
-    double f1Out = f1Filter.process(input);
-    double f2Out = f2Filter.process(input);
+    // f1f2Balance: 0 = F2 only, 1 = F1 only; F3-F5 add at their own gain
+    gains[0] = balance;
+    gains[1] = 1.0 - balance;
+    for (int k = 2; k < numFormants; k++) {
+        gains[k] = formants[k].gain;
+    }
+}
 
-    // Blend F1 and F2 based on balance parameter
-    // f1f2Balance: 0 = F2 only, 1 = F1 only
-    double formantBlend = f1Out * f1f2Balance + f2Out * (1.0 - f1f2Balance);
+double FormantBody::processSample(double input)
+{
+    double output;
+    processBlock(&input, &output, 1);
+    return output;
+}
 
-    // Mix direct and filtered signal
-    // directMix: 0 = all filtered, 1 = all direct
-    double output = input * directMix + formantBlend * (1.0 - directMix);
+void FormantBody::processBlock(const double *input, double *output, int numFrames)
+{
+    updateCoefficients();
+    primed = true;
+
+    // Wet gains fold in (1 - directMix): directMix 0 = all filtered, 1 = all direct
+    double gains[kMaxFormants];
+    wetGains(f1f2Balance, gains);
+    for (int k = 0; k < numFormants; k++) {
+        gains[k] *= 1.0 - directMix;
+    }
+
+    // Filter into a chunk buffer so input and output may be the same block
+    double wet[kChunkFrames];
+    for (int start = 0; start < numFrames; start += kChunkFrames) {
+        int frames = std::min(kChunkFrames, numFrames - start);
+        filters.process(input + start, wet, frames, gains);
+        for (int i = 0; i < frames; i++) {
+            output[start + i] = input[start + i] * directMix + wet[i];
+        }
+    }
+}
 
-    return output;
+void FormantBody::processBlock(const double *input, double *output, int numFrames,
+                               const double *directMix, const double *f1f2Balance)
+{
+    updateCoefficients();
+    primed = true;
+
+    double gains[kMaxFormants];
+    double lanes[kChunkFrames * BiquadBank::kMaxFilters];
+    for (int start = 0; start < numFrames; start += kChunkFrames) {
+        int frames = std::min(kChunkFrames, numFrames - start);
+        filters.processLanes(input + start, lanes, frames);
+
+        for (int i = 0; i < frames; i++) {
+            double mix = std::clamp(directMix[start + i], 0.0, 1.0);
+            wetGains(std::clamp(f1f2Balance[start + i], 0.0, 1.0), gains);
+
+            const double *y = lanes + i * BiquadBank::kMaxFilters;
+            double formantBlend = 0.0;
+            for (int k = 0; k < numFormants; k++) {
+                formantBlend += gains[k] * y[k];
+            }
+            output[start + i] = input[start + i] * mix + formantBlend * (1.0 - mix);
+        }
+    }
 }
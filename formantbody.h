@@ -1,12 +1,14 @@
 #ifndef FORMANTBODY_H
 #define FORMANTBODY_H
 
+#include "biquadbank.h"
+#include <algorithm>
 #include <cmath>
 
 /**
  * FormantBody - Resonant filtering creating vowel-like character
  *
- * The "throat" - uses two parallel resonant bandpass filters (biquad)
+ * The "throat" - uses parallel resonant bandpass filters (biquad)
  * to create formant peaks that give the sound vowel-like qualities.
  *
  * Parameters:
@@ -14,15 +16,37 @@
  * - f1Q, f2Q: Formant resonance (higher Q = narrower, more resonant)
  * - directMix: Dry/wet blend (0 = all filtered, 1 = all direct)
  * - f1f2Balance: Balance between F1 and F2 (0 = F2 only, 1 = F1 only)
+ *
+ * Up to three more formants (F3-F5) can be added with setNumFormants()
+ * and setFormant(); each adds its own gain to the wet signal. The
+ * formants run as lanes of one BiquadBank, so F3 and F4 cost about one
+ * more SIMD register between them.
+ *
+ * Filter design is lazy and cheap under modulation: setters only record
+ * the new settings, and a filter is redesigned (sin/cos from a shared
+ * table) when its frequency or Q has moved by more than 0.1% since the
+ * last design. A redesign doesn't step the coefficients - they glide
+ * linearly to the new design over glideFrames samples, so settings
+ * updated once per control tick still sweep smoothly. Each filter's
+ * (a1, a2) stays inside the stability triangle throughout the glide.
  */
 class FormantBody
 {
 public:
+    static constexpr int kMaxFormants = 5;
+
     FormantBody(double sampleRate = 44100.0);
 
     // Process a single audio sample
     double processSample(double input);
 
+    // Process a block of samples with the current (fixed) parameters
+    void processBlock(const double *input, double *output, int numFrames);
+
+    // Process a block with per-frame direct mix and F1/F2 balance
+    void processBlock(const double *input, double *output, int numFrames,
+                      const double *directMix, const double *f1f2Balance);
+
     // Reset filter state (call when starting a new note)
     void reset();
 
@@ -35,59 +59,61 @@ public:
     void setF1F2Balance(double balance);
     void setSampleRate(double rate);
 
+    // Formants in use (2 to kMaxFormants); F1 and F2 are always present
+    void setNumFormants(int count);
+    int getNumFormants() const { return numFormants; }
+
+    // Set F3-F5 (index 2 to 4): frequency (500-8000 Hz), Q and gain (0-1)
+    void setFormant(int index, double freq, double q, double gain);
+
+    // Samples over which the coefficients glide to a new design (0 = jump)
+    void setGlideFrames(int frames) { glideFrames = std::max(frames, 0); }
+    int getGlideFrames() const { return glideFrames; }
+
     // Parameter getters
-    double getF1Freq() const { return f1Freq; }
-    double getF2Freq() const { return f2Freq; }
-    double getF1Q() const { return f1Q; }
-    double getF2Q() const { return f2Q; }
+    double getF1Freq() const { return formants[0].freq; }
+    double getF2Freq() const { return formants[1].freq; }
+    double getF1Q() const { return formants[0].q; }
+    double getF2Q() const { return formants[1].q; }
     double getDirectMix() const { return directMix; }
     double getF1F2Balance() const { return f1f2Balance; }
 
 private:
-    // Biquad filter for resonant bandpass
-    struct BiquadFilter {
-        // Filter coefficients
-        double b0, b1, b2;  // Numerator
-        double a1, a2;      // Denominator (a0 is normalized to 1)
-
-        // Filter state (delayed samples)
-        double x1, x2;  // Input history
-        double y1, y2;  // Output history
-
-        BiquadFilter() : b0(0), b1(0), b2(0), a1(0), a2(0),
-                         x1(0), x2(0), y1(0), y2(0) {}
-
-        void reset() {
-            x1 = x2 = y1 = y2 = 0.0;
-        }
-
-        double process(double input) {
-            // Direct Form I: y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
-            double output = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-
-            // Update state
-            x2 = x1;
-            x1 = input;
-            y2 = y1;
-            y1 = output;
-
-            return output;
-        }
+    struct Formant {
+        double freq;
+        double q;
+        double gain;  // F3-F5 only; F1 and F2 follow f1f2Balance
+
+        // Settings the filter was last designed for (negative = never designed)
+        double designedFreq = -1.0;
+        double designedQ = -1.0;
     };
 
-    void updateF1Coefficients();
-    void updateF2Coefficients();
+    // Redesign filters whose settings moved past the threshold
+    void updateCoefficients();
+
+    // Design formant index's bandpass; false if it was close enough already
+    bool designFormant(int index, bool jump);
+
+    // Per-filter wet gains for the given balance
+    void wetGains(double balance, double *gains) const;
+
+    static constexpr int kChunkFrames = 64;
 
     double sampleRate;
-    double f1Freq;
-    double f2Freq;
-    double f1Q;
-    double f2Q;
     double directMix;
     double f1f2Balance;
 
-    BiquadFilter f1Filter;
-    BiquadFilter f2Filter;
+    Formant formants[kMaxFormants];
+    int numFormants;
+
+    BiquadBank filters;
+
+    bool coefficientsDirty;  // Settings changed since the last updateCoefficients()
+    bool primed;             // Processed audio since reset(); until then designs apply at once
+    int glideFrames;
+
+    static constexpr double kRedesignThreshold = 0.001;  // Relative change in frequency or Q
 };
 
 #endif // FORMANTBODY_H
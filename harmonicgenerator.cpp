@@ -1,6 +1,6 @@
     #include "harmonicgenerator.h"
+#include "noisegenerator.h"
 #include <algorithm>
-#include <QVector>
 
 HarmonicGenerator::HarmonicGenerator(double sampleRate)
     : sampleRate(sampleRate)
@@ -11,17 +11,36 @@ HarmonicGenerator::HarmonicGenerator(double sampleRate)
     , purity(0.0)  // Default: pure DNA preset, no blending
     , drift(0.0)   // Default: no drift
     , phase(0.0)
+    , oscillatorsDirty(true)
 {
-    harmonicPhases.resize(64, 0.0);
     harmonicAmplitudes.resize(64, 0.0);
     driftOffsets.resize(64, 0.0);
+    basePattern.resize(64, 0.0);
+
+    // Flat spectrum with gentle rolloff, the purity = 1.0 target
+    flatPattern.resize(64, 0.0);
+    for (int h = 0; h < 64; h++) {
+        flatPattern[h] = 1.0 / (h + 1);
+    }
+
     updateHarmonicAmplitudes();
 }
 
-void HarmonicGenerator::reset()
+void HarmonicGenerator::reset(uint64_t seed)
 {
     phase = 0.0;
-    std::fill(harmonicPhases.begin(), harmonicPhases.end(), 0.0);
+    oscillators.reset();
+
+    // Each note starts from its own drift offsets, drawn from the seed rather
+    // than carried over from whatever note this generator played before
+    std::fill(driftOffsets.begin(), driftOffsets.end(), 0.0);
+    if (drift > 0.0) {
+        NoiseGenerator random(seed);
+        for (int h = 0; h < numHarmonics; h++) {
+            driftOffsets[h] = random.next() * drift;
+            oscillators.shiftPhase(h, driftOffsets[h]);
+        }
+    }
 }
 
 void HarmonicGenerator::setNumHarmonics(int count)
@@ -54,8 +73,12 @@ void HarmonicGenerator::setDnaPreset(int preset)
 
 void HarmonicGenerator::setPurity(double p)
 {
-    purity = std::clamp(p, 0.0, 1.0);
-    updateHarmonicAmplitudes();  // Recalculate amplitudes with new purity
+    p = std::clamp(p, 0.0, 1.0);
+    if (p == purity) {
+        return;
+    }
+    purity = p;
+    applyPurity();  // Re-blend the cached patterns, no recomputation of the DNA
 }
 
 void HarmonicGenerator::setDrift(double d)
@@ -88,7 +111,7 @@ void HarmonicGenerator::setCustomAmplitudes(const std::vector<double> &amplitude
 void HarmonicGenerator::updateHarmonicAmplitudes()
 {
     // First, generate the base DNA pattern
-    QVector<double> basePattern(numHarmonics, 0.0);
+    std::fill(basePattern.begin(), basePattern.end(), 0.0);
     double totalAmp = 0.0;
 
     switch (dnaPreset) {
@@ -181,67 +204,78 @@ void HarmonicGenerator::updateHarmonicAmplitudes()
     }
 
     // Normalize base pattern
+    baseSum = 0.0;
     if (totalAmp > 0.0) {
         for (int h = 0; h < numHarmonics; h++) {
             basePattern[h] /= totalAmp;
         }
+        baseSum = 1.0;
+    }
+
+    // Sum of the flat pattern over the active harmonics (harmonic number H_n)
+    flatSum = 0.0;
+    for (int h = 0; h < numHarmonics; h++) {
+        flatSum += flatPattern[h];
     }
 
+    applyPurity();
+}
+
+void HarmonicGenerator::applyPurity()
+{
     // Apply purity blend: mix DNA pattern with flat spectrum
     // purity 0.0 = pure DNA pattern
     // purity 1.0 = all harmonics equal (flat with gentle rolloff)
-    totalAmp = 0.0;
+    // Both patterns' sums are known, so the final normalization is closed-form
+    double totalAmp = baseSum * (1.0 - purity) + flatSum * purity;
+    double scale = (totalAmp > 0.0) ? 1.0 / totalAmp : 1.0;
+    double baseWeight = (1.0 - purity) * scale;
+    double flatWeight = purity * scale;
+
     for (int h = 0; h < numHarmonics; h++) {
-        int harmonicNum = h + 1;
-        double dnaAmp = basePattern[h];
-        double flatAmp = 1.0 / harmonicNum;  // Flat spectrum with gentle rolloff
-        harmonicAmplitudes[h] = dnaAmp * (1.0 - purity) + flatAmp * purity;
-        totalAmp += harmonicAmplitudes[h];
+        harmonicAmplitudes[h] = basePattern[h] * baseWeight + flatPattern[h] * flatWeight;
     }
 
-    // Final normalization
-    if (totalAmp > 0.0) {
-        for (int h = 0; h < numHarmonics; h++) {
-            harmonicAmplitudes[h] /= totalAmp;
-        }
-    }
+    oscillatorsDirty = true;
 }
 
 double HarmonicGenerator::generateSample()
 {
-    // Generate harmonics using pre-calculated amplitudes (includes purity blend)
-    double voiceSample = 0.0;
-
-    for (int h = 0; h < numHarmonics; h++)
-    {
-        int harmonicNum = h + 1;
-
-        // Use pre-calculated amplitude (already normalized and purity-blended)
-        double amp = harmonicAmplitudes[h];
+    double sample;
+    generateBlock(&sample, 1);
+    return sample;
+}
 
-        // Calculate phase for this harmonic with drift
-        double harmonicPhase = phase * harmonicNum;
+void HarmonicGenerator::generateBlock(double *output, int numFrames)
+{
+    // Use pre-calculated amplitudes (already normalized and purity-blended)
+    if (oscillatorsDirty) {
+        oscillators.setNumOscillators(numHarmonics);
+        oscillators.setAmplitudes(harmonicAmplitudes.data(), numHarmonics);
+        oscillatorsDirty = false;
+    }
 
-        // Apply drift: slowly varying frequency offsets for organic sound
-        if (drift > 0.0) {
+    // Apply drift: slowly varying frequency offsets for organic sound.
+    // Offsets are updated once per block and applied as phase shifts
+    if (drift > 0.0) {
+        for (int h = 0; h < numHarmonics; h++) {
             // Update drift offset very slowly using low-frequency oscillation
-            driftOffsets[h] += drift * 0.0001 * std::sin(phase * 0.023 + h * 1.3);
+            double offset = driftOffsets[h]
+                            + numFrames * drift * 0.0001 * std::sin(phase * 0.023 + h * 1.3);
             // Clamp drift offset
-            driftOffsets[h] = std::clamp(driftOffsets[h], -drift, drift);
-            // Apply drift to phase
-            harmonicPhase += driftOffsets[h] * 2.0 * M_PI;
+            offset = std::clamp(offset, -drift, drift);
+            oscillators.shiftPhase(h, offset - driftOffsets[h]);
+            driftOffsets[h] = offset;
         }
-
-        // Generate sine wave
-        voiceSample += amp * std::sin(harmonicPhase);
     }
 
+    // Generate harmonics
+    oscillators.render(&fundamentalHz, 0, sampleRate, output, numFrames);
+
     // Advance phase
-    phase += 2.0 * M_PI * fundamentalHz / sampleRate;
+    phase += numFrames * 2.0 * M_PI * fundamentalHz / sampleRate;
 
     // Wrap phase to prevent overflow
     if (phase > 2.0 * M_PI * 1000.0)
         phase -= 2.0 * M_PI * 1000.0;
-
-    return voiceSample;
 }
@@ -1,7 +1,9 @@
 #ifndef HARMONICGENERATOR_H
 #define HARMONICGENERATOR_H
 
+#include "oscillatorbank.h"
 #include <cmath>
+#include <cstdint>
 #include <vector>
 
 /**
@@ -23,8 +25,13 @@ public:
     // Generate a single audio sample
     double generateSample();
 
-    // Reset phase (call when starting a new note)
-    void reset();
+    // Generate a block of samples at the current fundamental
+    void generateBlock(double *output, int numFrames);
+
+    // Reset phase (call when starting a new note). With drift on, each
+    // harmonic starts at a drift offset drawn from seed, so the same seed
+    // always starts the note the same way
+    void reset(uint64_t seed = 0);
 
     // Parameter setters
     void setNumHarmonics(int count);
@@ -59,14 +66,24 @@ private:
     double purity;  // 0.0-1.0, controls harmonic purity
     double drift;   // 0.0-0.1, controls frequency drift
 
-    double phase;  // Master phase accumulator
-    std::vector<double> harmonicPhases;  // Phase for each harmonic
+    double phase;  // Master phase accumulator (drives the drift LFO)
+    OscillatorBank oscillators;  // One oscillator per harmonic
+    bool oscillatorsDirty;  // harmonicAmplitudes changed since last pushed to the bank
     std::vector<double> harmonicAmplitudes;  // Cached amplitudes for each harmonic
     std::vector<double> driftOffsets;  // Random drift offsets for each harmonic
     std::vector<double> customDnaPattern;  // Stored custom DNA pattern (when dnaPreset == -1)
 
-    // Recalculate harmonic amplitudes based on DNA preset
+    // Purity blend inputs, cached per DNA/numHarmonics change
+    std::vector<double> basePattern;  // Normalized DNA pattern
+    std::vector<double> flatPattern;  // 1/n flat pattern (not normalized)
+    double baseSum = 0.0;  // Sum of basePattern (1, or 0 if the DNA is silent)
+    double flatSum = 0.0;  // Sum of flatPattern over numHarmonics
+
+    // Recalculate the base DNA pattern based on DNA preset, then re-blend
     void updateHarmonicAmplitudes();
+
+    // Blend the cached base and flat patterns by purity into harmonicAmplitudes
+    void applyPurity();
 };
 
 #endif // HARMONICGENERATOR_H
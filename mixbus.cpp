@@ -0,0 +1,104 @@
+#include "mixbus.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXBUS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+MixBus::MixBus(double sampleRate)
+    : limiter(sampleRate)
+    , masterGain(0.3)
+    , peakCeiling(0.98)
+    , lastReductionDb(0.0)
+{
+}
+
+void MixBus::setCeiling(double ceiling)
+{
+    peakCeiling = std::clamp(ceiling, 0.01, 1.0);
+}
+
+void MixBus::reset(size_t frames)
+{
+    mix.assign(frames * 2, 0.0f);
+}
+
+void MixBus::add(const float *input, size_t offset, size_t count, float gainLeft, float gainRight)
+{
+    size_t frames = mix.size() / 2;
+    if (offset >= frames) {
+        return;
+    }
+    count = std::min(count, frames - offset);
+
+    panInto(mix.data() + offset * 2, input, count, gainLeft, gainRight);
+}
+
+void MixBus::addStereo(const float *input, size_t offset, size_t count)
+{
+    size_t frames = mix.size() / 2;
+    if (offset >= frames) {
+        return;
+    }
+    count = std::min(count, frames - offset);
+
+    accumulate(mix.data() + offset * 2, input, count * 2);
+}
+
+void MixBus::finish(std::vector<float> &output)
+{
+    // Run the mix through a fresh limiter, then flush its lookahead with silence
+    size_t frames = mix.size() / 2;
+    size_t latency = limiter.getLatency();
+    startStream();
+    mix.resize((frames + latency) * 2, 0.0f);
+    limiter.process(mix.data(), mix.data(), frames + latency);
+    mix.erase(mix.begin(), mix.begin() + latency * 2);
+    lastReductionDb = limiter.getReductionDb();
+
+    output.swap(mix);
+    mix.clear();
+}
+
+void MixBus::startStream()
+{
+    limiter.setGain(masterGain);
+    limiter.setCeiling(peakCeiling);
+    limiter.reset();
+}
+
+void MixBus::panInto(float *out, const float *in, size_t frames, float gainLeft, float gainRight)
+{
+    size_t i = 0;
+#ifdef MIXBUS_SSE2
+    // Four mono samples become two registers of L/R pairs
+    const __m128 gains = _mm_setr_ps(gainLeft, gainRight, gainLeft, gainRight);
+    for (; i + 4 <= frames; i += 4) {
+        __m128 mono = _mm_loadu_ps(in + i);
+        __m128 low = _mm_unpacklo_ps(mono, mono);   // a a b b
+        __m128 high = _mm_unpackhi_ps(mono, mono);  // c c d d
+        float *dst = out + i * 2;
+        _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(low, gains)));
+        _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_mul_ps(high, gains)));
+    }
+#endif
+    for (; i < frames; i++) {
+        out[i * 2] += in[i] * gainLeft;
+        out[i * 2 + 1] += in[i] * gainRight;
+    }
+}
+
+void MixBus::accumulate(float *out, const float *in, size_t count)
+{
+    size_t i = 0;
+#ifdef MIXBUS_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] += in[i];
+    }
+}
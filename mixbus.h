@@ -0,0 +1,80 @@
+#ifndef MIXBUS_H
+#define MIXBUS_H
+
+#include "peaklimiter.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * MixBus - Sums voices into one stereo buffer with headroom management
+ *
+ * The mix is interleaved left/right frames, the layout RtAudio plays, so
+ * a finished mix can be copied straight to the device. Mono voices are
+ * panned in with a gain per channel (see TrackMix).
+ *
+ * Voices are added unclipped and in a fixed order, so the mix is
+ * deterministic. The master gain and headroom go through a PeakLimiter:
+ * where the mix would peak over the ceiling it gets quieter just ahead of
+ * the peak instead of hard-clipping sample by sample. finish() limits a
+ * whole mix; a stream is limited block by block with startStream() and
+ * limitBlock(), and comes out identical to finish() on the same mix.
+ */
+class MixBus
+{
+public:
+    MixBus(double sampleRate = 44100.0);
+
+    // Sizes the limiter's lookahead (allocates)
+    void setSampleRate(double sampleRate) { limiter.setSampleRate(sampleRate); }
+
+    // Master gain applied to the sum (default 0.3, the old per-note gain)
+    void setGain(double gain) { masterGain = gain; }
+    double getGain() const { return masterGain; }
+
+    // Highest allowed peak after the master gain (default 0.98)
+    void setCeiling(double ceiling);
+    double getCeiling() const { return peakCeiling; }
+
+    // Start a new mix of frames stereo frames of silence
+    void reset(size_t frames);
+
+    // Pan count frames of a mono voice in, starting at frame offset (clipped to the mix length)
+    void add(const float *input, size_t offset, size_t count, float gainLeft = 1.0f, float gainRight = 1.0f);
+
+    // Add count interleaved stereo frames, starting at frame offset (clipped to the mix length)
+    void addStereo(const float *input, size_t offset, size_t count);
+
+    // Apply gain and headroom, and move the interleaved mix into output (the bus is left empty)
+    void finish(std::vector<float> &output);
+
+    // Streaming: start a new stream with the current gain and ceiling (no allocation)
+    void startStream();
+
+    // Streaming: apply gain and headroom to frames interleaved stereo frames in
+    // place. The output lags the input by getLatency() frames across calls
+    void limitBlock(float *samples, size_t frames) { limiter.process(samples, samples, frames); }
+
+    // Frames the streamed output lags behind the input
+    size_t getLatency() const { return limiter.getLatency(); }
+
+    // Frames of mix a stream must be fed before a point to match finish() from there on
+    size_t getSettleFrames() const { return limiter.getSettleFrames(); }
+
+    // Gain reduction applied by the last finish(), in dB (0 = none)
+    double getLastReductionDb() const { return lastReductionDb; }
+
+    // out[2i] += in[i] * gainLeft, out[2i + 1] += in[i] * gainRight (SIMD where available)
+    static void panInto(float *out, const float *in, size_t frames, float gainLeft, float gainRight);
+
+    // out[i] += in[i] (SIMD where available)
+    static void accumulate(float *out, const float *in, size_t count);
+
+private:
+    std::vector<float> mix;  // Interleaved stereo
+    PeakLimiter limiter;
+    double masterGain;
+    double peakCeiling;
+    double lastReductionDb;
+};
+
+#endif // MIXBUS_H
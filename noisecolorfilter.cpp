@@ -1,6 +1,5 @@
 #include "noisecolorfilter.h"
 #include <algorithm>
-#include <chrono>
 
 NoiseColorFilter::NoiseColorFilter(double sampleRate)
     : sampleRate(sampleRate)
@@ -9,24 +8,17 @@ NoiseColorFilter::NoiseColorFilter(double sampleRate)
     , filterType(FilterType::Highpass)
     , noiseType(NoiseType::White)
     , useInternal(true)
-    , dist(-1.0, 1.0)
-    , pinkB0(0.0), pinkB1(0.0), pinkB2(0.0), pinkB3(0.0), pinkB4(0.0), pinkB5(0.0), pinkB6(0.0)
-    , brownLast(0.0)
+    , filter(1)
+    , noise(0)
 {
-    // Initialize random number generator with time-based seed
-    auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    rng.seed(static_cast<unsigned int>(seed));
-
     updateFilterCoefficients();
 }
 
 void NoiseColorFilter::reset()
 {
     filter.reset();
-    // Reset pink noise state
-    pinkB0 = pinkB1 = pinkB2 = pinkB3 = pinkB4 = pinkB5 = pinkB6 = 0.0;
-    // Reset brown noise state
-    brownLast = 0.0;
+    // Reset pink and brown noise state
+    noise.resetShaping();
 }
 
 void NoiseColorFilter::setColor(double freq)
@@ -63,6 +55,11 @@ void NoiseColorFilter::setSampleRate(double rate)
     updateFilterCoefficients();
 }
 
+void NoiseColorFilter::setSeed(uint64_t seed)
+{
+    noise.seed(seed);
+}
+
 void NoiseColorFilter::updateFilterCoefficients()
 {
     // Biquad filter coefficients
@@ -73,97 +70,82 @@ void NoiseColorFilter::updateFilterCoefficients()
     double cosOmega = std::cos(omega);
     double alpha = sinOmega / (2.0 * filterQ);
 
-    double a0;
+    double a0 = 1.0 + alpha;
 
     switch (filterType) {
         case FilterType::Lowpass:
             // Lowpass filter
-            a0 = 1.0 + alpha;
-            filter.b0 = ((1.0 - cosOmega) / 2.0) / a0;
-            filter.b1 = (1.0 - cosOmega) / a0;
-            filter.b2 = ((1.0 - cosOmega) / 2.0) / a0;
-            filter.a1 = (-2.0 * cosOmega) / a0;
-            filter.a2 = (1.0 - alpha) / a0;
+            filter.setCoefficients(0,
+                                   ((1.0 - cosOmega) / 2.0) / a0,
+                                   (1.0 - cosOmega) / a0,
+                                   ((1.0 - cosOmega) / 2.0) / a0,
+                                   (-2.0 * cosOmega) / a0,
+                                   (1.0 - alpha) / a0);
             break;
 
         case FilterType::Highpass:
             // Highpass filter
-            a0 = 1.0 + alpha;
-            filter.b0 = ((1.0 + cosOmega) / 2.0) / a0;
-            filter.b1 = -(1.0 + cosOmega) / a0;
-            filter.b2 = ((1.0 + cosOmega) / 2.0) / a0;
-            filter.a1 = (-2.0 * cosOmega) / a0;
-            filter.a2 = (1.0 - alpha) / a0;
+            filter.setCoefficients(0,
+                                   ((1.0 + cosOmega) / 2.0) / a0,
+                                   -(1.0 + cosOmega) / a0,
+                                   ((1.0 + cosOmega) / 2.0) / a0,
+                                   (-2.0 * cosOmega) / a0,
+                                   (1.0 - alpha) / a0);
             break;
 
         case FilterType::Bandpass:
             // Bandpass filter (constant 0 dB peak gain)
-            a0 = 1.0 + alpha;
-            filter.b0 = alpha / a0;
-            filter.b1 = 0.0;
-            filter.b2 = -alpha / a0;
-            filter.a1 = -2.0 * cosOmega / a0;
-            filter.a2 = (1.0 - alpha) / a0;
+            filter.setCoefficients(0,
+                                   alpha / a0,
+                                   0.0,
+                                   -alpha / a0,
+                                   -2.0 * cosOmega / a0,
+                                   (1.0 - alpha) / a0);
             break;
     }
 }
 
-double NoiseColorFilter::generateWhiteNoise()
-{
-    return dist(rng);
-}
-
-double NoiseColorFilter::generatePinkNoise()
+void NoiseColorFilter::generateNoise(double *output, int numFrames)
 {
-    // Paul Kellet's implementation of pink noise
-    // http://www.firstpr.com.au/dsp/pink-noise/
-    double white = generateWhiteNoise();
-
-    pinkB0 = 0.99886 * pinkB0 + white * 0.0555179;
-    pinkB1 = 0.99332 * pinkB1 + white * 0.0750759;
-    pinkB2 = 0.96900 * pinkB2 + white * 0.1538520;
-    pinkB3 = 0.86650 * pinkB3 + white * 0.3104856;
-    pinkB4 = 0.55000 * pinkB4 + white * 0.5329522;
-    pinkB5 = -0.7616 * pinkB5 - white * 0.0168980;
-
-    double pink = pinkB0 + pinkB1 + pinkB2 + pinkB3 + pinkB4 + pinkB5 + pinkB6 + white * 0.5362;
-    pinkB6 = white * 0.115926;
-
-    return pink * 0.11; // Scale to approximately [-1, 1]
-}
-
-double NoiseColorFilter::generateBrownNoise()
-{
-    // Brownian noise (random walk)
-    double white = generateWhiteNoise();
-    brownLast = (brownLast + (0.02 * white)) / 1.02;
-
-    return brownLast * 3.5; // Scale to approximately [-1, 1]
-}
-
-double NoiseColorFilter::generateSample()
-{
-    // Generate internal noise based on selected type
-    double noise;
+    // Internal noise based on selected type
     switch (noiseType) {
         case NoiseType::Pink:
-            noise = generatePinkNoise();
+            noise.fillPink(output, numFrames);
             break;
         case NoiseType::Brown:
-            noise = generateBrownNoise();
+            noise.fillBrown(output, numFrames);
             break;
         case NoiseType::White:
         default:
-            noise = generateWhiteNoise();
+            noise.fillWhite(output, numFrames);
             break;
     }
+}
 
-    // Filter the noise
-    return filter.process(noise);
+double NoiseColorFilter::generateSample()
+{
+    double output;
+    generateBlock(&output, 1);
+    return output;
 }
 
 double NoiseColorFilter::processSample(double noiseIn)
 {
     // Process external noise input
-    return filter.process(noiseIn);
+    double output;
+    processBlock(&noiseIn, &output, 1);
+    return output;
+}
+
+void NoiseColorFilter::generateBlock(double *output, int numFrames)
+{
+    // Fill the block with raw noise first, then filter it in one pass
+    generateNoise(output, numFrames);
+    processBlock(output, output, numFrames);
+}
+
+void NoiseColorFilter::processBlock(const double *noiseIn, double *output, int numFrames)
+{
+    const double gain = 1.0;
+    filter.process(noiseIn, output, numFrames, &gain);
 }
@@ -1,8 +1,10 @@
 #ifndef NOISECOLORFILTER_H
 #define NOISECOLORFILTER_H
 
+#include "biquadbank.h"
+#include "noisegenerator.h"
 #include <cmath>
-#include <random>
+#include <cstdint>
 
 /**
  * NoiseColorFilter - Shapes noise spectrum for breath effects
@@ -15,6 +17,9 @@
  * - filterQ: Filter resonance (1.0-20.0)
  * - filterType: lowpass, highpass, or bandpass
  *
+ * The internal noise comes from a NoiseGenerator with seed 0 until
+ * setSeed(); SounitGraph seeds it per note, so renders are reproducible.
+ *
  * Processing:
  * - Low color (100 Hz) = dark, breathy rumble
  * - Mid (2000 Hz) = 'SH' territory
@@ -43,6 +48,10 @@ public:
     // Process external noise input (when not using internal generator)
     double processSample(double noiseIn);
 
+    // Block versions of generateSample() and processSample()
+    void generateBlock(double *output, int numFrames);
+    void processBlock(const double *noiseIn, double *output, int numFrames);
+
     // Reset filter state
     void reset();
 
@@ -54,6 +63,9 @@ public:
     void setUseInternal(bool useInternal);
     void setSampleRate(double rate);
 
+    // Restart the internal noise from a fixed seed
+    void setSeed(uint64_t seed);
+
     // Parameter getters
     double getColor() const { return color; }
     double getFilterQ() const { return filterQ; }
@@ -62,41 +74,8 @@ public:
     bool getUseInternal() const { return useInternal; }
 
 private:
-    // Biquad filter for noise shaping
-    struct BiquadFilter {
-        // Filter coefficients
-        double b0, b1, b2;  // Numerator
-        double a1, a2;      // Denominator (a0 is normalized to 1)
-
-        // Filter state (delayed samples)
-        double x1, x2;  // Input history
-        double y1, y2;  // Output history
-
-        BiquadFilter() : b0(1), b1(0), b2(0), a1(0), a2(0),
-                         x1(0), x2(0), y1(0), y2(0) {}
-
-        void reset() {
-            x1 = x2 = y1 = y2 = 0.0;
-        }
-
-        double process(double input) {
-            // Direct Form I: y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
-            double output = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-
-            // Update state
-            x2 = x1;
-            x1 = input;
-            y2 = y1;
-            y1 = output;
-
-            return output;
-        }
-    };
-
     void updateFilterCoefficients();
-    double generateWhiteNoise();
-    double generatePinkNoise();
-    double generateBrownNoise();
+    void generateNoise(double *output, int numFrames);
 
     double sampleRate;
     double color;
@@ -105,17 +84,9 @@ private:
     NoiseType noiseType;
     bool useInternal;
 
-    BiquadFilter filter;
-
-    // White noise generator
-    std::mt19937 rng;
-    std::uniform_real_distribution<double> dist;
-
-    // Pink noise state (Paul Kellet's implementation)
-    double pinkB0, pinkB1, pinkB2, pinkB3, pinkB4, pinkB5, pinkB6;
+    BiquadBank filter;  // A single lane of the shared biquad kernel
 
-    // Brown noise state
-    double brownLast;
+    NoiseGenerator noise;  // White noise with pink and brown shaping
 };
 
 #endif // NOISECOLORFILTER_H
@@ -0,0 +1,231 @@
+#include "noisegenerator.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISEGENERATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Paul Kellet's pink noise filter, http://www.firstpr.com.au/dsp/pink-noise/
+alignas(16) constexpr double kPinkFeedback[6] = {0.99886, 0.99332, 0.96900, 0.86650, 0.55000, -0.7616};
+alignas(16) constexpr double kPinkInput[6] = {0.0555179, 0.0750759, 0.1538520, 0.3104856, 0.5329522, -0.0168980};
+constexpr double kPinkDirect = 0.5362;
+constexpr double kPinkTap = 0.115926;
+constexpr double kPinkScale = 0.11;  // Scale to approximately [-1, 1]
+
+// Brown noise: brownLast = (brownLast + 0.02 * white) / 1.02
+constexpr double kBrownLeak = 1.0 / 1.02;
+constexpr double kBrownInput = 0.02 / 1.02;
+constexpr double kBrownScale = 3.5;  // Scale to approximately [-1, 1]
+
+// Top 52 bits of x as the mantissa of a double in [1, 2), mapped to [-1, 1)
+inline double toUniform(uint64_t x)
+{
+    uint64_t bits = (x >> 12) | 0x3FF0000000000000ULL;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value * 2.0 - 3.0;
+}
+
+inline uint64_t rotateLeft(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+// SplitMix64, to spread one seed over all stream state
+uint64_t splitMix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+NoiseGenerator::NoiseGenerator(uint64_t seed)
+{
+    this->seed(seed);
+}
+
+void NoiseGenerator::seed(uint64_t seed)
+{
+    uint64_t mix = seed;
+    for (int word = 0; word < 4; word++) {
+        for (int stream = 0; stream < kStreams; stream++) {
+            state[word][stream] = splitMix64(mix);
+        }
+    }
+    pendingIndex = kStreams;
+    resetShaping();
+}
+
+void NoiseGenerator::resetShaping()
+{
+    for (double &pole : pinkPoles) {
+        pole = 0.0;
+    }
+    pinkTap = 0.0;
+    brownLast = 0.0;
+}
+
+void NoiseGenerator::generate(double *output, int numGroups)
+{
+    int g = 0;
+#ifdef NOISEGENERATOR_SSE2
+    // Streams 0-1 in the low registers, 2-3 in the high ones
+    __m128i s0Low = _mm_load_si128(reinterpret_cast<const __m128i *>(state[0]));
+    __m128i s0High = _mm_load_si128(reinterpret_cast<const __m128i *>(state[0] + 2));
+    __m128i s1Low = _mm_load_si128(reinterpret_cast<const __m128i *>(state[1]));
+    __m128i s1High = _mm_load_si128(reinterpret_cast<const __m128i *>(state[1] + 2));
+    __m128i s2Low = _mm_load_si128(reinterpret_cast<const __m128i *>(state[2]));
+    __m128i s2High = _mm_load_si128(reinterpret_cast<const __m128i *>(state[2] + 2));
+    __m128i s3Low = _mm_load_si128(reinterpret_cast<const __m128i *>(state[3]));
+    __m128i s3High = _mm_load_si128(reinterpret_cast<const __m128i *>(state[3] + 2));
+
+    const __m128i exponent = _mm_set1_epi64x(0x3FF0000000000000LL);
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d three = _mm_set1_pd(3.0);
+
+    auto step = [&](__m128i &s0, __m128i &s1, __m128i &s2, __m128i &s3) {
+        __m128i result = _mm_add_epi64(s0, s3);
+        __m128i t = _mm_slli_epi64(s1, 17);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi64(s3, 45), _mm_srli_epi64(s3, 19));
+
+        __m128d unit = _mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(result, 12), exponent));
+        return _mm_sub_pd(_mm_mul_pd(unit, two), three);
+    };
+
+    for (; g < numGroups; g++) {
+        _mm_storeu_pd(output + g * kStreams, step(s0Low, s1Low, s2Low, s3Low));
+        _mm_storeu_pd(output + g * kStreams + 2, step(s0High, s1High, s2High, s3High));
+    }
+
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[0]), s0Low);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[0] + 2), s0High);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[1]), s1Low);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[1] + 2), s1High);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[2]), s2Low);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[2] + 2), s2High);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[3]), s3Low);
+    _mm_store_si128(reinterpret_cast<__m128i *>(state[3] + 2), s3High);
+#endif
+    for (; g < numGroups; g++) {
+        for (int stream = 0; stream < kStreams; stream++) {
+            uint64_t &s0 = state[0][stream];
+            uint64_t &s1 = state[1][stream];
+            uint64_t &s2 = state[2][stream];
+            uint64_t &s3 = state[3][stream];
+
+            // xoshiro256+ (Blackman & Vigna)
+            uint64_t result = s0 + s3;
+            uint64_t t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = rotateLeft(s3, 45);
+
+            output[g * kStreams + stream] = toUniform(result);
+        }
+    }
+}
+
+double NoiseGenerator::next()
+{
+    if (pendingIndex == kStreams) {
+        generate(pending, 1);
+        pendingIndex = 0;
+    }
+    return pending[pendingIndex++];
+}
+
+void NoiseGenerator::fillWhite(double *output, int numFrames)
+{
+    // Hand out leftovers first so the sequence doesn't depend on block sizes
+    int i = 0;
+    while (i < numFrames && pendingIndex < kStreams) {
+        output[i++] = pending[pendingIndex++];
+    }
+
+    int groups = (numFrames - i) / kStreams;
+    generate(output + i, groups);
+    i += groups * kStreams;
+
+    while (i < numFrames) {
+        output[i++] = next();
+    }
+}
+
+void NoiseGenerator::fillPink(double *output, int numFrames)
+{
+    fillWhite(output, numFrames);
+
+    int i = 0;
+#ifdef NOISEGENERATOR_SSE2
+    // The six poles are independent one-pole filters: three registers of two
+    __m128d pole01 = _mm_load_pd(pinkPoles);
+    __m128d pole23 = _mm_load_pd(pinkPoles + 2);
+    __m128d pole45 = _mm_load_pd(pinkPoles + 4);
+    const __m128d feedback01 = _mm_load_pd(kPinkFeedback);
+    const __m128d feedback23 = _mm_load_pd(kPinkFeedback + 2);
+    const __m128d feedback45 = _mm_load_pd(kPinkFeedback + 4);
+    const __m128d input01 = _mm_load_pd(kPinkInput);
+    const __m128d input23 = _mm_load_pd(kPinkInput + 2);
+    const __m128d input45 = _mm_load_pd(kPinkInput + 4);
+
+    for (; i < numFrames; i++) {
+        const double white = output[i];
+        const __m128d w = _mm_set1_pd(white);
+        pole01 = _mm_add_pd(_mm_mul_pd(feedback01, pole01), _mm_mul_pd(input01, w));
+        pole23 = _mm_add_pd(_mm_mul_pd(feedback23, pole23), _mm_mul_pd(input23, w));
+        pole45 = _mm_add_pd(_mm_mul_pd(feedback45, pole45), _mm_mul_pd(input45, w));
+
+        __m128d sum = _mm_add_pd(_mm_add_pd(pole01, pole23), pole45);
+        sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+        double pink = _mm_cvtsd_f64(sum) + pinkTap + white * kPinkDirect;
+        pinkTap = white * kPinkTap;
+
+        output[i] = pink * kPinkScale;
+    }
+
+    _mm_store_pd(pinkPoles, pole01);
+    _mm_store_pd(pinkPoles + 2, pole23);
+    _mm_store_pd(pinkPoles + 4, pole45);
+#endif
+    for (; i < numFrames; i++) {
+        const double white = output[i];
+        for (int k = 0; k < 6; k++) {
+            pinkPoles[k] = kPinkFeedback[k] * pinkPoles[k] + kPinkInput[k] * white;
+        }
+
+        // Same summation order as the SSE2 path, so seeded output matches
+        double even = (pinkPoles[0] + pinkPoles[2]) + pinkPoles[4];
+        double odd = (pinkPoles[1] + pinkPoles[3]) + pinkPoles[5];
+        double pink = (even + odd) + pinkTap + white * kPinkDirect;
+        pinkTap = white * kPinkTap;
+
+        output[i] = pink * kPinkScale;
+    }
+}
+
+void NoiseGenerator::fillBrown(double *output, int numFrames)
+{
+    fillWhite(output, numFrames);
+
+    // Random walk with a leak; the division is folded into the constants
+    double last = brownLast;
+    for (int i = 0; i < numFrames; i++) {
+        last = last * kBrownLeak + output[i] * kBrownInput;
+        output[i] = last * kBrownScale;
+    }
+    brownLast = last;
+}
@@ -0,0 +1,63 @@
+#ifndef NOISEGENERATOR_H
+#define NOISEGENERATOR_H
+
+#include <cstdint>
+
+/**
+ * NoiseGenerator - Seedable block generator of white, pink and brown noise
+ *
+ * Shared noise source for the graph's noise nodes. Four interleaved
+ * xoshiro256+ streams step side by side in SIMD registers (SSE2, scalar
+ * fallback) and each 64-bit result becomes a uniform double in [-1, 1)
+ * by bit manipulation rather than a division, so a block of white noise
+ * costs a few instructions per sample.
+ *
+ * Output depends only on the seed and the number of samples drawn, not
+ * on how they are split into blocks, so a seeded render is reproducible
+ * whatever block size the engine uses.
+ *
+ * Pink noise is Paul Kellet's filter with its six poles side by side in
+ * registers; brown noise is a leaky integrator.
+ */
+class NoiseGenerator
+{
+public:
+    explicit NoiseGenerator(uint64_t seed = 0);
+
+    // Restart every stream from seed, and clear the pink/brown state
+    void seed(uint64_t seed);
+
+    // Clear the pink and brown filter state (the streams carry on)
+    void resetShaping();
+
+    // One uniform sample in [-1, 1)
+    double next();
+
+    // Blocks of uniform white noise in [-1, 1), pink and brown noise
+    // scaled to approximately [-1, 1)
+    void fillWhite(double *output, int numFrames);
+    void fillPink(double *output, int numFrames);
+    void fillBrown(double *output, int numFrames);
+
+private:
+    static constexpr int kStreams = 4;
+
+    // Write numGroups * kStreams samples, one from each stream in turn
+    void generate(double *output, int numGroups);
+
+    // xoshiro256+ state, word-major: state[word][stream]
+    alignas(16) uint64_t state[4][kStreams];
+
+    // Samples generated but not handed out yet
+    double pending[kStreams];
+    int pendingIndex;
+
+    // Pink noise state (six poles in lane order, plus the one-sample tap)
+    alignas(16) double pinkPoles[6];
+    double pinkTap;
+
+    // Brown noise state
+    double brownLast;
+};
+
+#endif // NOISEGENERATOR_H
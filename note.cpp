@@ -1,4 +1,6 @@
 #include "note.h"
+#include "contenthash.h"
+#include <QJsonArray>
 
 Note::Note()
     : id(QUuid::createUuid().toString())
@@ -9,6 +11,7 @@ Note::Note()
     , dynamicsCurve(0.5)  // Default medium dynamics (constant curve)
     , bottomCurve(0.6)    // Default bottom curve value (spectrum placeholder)
 {
+    updateFieldsHash();
 }
 
 Note::Note(double startTime, double duration, double pitchHz, double dynamics)
@@ -20,6 +23,7 @@ Note::Note(double startTime, double duration, double pitchHz, double dynamics)
     , dynamicsCurve(dynamics)  // Create constant dynamics curve
     , bottomCurve(0.6)         // Default bottom curve value
 {
+    updateFieldsHash();
 }
 
 double Note::getDynamics() const
@@ -65,3 +69,74 @@ double Note::getBottomCurveAt(double normalizedTime) const
 {
     return bottomCurve.valueAt(normalizedTime);
 }
+
+uint64_t Note::contentHash() const
+{
+    uint64_t hash = ContentHash::combine(fieldsHash, pitchCurve.contentHash());
+    hash = ContentHash::combine(hash, dynamicsCurve.contentHash());
+    return ContentHash::combine(hash, bottomCurve.contentHash());
+}
+
+void Note::updateFieldsHash()
+{
+    fieldsHash = ContentHash::combine(uint64_t(0), startTime);
+    fieldsHash = ContentHash::combine(fieldsHash, duration);
+    fieldsHash = ContentHash::combine(fieldsHash, pitchHz);
+    fieldsHash = ContentHash::combine(fieldsHash, trackIndex);
+}
+
+static QJsonArray curveToJson(const Curve &curve)
+{
+    QJsonArray points;
+    for (const Curve::Point &pt : curve.getPoints()) {
+        QJsonObject pointObj;
+        pointObj["time"] = pt.time;
+        pointObj["value"] = pt.value;
+        pointObj["pressure"] = pt.pressure;
+        points.append(pointObj);
+    }
+    return points;
+}
+
+static void curveFromJson(const QJsonValue &value, Curve &curve)
+{
+    // Absent = keep the default curve
+    if (!value.isArray()) {
+        return;
+    }
+    curve.clearPoints();
+    for (const QJsonValue &val : value.toArray()) {
+        QJsonObject pointObj = val.toObject();
+        curve.addPoint(
+            pointObj["time"].toDouble(),
+            pointObj["value"].toDouble(),
+            pointObj["pressure"].toDouble(1.0)
+        );
+    }
+}
+
+QJsonObject Note::toJson() const
+{
+    QJsonObject json;
+    json["startTime"] = startTime;
+    json["duration"] = duration;
+    json["pitchHz"] = pitchHz;
+    json["trackIndex"] = trackIndex;
+    json["pitchCurve"] = curveToJson(pitchCurve);
+    json["dynamicsCurve"] = curveToJson(dynamicsCurve);
+    json["bottomCurve"] = curveToJson(bottomCurve);
+    return json;
+}
+
+Note Note::fromJson(const QJsonObject &json)
+{
+    Note note(json["startTime"].toDouble(),
+              json["duration"].toDouble(1000.0),
+              json["pitchHz"].toDouble(440.0),
+              json["dynamics"].toDouble(0.5));  // Constant dynamics, if no curve is given
+    note.setTrackIndex(json["trackIndex"].toInt(0));
+    curveFromJson(json["pitchCurve"], note.pitchCurve);
+    curveFromJson(json["dynamicsCurve"], note.dynamicsCurve);
+    curveFromJson(json["bottomCurve"], note.bottomCurve);
+    return note;
+}
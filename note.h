@@ -2,13 +2,20 @@
 #define NOTE_H
 
 #include "curve.h"
+#include <QJsonObject>
 #include <QString>
 #include <QUuid>
+#include <cstdint>
 
 /**
  * Note - The compositional atom
  *
  * What you see on the score canvas. Stores parameter curves captured from pen input.
+ *
+ * contentHash() identifies everything that affects how the note sounds
+ * (timing, pitch, track and all three curves) but not its id. The hash of
+ * the scalar fields is updated by their setters and each curve keeps its
+ * own, so it's O(1) to query and safe to call from several threads.
  */
 class Note
 {
@@ -24,6 +31,9 @@ public:
     double getEndTime() const { return startTime + duration; }
     int getTrackIndex() const { return trackIndex; }
 
+    // Hash of the note's content, for render cache invalidation
+    uint64_t contentHash() const;
+
     // Pitch - supports both simple value and curve (for glissando/portamento)
     double getPitchAt(double normalizedTime) const;  // Query pitch curve at specific time
     const Curve& getPitchCurve() const { return pitchCurve; }
@@ -42,16 +52,22 @@ public:
     Curve& getBottomCurve() { return bottomCurve; }
 
     // Setters
-    void setStartTime(double time) { startTime = time; }
-    void setDuration(double dur) { duration = dur; }
-    void setPitchHz(double pitch) { pitchHz = pitch; }
+    void setStartTime(double time) { startTime = time; updateFieldsHash(); }
+    void setDuration(double dur) { duration = dur; updateFieldsHash(); }
+    void setPitchHz(double pitch) { pitchHz = pitch; updateFieldsHash(); }
     void setDynamics(double dyn);  // Sets constant dynamics
     void setDynamicsCurve(const Curve &curve) { dynamicsCurve = curve; }
     void setBottomCurve(const Curve &curve) { bottomCurve = curve; }
     void setPitchCurve(const Curve &curve) { pitchCurve = curve; }
-    void setTrackIndex(int index) { trackIndex = index; }
+    void setTrackIndex(int index) { trackIndex = index; updateFieldsHash(); }
+
+    // Serialization (the id is not stored; a loaded note gets a new one)
+    QJsonObject toJson() const;
+    static Note fromJson(const QJsonObject &json);
 
 private:
+    void updateFieldsHash();
+
     QString id;           // Unique identifier
     double startTime;     // Start time in milliseconds
     double duration;      // Duration in milliseconds
@@ -60,6 +76,7 @@ private:
     Curve pitchCurve;     // Pitch curve over time (Hz values for glissando/portamento)
     Curve dynamicsCurve;  // Dynamics curve over time (0.0-1.0)
     Curve bottomCurve;    // Bottom edge curve (spectrum/timbre placeholder, configurable later)
+    uint64_t fieldsHash;  // Hash of startTime, duration, pitchHz and trackIndex
 };
 
 #endif // NOTE_H
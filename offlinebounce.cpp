@@ -0,0 +1,82 @@
+#include "offlinebounce.h"
+#include "renderstream.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+OfflineBounce::OfflineBounce(std::unique_ptr<OfflineRenderer> renderer, double sampleRate)
+    : renderer(std::move(renderer))
+    , sampleRate(sampleRate)
+    , format(WavWriter::Format::Pcm24)
+    , cancelled(false)
+    , framesWritten(0)
+{
+}
+
+bool OfflineBounce::run(const QVector<Note> &notes, int count, const QString &path)
+{
+    cancelled = false;
+    errorString.clear();
+    framesWritten = 0;
+
+    if (!renderer) {
+        errorString = "Renderer already used";
+        return false;
+    }
+
+    WavWriter writer;
+    if (!writer.open(path, static_cast<int>(sampleRate), 2, format)) {
+        errorString = writer.getErrorString();
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    RenderStream stream(std::move(renderer), notes, count, sampleRate, kRenderAheadMs);
+    size_t totalFrames = stream.getTotalSamples();
+    stream.start();
+
+    std::vector<float> chunk(kChunkFrames * 2);
+    bool ok = true;
+    while (!stream.isFinished()) {
+        size_t available = stream.framesAvailable();
+        if (available == 0) {
+            // The producer is still rendering the next block
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        size_t frames = stream.read(chunk.data(), std::min(available, kChunkFrames));
+        if (!writer.write(chunk.data(), frames)) {
+            errorString = writer.getErrorString();
+            ok = false;
+            break;
+        }
+        framesWritten += frames;
+
+        if (progressCallback && !progressCallback(totalFrames ? static_cast<double>(framesWritten) / totalFrames : 1.0)) {
+            cancelled = true;
+            errorString = "Cancelled";
+            ok = false;
+            break;
+        }
+    }
+    stream.stop();
+
+    if (!ok) {
+        writer.abort();
+        return false;
+    }
+    if (!writer.close()) {
+        errorString = writer.getErrorString();
+        writer.abort();
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "OfflineBounce: Wrote " << framesWritten << " frames ("
+              << (framesWritten / sampleRate) << " s of audio) in " << seconds << " s to "
+              << path.toStdString() << std::endl;
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef OFFLINEBOUNCE_H
+#define OFFLINEBOUNCE_H
+
+#include "offlinerenderer.h"
+#include "wavwriter.h"
+#include "note.h"
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+/**
+ * OfflineBounce - Renders notes straight to a WAV file, no audio device needed
+ *
+ * Runs the streaming render pipeline (a RenderStream) as fast as the
+ * workers allow and writes each chunk to disk as soon as it's mixed, so
+ * memory stays at the render-ahead window however long the piece is.
+ * The mix goes through the same mix bus limiter as the cached render,
+ * so the file (PCM or float) matches what the editor plays, with no
+ * sample clipped.
+ *
+ * The progress callback is called on the calling thread after every
+ * chunk with the fraction done (0..1); returning false cancels the
+ * bounce and deletes the partial file.
+ */
+class OfflineBounce
+{
+public:
+    using ProgressCallback = std::function<bool(double fraction)>;
+
+    // renderer must already be prepared (see OfflineRenderer::prepare)
+    OfflineBounce(std::unique_ptr<OfflineRenderer> renderer, double sampleRate);
+
+    void setFormat(WavWriter::Format format) { this->format = format; }
+    void setProgressCallback(const ProgressCallback &callback) { progressCallback = callback; }
+
+    // Render the first count notes to path; false on error or cancel
+    bool run(const QVector<Note> &notes, int count, const QString &path);
+
+    bool wasCancelled() const { return cancelled; }
+    QString getErrorString() const { return errorString; }
+    uint64_t getFramesWritten() const { return framesWritten; }
+
+private:
+    std::unique_ptr<OfflineRenderer> renderer;
+    double sampleRate;
+    WavWriter::Format format;
+    ProgressCallback progressCallback;
+    bool cancelled;
+    QString errorString;
+    uint64_t framesWritten;
+
+    static constexpr double kRenderAheadMs = 2000.0;  // Ring between the renderer and the file
+    static constexpr size_t kChunkFrames = 8192;       // Frames per file write
+};
+
+#endif // OFFLINEBOUNCE_H
@@ -0,0 +1,393 @@
+#include "offlinerenderer.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <thread>
+
+OfflineRenderer::OfflineRenderer(double sampleRate)
+    : sampleRate(sampleRate)
+    , threadCount(0)
+    , voiceLimit(16)
+    , stealPolicy(VoiceAllocator::StealPolicy::Oldest)
+    , mixBus(sampleRate)
+    , batchNumber(0)
+    , batchThreads(0)
+    , threadsBusy(0)
+    , stopping(false)
+{
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    stopThreads();
+}
+
+void OfflineRenderer::setThreadCount(int count)
+{
+    threadCount = std::max(count, 0);
+}
+
+void OfflineRenderer::prepare(const QMap<int, SounitGraph*> &trackGraphs, const HarmonicGenerator &fallback)
+{
+    int count = threadCount;
+    if (count == 0) {
+        // hardware_concurrency() may report 0 when unknown
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    stopThreads();
+    workers.clear();
+    workers.resize(count);
+    for (Worker &worker : workers) {
+        for (auto it = trackGraphs.constBegin(); it != trackGraphs.constEnd(); ++it) {
+            if (it.value() && it.value()->isValid()) {
+                worker.graphs[it.key()] = it.value()->createVoice();
+            }
+        }
+        worker.generator = fallback;
+    }
+
+    startThreads();
+}
+
+void OfflineRenderer::startThreads()
+{
+    // Threads count batches from now, so one posted before a thread first
+    // takes the lock still counts as new to it
+    uint64_t firstBatch;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = false;
+        firstBatch = batchNumber;
+    }
+    threads.reserve(workers.size() - 1);
+    for (size_t w = 1; w < workers.size(); w++) {
+        threads.emplace_back(&OfflineRenderer::threadLoop, this, static_cast<int>(w), firstBatch);
+    }
+}
+
+void OfflineRenderer::stopThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    batchStart.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void OfflineRenderer::threadLoop(int workerIndex, uint64_t lastBatch)
+{
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (true) {
+        batchStart.wait(lock, [&] { return stopping || batchNumber != lastBatch; });
+        if (stopping) {
+            return;
+        }
+        lastBatch = batchNumber;
+        if (workerIndex >= batchThreads) {
+            continue;  // Fewer notes than workers: sit this one out
+        }
+
+        lock.unlock();
+        batchJob(workers[workerIndex]);
+        lock.lock();
+
+        if (--threadsBusy == 0) {
+            batchDone.notify_one();
+        }
+    }
+}
+
+bool OfflineRenderer::hasGraph(int trackIndex) const
+{
+    return !workers.empty() && workers.front().graphs.count(trackIndex) > 0;
+}
+
+size_t OfflineRenderer::totalSamples(const QVector<Note> &notes, int count) const
+{
+    // Find the total duration (last note's end time)
+    count = std::min(count, static_cast<int>(notes.size()));
+    double totalDurationMs = 0.0;
+    for (int i = 0; i < count; i++) {
+        totalDurationMs = std::max(totalDurationMs, notes[i].getStartTime() + notes[i].getDuration());
+    }
+    return static_cast<size_t>((totalDurationMs / 1000.0) * sampleRate);
+}
+
+std::vector<OfflineRenderer::NotePlacement> OfflineRenderer::placeNotes(const QVector<Note> &notes, int count,
+                                                                         size_t totalSamples) const
+{
+    count = std::min(count, static_cast<int>(notes.size()));
+    std::vector<NotePlacement> placements(std::max(count, 0));
+
+    // Sample positions for each note, clipped to the end of the buffer (safety check)
+    for (int i = 0; i < count; i++) {
+        NotePlacement &placement = placements[i];
+        placement.startSample = static_cast<size_t>((notes[i].getStartTime() / 1000.0) * sampleRate);
+        placement.durationSamples = static_cast<size_t>((notes[i].getDuration() / 1000.0) * sampleRate);
+
+        size_t endSample = std::min(placement.startSample + placement.durationSamples, totalSamples);
+        placement.renderLength = (endSample > placement.startSample) ? endSample - placement.startSample : 0;
+    }
+
+    // Assign voices per track in start order. A stolen note keeps sounding for
+    // the fade length past the steal, a dropped note doesn't sound at all
+    size_t fadeSamples = stealFadeSamples();
+    int stolenCount = 0;
+    int droppedCount = 0;
+
+    std::vector<int> byStart(count);
+    std::iota(byStart.begin(), byStart.end(), 0);
+    std::stable_sort(byStart.begin(), byStart.end(), [&](int a, int b) {
+        return placements[a].startSample < placements[b].startSample;
+    });
+
+    std::map<int, VoiceAllocator> allocators;
+    for (int noteIdx : byStart) {
+        NotePlacement &placement = placements[noteIdx];
+        if (placement.renderLength == 0) {
+            continue;
+        }
+
+        int track = notes[noteIdx].getTrackIndex();
+        auto it = allocators.find(track);
+        if (it == allocators.end()) {
+            it = allocators.emplace(track, VoiceAllocator(voiceLimit, stealPolicy)).first;
+        }
+
+        int stolenOwner = -1;
+        size_t start = placement.startSample;
+        int voice = it->second.allocate(noteIdx, start, start + placement.renderLength,
+                                        notes[noteIdx].getDynamics(), stolenOwner);
+        if (voice < 0) {
+            placement.renderLength = 0;
+            droppedCount++;
+            continue;
+        }
+
+        if (stolenOwner >= 0) {
+            NotePlacement &stolen = placements[stolenOwner];
+            size_t cutLength = start - stolen.startSample + fadeSamples;
+            if (cutLength < stolen.renderLength) {
+                stolen.renderLength = cutLength;
+                stolen.fadeOut = true;
+            }
+            stolenCount++;
+        }
+    }
+
+    if (stolenCount > 0 || droppedCount > 0) {
+        std::cout << "OfflineRenderer: " << voiceLimit << " voice(s) per track, "
+                  << stolenCount << " note(s) stolen, " << droppedCount << " dropped" << std::endl;
+    }
+
+    return placements;
+}
+
+void OfflineRenderer::renderNotes(const QVector<Note> &notes, const std::vector<NotePlacement> &placements,
+                                  const std::vector<int> &noteIndices,
+                                  std::vector<std::vector<float>> &buffers)
+{
+    buffers.resize(placements.size());
+    if (noteIndices.empty() || workers.empty()) {
+        return;
+    }
+
+    for (int noteIdx : noteIndices) {
+        buffers[noteIdx].assign(placements[noteIdx].renderLength, 0.0f);
+    }
+
+    // Longest notes first, so a long note picked up last doesn't hold up the render
+    std::vector<int> order(noteIndices);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return placements[a].renderLength > placements[b].renderLength;
+    });
+
+    size_t fadeSamples = stealFadeSamples();
+    int count = static_cast<int>(order.size());
+    std::atomic<int> nextNote(0);
+    auto runWorker = [&](Worker &worker) {
+        for (int i = nextNote.fetch_add(1); i < count; i = nextNote.fetch_add(1)) {
+            int noteIdx = order[i];
+            std::vector<float> &buffer = buffers[noteIdx];
+            if (buffer.empty()) {
+                continue;
+            }
+
+            renderNote(notes[noteIdx], worker, buffer.data(), buffer.size(),
+                       placements[noteIdx].durationSamples);
+
+            // Stolen note: fade out linearly over its last fadeSamples
+            if (placements[noteIdx].fadeOut) {
+                size_t fadeLength = std::min(fadeSamples, buffer.size());
+                size_t fadeStart = buffer.size() - fadeLength;
+                for (size_t j = 0; j < fadeLength; j++) {
+                    buffer[fadeStart + j] *= static_cast<float>(fadeLength - j) / fadeLength;
+                }
+            }
+        }
+    };
+
+    // Wake the pool; the calling thread works too, so one worker needs no extra thread
+    int threadsUsed = std::min(static_cast<int>(workers.size()), count);
+    if (threadsUsed > 1) {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            batchJob = runWorker;
+            batchThreads = threadsUsed;
+            threadsBusy = threadsUsed - 1;
+            batchNumber++;
+        }
+        batchStart.notify_all();
+    }
+
+    runWorker(workers[0]);
+
+    if (threadsUsed > 1) {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        batchDone.wait(lock, [this] { return threadsBusy == 0; });
+        batchJob = nullptr;
+    }
+}
+
+void OfflineRenderer::render(const QVector<Note> &notes, int count, std::vector<float> &output)
+{
+    count = std::min(count, static_cast<int>(notes.size()));
+    output.clear();
+    if (count <= 0 || workers.empty()) {
+        return;
+    }
+
+    size_t length = totalSamples(notes, count);
+    std::vector<NotePlacement> placements = placeNotes(notes, count, length);
+
+    std::vector<int> noteIndices(count);
+    std::iota(noteIndices.begin(), noteIndices.end(), 0);
+    std::vector<std::vector<float>> noteBuffers;
+    renderNotes(notes, placements, noteIndices, noteBuffers);
+
+    std::cout << "OfflineRenderer: Rendered " << count << " note(s) on "
+              << std::min(static_cast<int>(workers.size()), count) << " thread(s)" << std::endl;
+
+    // Sum in start order (as a RenderStream adds them) so the result is the
+    // same for any thread count and matches streaming
+    std::vector<int> byStart(count);
+    std::iota(byStart.begin(), byStart.end(), 0);
+    std::stable_sort(byStart.begin(), byStart.end(), [&](int a, int b) {
+        return placements[a].startSample < placements[b].startSample;
+    });
+    mixBus.reset(length);
+    for (int i : byStart) {
+        float left, right;
+        noteGains(notes[i], left, right);
+        mixBus.add(noteBuffers[i].data(), placements[i].startSample, noteBuffers[i].size(), left, right);
+    }
+    mixBus.finish(output);
+
+    if (mixBus.getLastReductionDb() < 0.0) {
+        std::cout << "OfflineRenderer: Headroom " << mixBus.getLastReductionDb() << " dB" << std::endl;
+    }
+}
+
+void OfflineRenderer::noteGains(const Note &note, float &left, float &right) const
+{
+    trackMixes.value(note.getTrackIndex(), TrackMix()).noteGains(note.getPitchHz(), left, right);
+}
+
+size_t OfflineRenderer::stealFadeSamples() const
+{
+    return std::max<size_t>(1, static_cast<size_t>(kStealFadeSeconds * sampleRate));
+}
+
+void OfflineRenderer::renderNote(const Note &note, Worker &worker, float *out,
+                                 size_t renderSamples, size_t noteDurationSamples) const
+{
+    // Envelope parameters
+    const double attackRate = 0.01;
+    const double releaseRate = 0.001;
+
+    // Reset synthesis for this note, seeded from the note itself so it renders
+    // the same whichever worker picks it up
+    uint64_t seed = SounitGraph::noteSeed(note.getTrackIndex(), note.contentHash());
+    auto graphIt = worker.graphs.find(note.getTrackIndex());
+    SounitGraph *graph = (graphIt != worker.graphs.end()) ? graphIt->second.get() : nullptr;
+    if (graph) {
+        graph->reset(seed);
+    } else {
+        // For fallback generator, set initial pitch (will be updated per-sample for continuous notes)
+        worker.generator.setFundamentalHz(note.getPitchHz());
+        worker.generator.reset(seed);
+    }
+
+    double amplitude = 0.0;
+
+    // Per-block pitch/progress inputs and graph output
+    double blockPitch[SounitGraph::kMaxBlockFrames];
+    double blockProgress[SounitGraph::kMaxBlockFrames];
+    float blockSamples[SounitGraph::kMaxBlockFrames];
+
+    // Render this note's samples a block at a time
+    for (size_t blockStart = 0; blockStart < renderSamples; blockStart += SounitGraph::kMaxBlockFrames) {
+        int blockFrames = static_cast<int>(std::min<size_t>(SounitGraph::kMaxBlockFrames,
+                                                            renderSamples - blockStart));
+
+        for (int j = 0; j < blockFrames; j++) {
+            size_t i = blockStart + j;
+
+            // Calculate note progress (0.0 to 1.0)
+            // Use noteDurationSamples - 1 as denominator to ensure we reach 1.0 at the last sample
+            if (noteDurationSamples > 1) {
+                blockProgress[j] = static_cast<double>(i) / static_cast<double>(noteDurationSamples - 1);
+            } else {
+                blockProgress[j] = 0.0;  // Single sample note
+            }
+
+            // Sample pitch curve at current time (supports continuous pitch variation)
+            blockPitch[j] = note.getPitchAt(blockProgress[j]);
+        }
+
+        // Generate the block using note's track graph
+        if (graph) {
+            // Use continuous pitch for graph-based synthesis
+            graph->processBlock(blockSamples, blockFrames, blockPitch, blockProgress);
+        } else {
+            for (int j = 0; j < blockFrames; j++) {
+                // Update fallback generator pitch for continuous notes
+                worker.generator.setFundamentalHz(blockPitch[j]);
+                blockSamples[j] = static_cast<float>(worker.generator.generateSample());
+            }
+        }
+
+        for (int j = 0; j < blockFrames; j++) {
+            double noteProgress = blockProgress[j];
+
+            // Sample dynamics curve at current time (supports continuous dynamics variation)
+            double currentDynamics = note.getDynamicsAt(noteProgress);
+
+            // Update amplitude envelope (ADSR)
+            // Attack: first 5% of note
+            // Sustain: middle 85% of note
+            // Release: last 10% of note
+            if (noteProgress < 0.05) {
+                // Attack phase - ramp up quickly
+                amplitude += (1.0 - amplitude) * attackRate;
+            } else if (noteProgress < 0.90) {
+                // Sustain phase - maintain full amplitude
+                amplitude = 1.0;
+            } else {
+                // Release phase - fade out in last 10%
+                amplitude *= (1.0 - releaseRate);
+                if (amplitude < 0.0001) amplitude = 0.0;
+            }
+
+            // Apply envelope and dynamics curve (gain and headroom are up to the mix bus)
+            out[blockStart + j] = static_cast<float>(blockSamples[j] * amplitude * currentDynamics);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef OFFLINERENDERER_H
+#define OFFLINERENDERER_H
+
+#include "harmonicgenerator.h"
+#include "sounitgraph.h"
+#include "voiceallocator.h"
+#include "mixbus.h"
+#include "trackmix.h"
+#include "note.h"
+#include <QMap>
+#include <QVector>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * OfflineRenderer - Renders notes to a stereo buffer on a pool of worker threads
+ *
+ * prepare() gives every worker its own voice of each track's compiled
+ * SounitGraph (and a copy of the fallback generator), so render() can
+ * run notes concurrently without sharing processor state or holding the
+ * engine's graph lock.
+ *
+ * Before rendering, a VoiceAllocator per track decides which notes sound
+ * and for how long: when a track has more overlapping notes than its
+ * voice limit, a note is stolen (cut short with a brief fade) or dropped.
+ * Notes are then handed out longest first from a shared counter, each
+ * rendering into its own (mono) buffer. The buffers are panned onto the
+ * MixBus per their track's TrackMix, in start order after all workers
+ * finish, so the result doesn't depend on thread count or scheduling.
+ *
+ * The worker threads are started by prepare() and sleep between batches,
+ * so a streaming render that calls renderNotes() for every block doesn't
+ * create and join threads each time. The calling thread is worker 0.
+ */
+class OfflineRenderer
+{
+public:
+    OfflineRenderer(double sampleRate = 44100.0);
+    ~OfflineRenderer();  // Joins the worker threads
+
+    OfflineRenderer(const OfflineRenderer &) = delete;
+    OfflineRenderer &operator=(const OfflineRenderer &) = delete;
+
+    // Worker threads (0 = one per hardware thread). Takes effect on the next prepare()
+    void setThreadCount(int count);
+    int getThreadCount() const { return threadCount; }
+
+    // Polyphony per track
+    void setVoiceLimit(int voices) { voiceLimit = std::max(voices, 1); }
+    int getVoiceLimit() const { return voiceLimit; }
+    void setStealPolicy(VoiceAllocator::StealPolicy policy) { stealPolicy = policy; }
+    VoiceAllocator::StealPolicy getStealPolicy() const { return stealPolicy; }
+
+    // Master gain and headroom of the output
+    MixBus &getMixBus() { return mixBus; }
+
+    // Stereo placement of each track (tracks not listed play centred)
+    void setTrackMixes(const QMap<int, TrackMix> &mixes) { trackMixes = mixes; }
+
+    // Left/right gains of a note on the master bus
+    void noteGains(const Note &note, float &left, float &right) const;
+
+    // Create a voice of each track graph, and copy the fallback generator, for every worker,
+    // and start the worker threads (call with the same locking as SounitGraph::createVoice)
+    void prepare(const QMap<int, SounitGraph*> &trackGraphs, const HarmonicGenerator &fallback);
+
+    // Render the first count notes into output (interleaved stereo), resized to the end of the last note
+    void render(const QVector<Note> &notes, int count, std::vector<float> &output);
+
+    // Where a note sits in the output and how much of it sounds after voice allocation
+    struct NotePlacement {
+        size_t startSample = 0;
+        size_t durationSamples = 0;  // Full note length
+        size_t renderLength = 0;     // Samples rendered (0 = dropped or outside the output)
+        bool fadeOut = false;        // Stolen: fades out over its last samples
+    };
+
+    // Steps of render(), for callers that cache partial results:
+    // output length for the first count notes (end of the last note)
+    size_t totalSamples(const QVector<Note> &notes, int count) const;
+
+    // Positions and voice allocation of the first count notes
+    std::vector<NotePlacement> placeNotes(const QVector<Note> &notes, int count, size_t totalSamples) const;
+
+    // Render the listed notes in parallel into buffers[noteIdx] (renderLength
+    // samples each, unmixed and before the mix bus gain). Buffers of unlisted
+    // notes are left as they are
+    void renderNotes(const QVector<Note> &notes, const std::vector<NotePlacement> &placements,
+                     const std::vector<int> &noteIndices, std::vector<std::vector<float>> &buffers);
+
+    // True if prepare() found a valid graph for this track
+    bool hasGraph(int trackIndex) const;
+
+private:
+    // Everything one thread needs to render a note on its own
+    struct Worker {
+        std::map<int, std::unique_ptr<SounitGraph>> graphs;  // Voices, by track index
+        HarmonicGenerator generator;  // Fallback for tracks without a graph
+    };
+
+    // Render one note into out (renderSamples long, possibly clipped
+    // short of the note's full noteDurationSamples)
+    void renderNote(const Note &note, Worker &worker, float *out,
+                    size_t renderSamples, size_t noteDurationSamples) const;
+
+    size_t stealFadeSamples() const;
+
+    // Worker threads 1..n-1: wait for a batch, run it on their worker, repeat
+    void startThreads();
+    void stopThreads();
+    void threadLoop(int workerIndex, uint64_t lastBatch);
+
+    // Length of the fade-out on a stolen note
+    static constexpr double kStealFadeSeconds = 0.005;
+
+    double sampleRate;
+    int threadCount;
+    int voiceLimit;
+    VoiceAllocator::StealPolicy stealPolicy;
+    MixBus mixBus;
+    QMap<int, TrackMix> trackMixes;
+    std::vector<Worker> workers;
+
+    // Worker pool; a batch is one renderNotes() call
+    std::vector<std::thread> threads;
+    std::mutex poolMutex;
+    std::condition_variable batchStart;  // New batch posted, or stopping
+    std::condition_variable batchDone;   // Last busy thread finished its share
+    std::function<void(Worker&)> batchJob;
+    uint64_t batchNumber;
+    int batchThreads;  // Workers taking part in the current batch (including the caller)
+    int threadsBusy;   // Pool threads still working on it
+    bool stopping;
+};
+
+#endif // OFFLINERENDERER_H
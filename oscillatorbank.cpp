@@ -0,0 +1,324 @@
+#include "oscillatorbank.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OSCILLATORBANK_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 is left out on MinGW: GCC on Windows doesn't 32-byte align the
+// stack for spilled AVX registers (GCC bug 54412), which can crash
+#if defined(OSCILLATORBANK_X86) && !(defined(__GNUC__) && defined(_WIN32))
+#define OSCILLATORBANK_AVX2 1
+#if defined(__GNUC__)
+#define OSCILLATORBANK_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define OSCILLATORBANK_TARGET_AVX2
+#endif
+#endif
+
+namespace {
+
+// Oscillators are padded to a multiple of the widest register (8 floats)
+constexpr int kLaneAlign = 8;
+
+// Taylor coefficients of sin(2 pi m), accurate to ~1e-7 for |m| <= 0.25
+constexpr float kSin1 = 6.28318531f;
+constexpr float kSin3 = -41.3417022f;
+constexpr float kSin5 = 81.6052493f;
+constexpr float kSin7 = -76.7058598f;
+constexpr float kSin9 = 42.0586939f;
+constexpr float kSin11 = -15.0946426f;
+
+// Shared by all kernels: phase, amplitude and harmonic number arrays of numLanes floats
+using RenderKernel = void (*)(float *phases, const float *amplitudes, const float *harmonicNumbers,
+                              int numLanes, const double *fundamentalHz, int fundamentalStride,
+                              double cyclesPerHz, double *output, int numFrames);
+
+#ifndef OSCILLATORBANK_X86
+// sin(2 pi x) for x in [0, 1): fold into a quarter cycle around 0.5, then
+// evaluate the odd polynomial and restore the sign
+inline float sineCycles(float x)
+{
+    float u = 0.5f - x;
+    float a = std::fabs(u);
+    float m = std::min(a, 0.5f - a);
+    float z = m * m;
+    float p = m * (kSin1 + z * (kSin3 + z * (kSin5 + z * (kSin7 + z * (kSin9 + z * kSin11)))));
+    return u < 0.0f ? -p : p;
+}
+
+void renderScalar(float *phases, const float *amplitudes, const float *harmonicNumbers,
+                  int numLanes, const double *fundamentalHz, int fundamentalStride,
+                  double cyclesPerHz, double *output, int numFrames)
+{
+    for (int i = 0; i < numFrames; i++) {
+        float increment = static_cast<float>(fundamentalHz[i * fundamentalStride] * cyclesPerHz);
+        float sum = 0.0f;
+
+        for (int h = 0; h < numLanes; h++) {
+            sum += amplitudes[h] * sineCycles(phases[h]);
+
+            float phase = phases[h] + increment * harmonicNumbers[h];
+            phases[h] = phase - std::floor(phase);
+        }
+
+        output[i] = sum;
+    }
+}
+#endif
+
+#ifdef OSCILLATORBANK_X86
+void renderSse2(float *phases, const float *amplitudes, const float *harmonicNumbers,
+                int numLanes, const double *fundamentalHz, int fundamentalStride,
+                double cyclesPerHz, double *output, int numFrames)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (int i = 0; i < numFrames; i++) {
+        __m128 increment = _mm_set1_ps(static_cast<float>(fundamentalHz[i * fundamentalStride] * cyclesPerHz));
+        __m128 sum = _mm_setzero_ps();
+
+        for (int h = 0; h < numLanes; h += 4) {
+            __m128 x = _mm_loadu_ps(phases + h);
+
+            // Sine of the current phase
+            __m128 u = _mm_sub_ps(half, x);
+            __m128 a = _mm_andnot_ps(signMask, u);
+            __m128 m = _mm_min_ps(a, _mm_sub_ps(half, a));
+            __m128 z = _mm_mul_ps(m, m);
+            __m128 p = _mm_add_ps(_mm_set1_ps(kSin9), _mm_mul_ps(z, _mm_set1_ps(kSin11)));
+            p = _mm_add_ps(_mm_set1_ps(kSin7), _mm_mul_ps(z, p));
+            p = _mm_add_ps(_mm_set1_ps(kSin5), _mm_mul_ps(z, p));
+            p = _mm_add_ps(_mm_set1_ps(kSin3), _mm_mul_ps(z, p));
+            p = _mm_add_ps(_mm_set1_ps(kSin1), _mm_mul_ps(z, p));
+            p = _mm_mul_ps(m, p);
+            p = _mm_or_ps(p, _mm_and_ps(u, signMask));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(amplitudes + h), p));
+
+            // Advance and wrap to [0, 1) (SSE2 has no floor: truncate, then fix negatives)
+            x = _mm_add_ps(x, _mm_mul_ps(increment, _mm_loadu_ps(harmonicNumbers + h)));
+            __m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+            whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, x), one));
+            _mm_storeu_ps(phases + h, _mm_sub_ps(x, whole));
+        }
+
+        // Horizontal sum of the four lanes
+        __m128 shuffled = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+        sum = _mm_add_ps(sum, shuffled);
+        shuffled = _mm_movehl_ps(shuffled, sum);
+        sum = _mm_add_ss(sum, shuffled);
+        output[i] = _mm_cvtss_f32(sum);
+    }
+}
+#endif
+
+#ifdef OSCILLATORBANK_AVX2
+OSCILLATORBANK_TARGET_AVX2
+void renderAvx2(float *phases, const float *amplitudes, const float *harmonicNumbers,
+                int numLanes, const double *fundamentalHz, int fundamentalStride,
+                double cyclesPerHz, double *output, int numFrames)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    for (int i = 0; i < numFrames; i++) {
+        __m256 increment = _mm256_set1_ps(static_cast<float>(fundamentalHz[i * fundamentalStride] * cyclesPerHz));
+        __m256 sum = _mm256_setzero_ps();
+
+        for (int h = 0; h < numLanes; h += 8) {
+            __m256 x = _mm256_loadu_ps(phases + h);
+
+            // Sine of the current phase
+            __m256 u = _mm256_sub_ps(half, x);
+            __m256 a = _mm256_andnot_ps(signMask, u);
+            __m256 m = _mm256_min_ps(a, _mm256_sub_ps(half, a));
+            __m256 z = _mm256_mul_ps(m, m);
+            __m256 p = _mm256_fmadd_ps(z, _mm256_set1_ps(kSin11), _mm256_set1_ps(kSin9));
+            p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(kSin7));
+            p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(kSin5));
+            p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(kSin3));
+            p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(kSin1));
+            p = _mm256_mul_ps(m, p);
+            p = _mm256_or_ps(p, _mm256_and_ps(u, signMask));
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(amplitudes + h), p, sum);
+
+            // Advance and wrap to [0, 1)
+            x = _mm256_fmadd_ps(increment, _mm256_loadu_ps(harmonicNumbers + h), x);
+            _mm256_storeu_ps(phases + h, _mm256_sub_ps(x, _mm256_floor_ps(x)));
+        }
+
+        // Horizontal sum of the eight lanes
+        __m128 low = _mm256_castps256_ps128(sum);
+        __m128 high = _mm256_extractf128_ps(sum, 1);
+        low = _mm_add_ps(low, high);
+        __m128 shuffled = _mm_movehdup_ps(low);
+        low = _mm_add_ps(low, shuffled);
+        shuffled = _mm_movehl_ps(shuffled, low);
+        low = _mm_add_ss(low, shuffled);
+        output[i] = _mm_cvtss_f32(low);
+    }
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // OSXSAVE + FMA + AVX, and the OS saves YMM state
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !fma || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+struct KernelChoice {
+    RenderKernel kernel;
+    const char *name;
+};
+
+const KernelChoice &selectedKernel()
+{
+    static const KernelChoice choice = []() -> KernelChoice {
+#ifdef OSCILLATORBANK_AVX2
+        if (cpuSupportsAvx2()) {
+            return {renderAvx2, "avx2"};
+        }
+#endif
+#ifdef OSCILLATORBANK_X86
+        // SSE2 is part of every x86-64 CPU
+        return {renderSse2, "sse2"};
+#else
+        return {renderScalar, "scalar"};
+#endif
+    }();
+    return choice;
+}
+
+} // namespace
+
+OscillatorBank::OscillatorBank()
+    : numOscillators(0)
+    , bandLimit(-1)
+{
+    setNumOscillators(64);
+}
+
+void OscillatorBank::setNumOscillators(int count)
+{
+    count = std::max(count, 0);
+    if (count == numOscillators) {
+        return;
+    }
+
+    int lanes = (count + kLaneAlign - 1) / kLaneAlign * kLaneAlign;
+    if (lanes > static_cast<int>(phases.size())) {
+        phases.resize(lanes, 0.0f);
+        amplitudes.resize(lanes, 0.0f);
+        requestedAmplitudes.resize(lanes, 0.0f);
+        harmonicNumbers.resize(lanes, 0.0f);
+        for (int h = 0; h < lanes; h++) {
+            harmonicNumbers[h] = static_cast<float>(h + 1);
+        }
+    }
+
+    // Oscillators dropped from the bank go silent
+    std::fill(requestedAmplitudes.begin() + count, requestedAmplitudes.end(), 0.0f);
+
+    numOscillators = count;
+    bandLimit = -1;
+}
+
+void OscillatorBank::setAmplitudes(const double *amplitudesIn, int count, double gain)
+{
+    count = std::min(count, numOscillators);
+    for (int h = 0; h < count; h++) {
+        requestedAmplitudes[h] = static_cast<float>(std::max(amplitudesIn[h], 0.0) * gain);
+    }
+    std::fill(requestedAmplitudes.begin() + count, requestedAmplitudes.end(), 0.0f);
+    bandLimit = -1;
+}
+
+void OscillatorBank::applyBandLimit(int count)
+{
+    std::copy(requestedAmplitudes.begin(), requestedAmplitudes.begin() + count, amplitudes.begin());
+    std::fill(amplitudes.begin() + count, amplitudes.end(), 0.0f);
+    bandLimit = count;
+}
+
+void OscillatorBank::shiftPhase(int index, double cycles)
+{
+    if (index < 0 || index >= numOscillators) {
+        return;
+    }
+    double phase = phases[index] + cycles;
+    phases[index] = static_cast<float>(phase - std::floor(phase));
+}
+
+void OscillatorBank::reset()
+{
+    std::fill(phases.begin(), phases.end(), 0.0f);
+}
+
+void OscillatorBank::render(const double *fundamentalHz, int fundamentalStride, double sampleRate,
+                            double *output, int numFrames, double cutoffHz)
+{
+    if (cutoffHz <= 0.0) {
+        cutoffHz = 0.5 * sampleRate;
+    }
+
+    // Highest fundamental in the block decides which oscillators stay below the cutoff
+    double maxFundamental = fundamentalHz[0];
+    if (fundamentalStride != 0) {
+        for (int i = 1; i < numFrames; i++) {
+            maxFundamental = std::max(maxFundamental, fundamentalHz[i * fundamentalStride]);
+        }
+    }
+    int audible = numOscillators;
+    if (maxFundamental > 0.0) {
+        // Oscillator h sounds while (h + 1) * maxFundamental < cutoffHz
+        double ratio = std::min(cutoffHz / maxFundamental, static_cast<double>(numOscillators) + 1.0);
+        audible = std::min(audible, std::max(static_cast<int>(std::ceil(ratio)) - 1, 0));
+    }
+    if (audible != bandLimit) {
+        applyBandLimit(audible);
+    }
+
+    // Skip whole registers above the band limit
+    int lanes = (audible + kLaneAlign - 1) / kLaneAlign * kLaneAlign;
+    if (lanes == 0) {
+        std::fill(output, output + numFrames, 0.0);
+        return;
+    }
+
+    selectedKernel().kernel(phases.data(), amplitudes.data(), harmonicNumbers.data(), lanes,
+                            fundamentalHz, fundamentalStride, 1.0 / sampleRate, output, numFrames);
+}
+
+const char *OscillatorBank::kernelName()
+{
+    return selectedKernel().name;
+}
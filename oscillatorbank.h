@@ -0,0 +1,69 @@
+#ifndef OSCILLATORBANK_H
+#define OSCILLATORBANK_H
+
+#include <vector>
+
+/**
+ * OscillatorBank - Vectorized bank of harmonic sine oscillators
+ *
+ * Shared additive kernel for SpectrumToSignal and HarmonicGenerator.
+ * Oscillator h runs at (h + 1) x the fundamental. Phases (in cycles),
+ * amplitudes and harmonic numbers are kept as separate float arrays
+ * (structure of arrays) so one SIMD register holds 4 or 8 oscillators,
+ * and sine is a polynomial approximation instead of std::sin.
+ *
+ * The kernel (AVX2+FMA, SSE2 or scalar) is chosen once at runtime from
+ * the CPU's capabilities.
+ *
+ * render() is band-limited: oscillators at or above Nyquist (or a lower
+ * cutoff) for the highest fundamental in the block are silenced and
+ * skipped, so high notes neither alias nor pay for partials nobody can hear. A skipped
+ * oscillator's phase holds until it comes back into range.
+ */
+class OscillatorBank
+{
+public:
+    OscillatorBank();
+
+    // Number of oscillators (harmonics) in the bank
+    void setNumOscillators(int count);
+    int getNumOscillators() const { return numOscillators; }
+
+    // Set amplitudes for the first count oscillators (the rest are silent),
+    // each multiplied by gain. Negative amplitudes are treated as silent.
+    void setAmplitudes(const double *amplitudes, int count, double gain = 1.0);
+
+    // Offset one oscillator's phase (used for drift)
+    void shiftPhase(int index, double cycles);
+
+    // Reset all phases to zero
+    void reset();
+
+    // Render numFrames samples: output[i] = sum of amplitude[h] * sin(phase[h]),
+    // then every phase advances by (h + 1) * fundamentalHz / sampleRate.
+    // fundamentalHz is read with the given stride (0 = constant fundamental).
+    // Only oscillators below cutoffHz (0 = sampleRate / 2) at the block's
+    // highest fundamental sound.
+    void render(const double *fundamentalHz, int fundamentalStride, double sampleRate,
+                double *output, int numFrames, double cutoffHz = 0.0);
+
+    // Name of the kernel selected for this CPU ("avx2", "sse2" or "scalar")
+    static const char *kernelName();
+
+    // Oscillators that sounded in the last render() (below the cutoff)
+    int getAudibleOscillators() const { return bandLimit; }
+
+private:
+    int numOscillators;
+
+    std::vector<float> phases;           // Phase per oscillator, in cycles [0, 1)
+    std::vector<float> amplitudes;       // Amplitude per oscillator as rendered (0 above the band limit)
+    std::vector<float> requestedAmplitudes;  // Amplitude per oscillator as set
+    std::vector<float> harmonicNumbers;  // h + 1 per oscillator
+    int bandLimit;  // Oscillators below the cutoff in amplitudes (-1 = not applied yet)
+
+    // Silence the oscillators from count on for the next render
+    void applyBandLimit(int count);
+};
+
+#endif // OSCILLATORBANK_H
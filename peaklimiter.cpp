@@ -0,0 +1,135 @@
+#include "peaklimiter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Ring index i + offset, for offset < size (cheaper than %)
+inline size_t wrap(size_t i, size_t offset, size_t size)
+{
+    i += offset;
+    return i >= size ? i - size : i;
+}
+
+// Drop entries older than oldest from the front (before a push, so the ring can't overflow)
+inline void expire(std::vector<uint64_t> &frame, size_t &head, size_t &count, uint64_t oldest)
+{
+    while (count > 0 && frame[head] < oldest) {
+        head = wrap(head, 1, frame.size());
+        count--;
+    }
+}
+
+} // namespace
+
+PeakLimiter::PeakLimiter(double sampleRate)
+    : lookahead(1)
+    , hold(1)
+    , gain(1.0)
+    , ceiling(1.0)
+    , unityGain(0)
+    , frameCount(0)
+    , heldPos(0)
+    , heldSum(0)
+    , delayPos(0)
+    , lowestGain(0)
+{
+    setSampleRate(sampleRate);
+}
+
+void PeakLimiter::setSampleRate(double sampleRate)
+{
+    lookahead = std::max<size_t>(1, static_cast<size_t>(kLookaheadSeconds * sampleRate));
+    hold = std::max<size_t>(1, static_cast<size_t>(kHoldSeconds * sampleRate));
+
+    // A window of n + 1 frames never holds more than n + 1 entries
+    peaks.frame.assign(lookahead + 1, 0);
+    peaks.value.assign(lookahead + 1, 0.0);
+    holds.frame.assign(hold + 1, 0);
+    holds.value.assign(hold + 1, 0.0);
+    heldGains.assign(lookahead + 1, 0);
+    delay.assign(lookahead * 2, 0.0f);
+    reset();
+}
+
+void PeakLimiter::reset()
+{
+    unityGain = static_cast<int64_t>(gain * kUnity);
+    frameCount = 0;
+    peaks.head = peaks.count = 0;
+    holds.head = holds.count = 0;
+
+    // Silence so far: the full gain held everywhere
+    std::fill(heldGains.begin(), heldGains.end(), unityGain);
+    heldPos = 0;
+    heldSum = unityGain * static_cast<int64_t>(heldGains.size());
+    std::fill(delay.begin(), delay.end(), 0.0f);
+    delayPos = 0;
+    lowestGain = heldSum;
+}
+
+void PeakLimiter::process(const float *input, float *output, size_t frames)
+{
+    const int64_t fullSum = unityGain * static_cast<int64_t>(heldGains.size());
+    const double heldScale = 1.0 / (static_cast<double>(heldGains.size()) * kUnity);
+
+    for (size_t i = 0; i < frames; i++) {
+        const float left = input[i * 2];
+        const float right = input[i * 2 + 1];
+        const uint64_t t = frameCount++;
+
+        // Peak of the frames the delayed output is about to reach
+        const double level = std::max(std::fabs(left), std::fabs(right));
+        expire(peaks.frame, peaks.head, peaks.count, t >= lookahead ? t - lookahead : 0);
+        while (peaks.count > 0 && peaks.value[wrap(peaks.head, peaks.count - 1, peaks.value.size())] <= level) {
+            peaks.count--;
+        }
+        size_t back = wrap(peaks.head, peaks.count, peaks.value.size());
+        peaks.frame[back] = t;
+        peaks.value[back] = level;
+        peaks.count++;
+        const double peak = peaks.value[peaks.head];
+
+        // Largest gain that keeps that peak under the ceiling (rounded down)
+        int64_t allowed = unityGain;
+        if (peak * gain > ceiling) {
+            allowed = static_cast<int64_t>(std::floor(ceiling / peak * kUnity));
+        }
+
+        // Hold the lowest allowed gain
+        const double allowedValue = static_cast<double>(allowed);
+        expire(holds.frame, holds.head, holds.count, t >= hold ? t - hold : 0);
+        while (holds.count > 0 && holds.value[wrap(holds.head, holds.count - 1, holds.value.size())] >= allowedValue) {
+            holds.count--;
+        }
+        back = wrap(holds.head, holds.count, holds.value.size());
+        holds.frame[back] = t;
+        holds.value[back] = allowedValue;
+        holds.count++;
+        const int64_t held = static_cast<int64_t>(holds.value[holds.head]);
+
+        // Ramp: mean of the held gains over the lookahead (exact integer sum)
+        heldSum += held - heldGains[heldPos];
+        heldGains[heldPos] = held;
+        heldPos = wrap(heldPos, 1, heldGains.size());
+        lowestGain = std::min(lowestGain, heldSum);
+        const double applied = (heldSum == fullSum) ? gain : heldSum * heldScale;
+
+        // Apply it to the frame leaving the delay line
+        float *delayed = delay.data() + delayPos * 2;
+        output[i * 2] = static_cast<float>(delayed[0] * applied);
+        output[i * 2 + 1] = static_cast<float>(delayed[1] * applied);
+        delayed[0] = left;
+        delayed[1] = right;
+        delayPos = wrap(delayPos, 1, lookahead);
+    }
+}
+
+double PeakLimiter::getReductionDb() const
+{
+    const int64_t fullSum = unityGain * static_cast<int64_t>(heldGains.size());
+    if (lowestGain >= fullSum || fullSum <= 0) {
+        return 0.0;
+    }
+    return 20.0 * std::log10(static_cast<double>(std::max<int64_t>(lowestGain, 1)) / fullSum);
+}
@@ -0,0 +1,89 @@
+#ifndef PEAKLIMITER_H
+#define PEAKLIMITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * PeakLimiter - Lookahead gain stage that keeps a stereo mix under a ceiling
+ *
+ * Applies a gain to interleaved stereo frames and pulls it down ahead of
+ * any peak that would cross the ceiling, so dense passages get quieter
+ * instead of clipping. The output is delayed by getLatency() frames:
+ *
+ * - each frame's allowed gain is ceiling / (peak over the next lookahead
+ *   frames), capped at the requested gain;
+ * - that is held at its lowest for the hold time, so the gain doesn't
+ *   pump on every cycle of a loud tone;
+ * - the gain applied is the mean of the held values over the lookahead,
+ *   a ramp that has fully arrived by the time the peak does.
+ *
+ * Every output frame depends only on the input within a bounded window
+ * (getSettleFrames() before it, the latency after), and the running mean
+ * is kept in integer fixed point, so the result is exact: the same mix
+ * limited in one pass or in blocks, or started anywhere at least
+ * getSettleFrames() early, comes out sample-identical.
+ *
+ * No allocation after setSampleRate(), so it can run on the audio thread.
+ */
+class PeakLimiter
+{
+public:
+    PeakLimiter(double sampleRate = 44100.0);
+
+    // Size the lookahead and hold for a sample rate (allocates; also resets)
+    void setSampleRate(double sampleRate);
+
+    // Gain before limiting, and the highest allowed peak (take effect on reset())
+    void setGain(double gain) { this->gain = gain; }
+    void setCeiling(double ceiling) { this->ceiling = ceiling; }
+
+    // Forget all history, as if the input so far had been silence
+    void reset();
+
+    // Limit frames stereo frames; output[i] is input frame i - getLatency()
+    // (counting across calls). In place is fine
+    void process(const float *input, float *output, size_t frames);
+
+    size_t getLatency() const { return lookahead; }
+
+    // Input needed before a frame for its output to match an unbroken run
+    size_t getSettleFrames() const { return lookahead + hold; }
+
+    // Lowest gain applied since reset(), relative to the requested gain, in dB (0 = none)
+    double getReductionDb() const;
+
+private:
+    // Fixed-point gain: kUnity = 1.0
+    static constexpr double kUnity = 4294967296.0;
+
+    // Monotonic queue of (frame, value) for a sliding max or min, in a fixed ring
+    struct Window {
+        std::vector<uint64_t> frame;
+        std::vector<double> value;
+        size_t head = 0;
+        size_t count = 0;
+    };
+
+    static constexpr double kLookaheadSeconds = 0.005;
+    static constexpr double kHoldSeconds = 0.05;
+
+    size_t lookahead;
+    size_t hold;
+    double gain;
+    double ceiling;
+    int64_t unityGain;  // gain in fixed point
+
+    uint64_t frameCount;
+    Window peaks;  // Max of |input| over the lookahead
+    Window holds;  // Min of the allowed gain over the hold time
+    std::vector<int64_t> heldGains;  // Last lookahead + 1 held gains, summed in heldSum
+    size_t heldPos;
+    int64_t heldSum;
+    std::vector<float> delay;  // Last lookahead input frames
+    size_t delayPos;
+    int64_t lowestGain;
+};
+
+#endif // PEAKLIMITER_H
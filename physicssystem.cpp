@@ -76,3 +76,10 @@ double PhysicsSystem::processSample(double targetValue)
 
     return currentValue;
 }
+
+void PhysicsSystem::processBlock(const double *targetValue, double *output, int numFrames)
+{
+    for (int i = 0; i < numFrames; i++) {
+        output[i] = processSample(targetValue[i]);
+    }
+}
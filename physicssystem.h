@@ -36,6 +36,9 @@ public:
     // Process one sample/step and return current smoothed value
     double processSample(double targetValue);
 
+    // Process a block of target values with fixed parameters
+    void processBlock(const double *targetValue, double *output, int numFrames);
+
     // Apply an impulse (velocity kick)
     void applyImpulse(double amount);
 
@@ -0,0 +1,56 @@
+#ifndef PLAYBACKTRANSPORT_H
+#define PLAYBACKTRANSPORT_H
+
+#include <cstdint>
+
+/**
+ * PlaybackRange - Where playback starts and loops, in ms on the timeline of the notes played
+ */
+struct PlaybackRange {
+    double startMs = 0.0;
+    double loopStartMs = 0.0;
+    double loopEndMs = 0.0;  // <= loopStartMs = no loop
+};
+
+/**
+ * PlaybackTransport - Maps samples played to a position on the note timeline
+ *
+ * Playback starts at startSample and runs forward. With a loop region it
+ * continues from loopStart each time it reaches loopEnd, so the mapping
+ * never ends. The audio callback (reading the rendered buffer) and the
+ * streaming producer (filling its ring in playing order) use the same
+ * mapping, which keeps loops sample-accurate in both modes.
+ */
+class PlaybackTransport
+{
+public:
+    // loopEnd <= loopStart = no loop; a loop that ends before startSample is ignored
+    PlaybackTransport(uint64_t startSample = 0, uint64_t loopStart = 0, uint64_t loopEnd = 0)
+        : startSample(startSample)
+        , loopStart(loopStart)
+        , loopEnd(loopEnd)
+    {}
+
+    bool loops() const { return loopEnd > loopStart && startSample < loopEnd; }
+
+    uint64_t getStartSample() const { return startSample; }
+    uint64_t getLoopStart() const { return loopStart; }
+    uint64_t getLoopEnd() const { return loopEnd; }
+
+    // Timeline sample heard after played samples
+    uint64_t timelineSample(uint64_t played) const
+    {
+        uint64_t position = startSample + played;
+        if (loops() && position >= loopEnd) {
+            position = loopStart + (position - loopEnd) % (loopEnd - loopStart);
+        }
+        return position;
+    }
+
+private:
+    uint64_t startSample;
+    uint64_t loopStart;
+    uint64_t loopEnd;
+};
+
+#endif // PLAYBACKTRANSPORT_H
@@ -0,0 +1,60 @@
+#include "realtimereclaimer.h"
+
+RealtimeReclaimer::~RealtimeReclaimer()
+{
+    collectAll();
+}
+
+void RealtimeReclaimer::retireErased(void *object, void (*destroy)(void*))
+{
+    // Read after the pointer swap (seq_cst): a callback that entered before
+    // the swap shows up as an odd epoch here
+    uint64_t epoch = readerEpoch.load(std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retired.push_back({object, destroy, epoch});
+}
+
+void RealtimeReclaimer::collect()
+{
+    uint64_t now = readerEpoch.load(std::memory_order_acquire);
+
+    std::vector<Retired> ready;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        auto it = retired.begin();
+        while (it != retired.end()) {
+            // Even = no callback was running; changed = that callback has returned
+            bool safe = (it->epoch % 2 == 0) || (it->epoch != now);
+            if (safe) {
+                ready.push_back(*it);
+                it = retired.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // Destroy outside the lock, destructors can be slow
+    for (const Retired &entry : ready) {
+        entry.destroy(entry.object);
+    }
+}
+
+void RealtimeReclaimer::collectAll()
+{
+    std::vector<Retired> all;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        all.swap(retired);
+    }
+    for (const Retired &entry : all) {
+        entry.destroy(entry.object);
+    }
+}
+
+size_t RealtimeReclaimer::pendingCount()
+{
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    return retired.size();
+}
@@ -0,0 +1,82 @@
+#ifndef REALTIMERECLAIMER_H
+#define REALTIMERECLAIMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * RealtimeReclaimer - Hands objects to the audio thread without locks
+ *
+ * The UI thread publishes a new object by swapping it into an atomic
+ * pointer; the audio thread just loads the pointer. The old object can't
+ * be deleted right away because a callback may still be reading it, so
+ * it's retired and freed later, on a non-real-time thread, once every
+ * callback that could have seen it has returned (an RCU grace period).
+ *
+ * The audio thread brackets each callback with enterReader()/exitReader(),
+ * which bump an epoch counter: odd while inside a callback, even outside.
+ * An object retired at an even epoch is unreachable immediately; one
+ * retired at an odd epoch becomes free as soon as the epoch moves on.
+ * The reader side is two atomic increments and never waits.
+ *
+ * There must be only one reader thread (the audio callback). Retiring and
+ * collecting may happen on any number of other threads.
+ */
+class RealtimeReclaimer
+{
+public:
+    RealtimeReclaimer() = default;
+    ~RealtimeReclaimer();  // Frees everything retired (the audio stream must be stopped)
+
+    RealtimeReclaimer(const RealtimeReclaimer &) = delete;
+    RealtimeReclaimer &operator=(const RealtimeReclaimer &) = delete;
+
+    // Audio thread: call at the start and end of every callback
+    void enterReader() { readerEpoch.fetch_add(1, std::memory_order_seq_cst); }
+    void exitReader() { readerEpoch.fetch_add(1, std::memory_order_release); }
+
+    // Replace the object in slot with value (may be null) and retire the old one
+    template <typename T>
+    void publish(std::atomic<T*> &slot, T *value)
+    {
+        T *old = slot.exchange(value, std::memory_order_seq_cst);
+        if (old) {
+            retire(old);
+        }
+        collect();
+    }
+
+    // Delete object once no callback can still be using it
+    template <typename T>
+    void retire(T *object)
+    {
+        retireErased(const_cast<void*>(static_cast<const void*>(object)),
+                     [](void *p) { delete static_cast<T*>(p); });
+    }
+
+    // Free retired objects whose grace period has passed
+    void collect();
+
+    // Free all retired objects now (only when the audio thread isn't running)
+    void collectAll();
+
+    // Objects waiting for their grace period
+    size_t pendingCount();
+
+private:
+    struct Retired {
+        void *object;
+        void (*destroy)(void*);
+        uint64_t epoch;  // Reader epoch when the object was unpublished
+    };
+
+    void retireErased(void *object, void (*destroy)(void*));
+
+    std::atomic<uint64_t> readerEpoch{0};
+    std::mutex retiredMutex;  // Only taken by non-real-time threads
+    std::vector<Retired> retired;
+};
+
+#endif // REALTIMERECLAIMER_H
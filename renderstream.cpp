@@ -0,0 +1,214 @@
+#include "renderstream.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+
+RenderStream::RenderStream(std::unique_ptr<OfflineRenderer> renderer, const QVector<Note> &notes, int count,
+                           double sampleRate, double renderAheadMs, const PlaybackTransport &transport)
+    : renderer(std::move(renderer))
+    , notes(notes)
+    , totalSamples(0)
+    , transport(transport)
+    , ring(2 * std::max<size_t>(2 * kBlockFrames, static_cast<size_t>(renderAheadMs / 1000.0 * sampleRate)))
+    , stopRequested(false)
+    , producerDone(false)
+    , underruns(0)
+    , firstBlockReady(false)
+{
+    // Keep only the notes to play
+    count = std::max(0, std::min(count, static_cast<int>(this->notes.size())));
+    this->notes.resize(count);
+    totalSamples = this->renderer->totalSamples(this->notes, count);
+}
+
+RenderStream::~RenderStream()
+{
+    stop();
+}
+
+void RenderStream::start()
+{
+    if (producer.joinable()) {
+        return;
+    }
+
+    producer = std::thread(&RenderStream::produce, this);
+
+    // Playback starts with the first block, not the whole score
+    std::unique_lock<std::mutex> lock(readyMutex);
+    readyCondition.wait(lock, [this] { return firstBlockReady; });
+}
+
+void RenderStream::stop()
+{
+    stopRequested.store(true);
+    if (producer.joinable()) {
+        producer.join();
+    }
+}
+
+size_t RenderStream::read(float *out, size_t frames)
+{
+    // Both sides move whole frames, so the ring always holds an even count
+    size_t got = ring.read(out, frames * 2) / 2;
+    if (got < frames && !producerDone.load(std::memory_order_acquire)) {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    return got;
+}
+
+bool RenderStream::isFinished() const
+{
+    return producerDone.load(std::memory_order_acquire) && ring.readAvailable() == 0;
+}
+
+void RenderStream::produce()
+{
+    auto signalReady = [this] {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        if (!firstBlockReady) {
+            firstBlockReady = true;
+            readyCondition.notify_all();
+        }
+    };
+
+    int count = notes.size();
+    std::vector<OfflineRenderer::NotePlacement> placements = renderer->placeNotes(notes, count, totalSamples);
+
+    // Notes in start order, so each block only renders the notes that begin in it
+    std::vector<int> byStart(count);
+    std::iota(byStart.begin(), byStart.end(), 0);
+    std::stable_sort(byStart.begin(), byStart.end(), [&](int a, int b) {
+        return placements[a].startSample < placements[b].startSample;
+    });
+
+    // Running stereo mix from mixPos on; pendingHead skips frames already limited
+    std::vector<float> pending;
+    size_t pendingHead = 0;
+    std::vector<std::vector<float>> noteBuffers;
+    std::vector<float> block(kBlockFrames * 2);
+    size_t nextNote = 0;
+
+    // With a loop the timeline is rendered up to the loop end, and the loop
+    // region is kept to repeat afterwards
+    bool loops = transport.loops();
+    size_t timelineEnd = loops ? static_cast<size_t>(transport.getLoopEnd()) : totalSamples;
+    size_t startSample = static_cast<size_t>(transport.getStartSample());
+    size_t loopStart = static_cast<size_t>(transport.getLoopStart());
+    std::vector<float> loopRegion;
+
+    // The limiter's output trails the mix by its lookahead, so the mix runs
+    // that far past the end of the timeline
+    MixBus &mixBus = renderer->getMixBus();
+    mixBus.startStream();
+    size_t latency = mixBus.getLatency();
+    size_t mixEndLimit = timelineEnd + latency;
+
+    // Nothing before the start point (or the loop start, if earlier) is heard.
+    // The walk begins just early enough for the limiter to settle there, so
+    // playing from the middle doesn't render everything before it
+    size_t playStart = loops ? std::min(startSample, loopStart) : startSample;
+    size_t walkStart = playStart - std::min(playStart, mixBus.getSettleFrames());
+
+    for (size_t mixPos = walkStart; mixPos < mixEndLimit && !stopRequested.load(); mixPos += kBlockFrames) {
+        size_t frames = std::min(kBlockFrames, mixEndLimit - mixPos);
+        size_t mixEnd = mixPos + frames;
+
+        // Render every note starting in this block; the first block also takes
+        // the notes still sounding at walkStart, which join mid-note
+        std::vector<int> due;
+        while (nextNote < byStart.size() && placements[byStart[nextNote]].startSample < mixEnd) {
+            int noteIdx = byStart[nextNote++];
+            const OfflineRenderer::NotePlacement &placement = placements[noteIdx];
+            if (placement.renderLength > 0 && placement.startSample + placement.renderLength > walkStart) {
+                due.push_back(noteIdx);
+            }
+        }
+        renderer->renderNotes(notes, placements, due, noteBuffers);
+
+        for (int noteIdx : due) {
+            std::vector<float> &buffer = noteBuffers[noteIdx];
+            size_t noteStart = placements[noteIdx].startSample;
+            size_t skip = (noteStart < mixPos) ? mixPos - noteStart : 0;
+            size_t offset = pendingHead + (noteStart + skip - mixPos);
+            size_t count = buffer.size() - skip;
+            if (pending.size() < (offset + count) * 2) {
+                pending.resize((offset + count) * 2, 0.0f);
+            }
+            float left, right;
+            renderer->noteGains(notes[noteIdx], left, right);
+            MixBus::panInto(pending.data() + offset * 2, buffer.data() + skip, count, left, right);
+            std::vector<float>().swap(buffer);  // Done with it
+        }
+
+        // Take the block off the front of the mix and limit it
+        if (pending.size() < (pendingHead + frames) * 2) {
+            pending.resize((pendingHead + frames) * 2, 0.0f);
+        }
+        std::copy(pending.begin() + pendingHead * 2, pending.begin() + (pendingHead + frames) * 2, block.begin());
+        pendingHead += frames;
+        if (pendingHead * 4 > pending.size()) {
+            pending.erase(pending.begin(), pending.begin() + pendingHead * 2);
+            pendingHead = 0;
+        }
+        mixBus.limitBlock(block.data(), frames);
+
+        // What came out is timeline [mixPos - latency, mixEnd - latency); the
+        // first latency frames are the limiter filling up
+        if (mixEnd <= walkStart + latency) {
+            continue;
+        }
+        size_t blockStart = std::max(mixPos, walkStart + latency) - latency;
+        size_t blockEnd = std::min(mixEnd - latency, timelineEnd);
+        const float *limited = block.data() + (blockStart + latency - mixPos) * 2;
+
+        if (loops && blockEnd > loopStart) {
+            size_t from = std::max(blockStart, loopStart);
+            loopRegion.insert(loopRegion.end(), limited + (from - blockStart) * 2, limited + (blockEnd - blockStart) * 2);
+        }
+
+        // Only what's at or after the start point is heard
+        if (blockEnd > startSample) {
+            size_t from = std::max(blockStart, startSample);
+            push(limited + (from - blockStart) * 2, blockEnd - from);
+            signalReady();
+        }
+    }
+
+    // Repeat the loop region until stopped
+    size_t loopFrames = loopRegion.size() / 2;
+    size_t loopPos = 0;
+    while (loops && loopFrames > 0 && !stopRequested.load()) {
+        size_t frames = std::min(kBlockFrames, loopFrames - loopPos);
+        push(loopRegion.data() + loopPos * 2, frames);
+        signalReady();
+        loopPos = (loopPos + frames) % loopFrames;
+    }
+
+    producerDone.store(true, std::memory_order_release);
+    signalReady();
+
+    if (underruns.load() > 0) {
+        std::cout << "RenderStream: " << underruns.load() << " underrun(s)" << std::endl;
+    }
+}
+
+bool RenderStream::push(const float *frames, size_t frameCount)
+{
+    const float *samples = frames;
+    size_t count = frameCount * 2;
+    while (count > 0) {
+        // Wait for the callback to make room (the ring holds the render-ahead)
+        size_t written = ring.write(samples, count);
+        samples += written;
+        count -= written;
+        if (count > 0) {
+            if (stopRequested.load()) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef RENDERSTREAM_H
+#define RENDERSTREAM_H
+
+#include "offlinerenderer.h"
+#include "spscringbuffer.h"
+#include "playbacktransport.h"
+#include "note.h"
+#include <QVector>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * RenderStream - Renders notes a little ahead of playback on a background thread
+ *
+ * Instead of rendering the whole score before the first sample plays, a
+ * producer thread walks the timeline in blocks of kBlockFrames: it renders
+ * the notes that start in the next block (on the OfflineRenderer's
+ * workers), pans them into a running stereo mix and pushes the finished
+ * block, interleaved, into an SpscRingBuffer sized to the render-ahead
+ * time. The audio callback drains the ring with read(), which never
+ * blocks; if the producer falls behind, the callback plays silence and
+ * counts an underrun.
+ *
+ * Notes are still rendered whole, so a block can't be emitted before
+ * every note starting in it is done. Voice allocation is decided up front
+ * for the whole score, exactly as in OfflineRenderer::render(). Notes are
+ * summed in start order and the mix bus limiter runs over the mix as it's
+ * made, a lookahead behind, so the stream is sample-identical to the
+ * cached render (MixBus::finish()) of the same notes.
+ *
+ * Blocks enter the ring in playing order per the PlaybackTransport. The
+ * walk begins shortly before the start sample (or the loop start, if
+ * earlier), just enough for the limiter to settle: only notes still
+ * sounding there or starting later are rendered, the ones already under
+ * way joining mid-note, so time to first sound doesn't grow with the
+ * start position. With a loop the rendered loop region is kept and
+ * pushed over and over once the timeline reaches the loop end (the
+ * stream then never finishes).
+ */
+class RenderStream
+{
+public:
+    // renderer must already be prepared; count = number of notes to play
+    RenderStream(std::unique_ptr<OfflineRenderer> renderer, const QVector<Note> &notes, int count,
+                 double sampleRate, double renderAheadMs = 300.0,
+                 const PlaybackTransport &transport = PlaybackTransport());
+    ~RenderStream();  // Stops the producer
+
+    // Start the producer thread and wait until the first block is ready
+    // (or the stream turns out to be empty)
+    void start();
+
+    // Ask the producer to stop and wait for it
+    void stop();
+
+    // Audio thread: copy up to frames interleaved stereo frames into out
+    // (which can be the device buffer), returns the frames copied
+    size_t read(float *out, size_t frames);
+
+    // Frames ready to read (a consumer that may wait, like an export, reads
+    // only these so it never counts underruns)
+    size_t framesAvailable() const { return ring.readAvailable() / 2; }
+
+    // True once the producer has pushed the last block and it's been read
+    bool isFinished() const;
+
+    size_t getTotalSamples() const { return totalSamples; }  // Frames
+    uint64_t getUnderrunCount() const { return underruns.load(std::memory_order_relaxed); }
+
+    // Samples per producer step
+    static constexpr size_t kBlockFrames = 1024;
+
+private:
+    void produce();
+
+    // Push interleaved stereo frames to the ring, waiting for room; false if stopped first
+    bool push(const float *frames, size_t frameCount);
+
+    std::unique_ptr<OfflineRenderer> renderer;
+    QVector<Note> notes;
+    size_t totalSamples;
+    PlaybackTransport transport;
+    SpscRingBuffer ring;
+
+    std::thread producer;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> producerDone;
+    std::atomic<uint64_t> underruns;
+
+    // Signals start() that the first block (or the end) is in the ring
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    bool firstBlockReady;
+};
+
+#endif // RENDERSTREAM_H
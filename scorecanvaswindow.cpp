@@ -14,6 +14,10 @@
 #include <QCursor>
 #include <QTimer>
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QCoreApplication>
 #include <cmath>
 
 ScoreCanvasWindow::ScoreCanvasWindow(AudioEngine *sharedAudioEngine, QWidget *parent)
@@ -42,6 +46,7 @@ ScoreCanvasWindow::ScoreCanvasWindow(AudioEngine *sharedAudioEngine, QWidget *pa
     , currentNoteIndex(0)
     , playbackStartTime(0.0)
     , playbackStartPosition(0.0)
+    , playbackOrigin(0.0)
     , isPlaying(false)
     , nextColorIndex(0)
 {
@@ -139,6 +144,9 @@ ScoreCanvasWindow::ScoreCanvasWindow(AudioEngine *sharedAudioEngine, QWidget *pa
     // Connect track selection to trigger pre-rendering
     connect(trackSelector, &TrackSelector::trackSelected, this, &ScoreCanvasWindow::onTrackSelected);
 
+    // Pan and width go straight to the audio engine's track buses
+    connect(trackSelector, &TrackSelector::trackMixChanged, this, &ScoreCanvasWindow::onTrackMixChanged);
+
     qDebug() << "ScoreCanvasWindow: Constructor complete";
 }
 
@@ -319,6 +327,8 @@ void ScoreCanvasWindow::setupCompositionSettings()
             this, &ScoreCanvasWindow::onCompositionSettingsTriggered);
     connect(ui->actionAddTrack, &QAction::triggered,
             this, &ScoreCanvasWindow::onAddTrackTriggered);
+    connect(ui->actionExportAudio, &QAction::triggered,
+            this, &ScoreCanvasWindow::onExportAudioTriggered);
 
     qDebug() << "ScoreCanvasWindow: Composition settings configured";
 }
@@ -1177,6 +1187,8 @@ void ScoreCanvasWindow::startPlayback()
     // Make sure audio is stopped from any other source
     audioEngine->stopNote();
 
+    syncTrackMixes();
+
     // Always start playback from the START POSITION (set by double-clicking timeline)
     // This returns to the same position every time, like a "playback anchor"
     playbackStartTime = playbackStartPosition;
@@ -1185,10 +1197,19 @@ void ScoreCanvasWindow::startPlayback()
     // Move the now marker to the start position
     timeline->setNowMarker(playbackStartTime);
 
-    // Filter notes to only include those at or after playback start position
+    // A loop the start position runs into is played by the audio engine. If
+    // playback starts inside the loop, the audio has to begin at the loop start
+    // so the notes it jumps back to are rendered too
+    bool looping = timeline->hasLoop() && timeline->getLoopEnd() > playbackStartPosition;
+    playbackOrigin = playbackStartPosition;
+    if (looping && timeline->getLoopStart() < playbackOrigin) {
+        playbackOrigin = timeline->getLoopStart();
+    }
+
+    // Filter notes to only include those at or after the audio origin
     QVector<Note> notesToPlay;
     for (const Note& note : notes) {
-        if (note.getStartTime() >= playbackStartPosition) {
+        if (note.getStartTime() >= playbackOrigin) {
             notesToPlay.append(note);
         }
     }
@@ -1198,25 +1219,27 @@ void ScoreCanvasWindow::startPlayback()
         return;
     }
 
-    // Adjust note times to be relative to playback start (offset to start at 0)
-    double timeOffset = playbackStartPosition;
+    // Adjust note times to be relative to the origin (offset to start at 0)
+    double timeOffset = playbackOrigin;
     QVector<Note> offsetNotes;
     for (Note note : notesToPlay) {
         note.setStartTime(note.getStartTime() - timeOffset);
         offsetNotes.append(note);
     }
 
-    // PRE-RENDER: Render all notes into a single continuous buffer
-    qDebug() << "=== ScoreCanvas: Pre-rendering" << offsetNotes.size() << "notes from position" << playbackStartPosition << "ms ===";
+    // STREAM: Render ahead of the playhead and start as soon as the first block is ready
+    qDebug() << "=== ScoreCanvas: Streaming" << offsetNotes.size() << "notes from position" << playbackStartPosition << "ms ===";
     for (int i = 0; i < offsetNotes.size(); i++) {
         qDebug() << "  Note" << i << ":" << offsetNotes[i].getPitchHz() << "Hz, start:"
                  << offsetNotes[i].getStartTime() << "ms, dur:" << offsetNotes[i].getDuration() << "ms";
     }
-    audioEngine->renderNotes(offsetNotes, offsetNotes.size());  // Render all notes
-
-    // Play the rendered buffer
-    qDebug() << "=== ScoreCanvas: Playing rendered buffer ===";
-    audioEngine->playRenderedBuffer();
+    PlaybackRange range;
+    range.startMs = playbackStartPosition - playbackOrigin;
+    if (looping) {
+        range.loopStartMs = timeline->getLoopStart() - playbackOrigin;
+        range.loopEndMs = timeline->getLoopEnd() - playbackOrigin;
+    }
+    audioEngine->streamNotes(offsetNotes, offsetNotes.size(), range);  // Stream all notes
 
     // Calculate total playback duration from rendered notes
     double totalDuration = 0.0;
@@ -1232,7 +1255,7 @@ void ScoreCanvasWindow::startPlayback()
     // Start the playback timer (tick every 10ms for smooth timing)
     playbackTimer->start(10);
 
-    qDebug() << "ScoreCanvas: Starting playback of" << offsetNotes.size() << "note(s) (rendered mode, total duration:" << totalDuration << "ms)";
+    qDebug() << "ScoreCanvas: Starting playback of" << offsetNotes.size() << "note(s) (streaming mode, total duration:" << totalDuration << "ms)";
 
     // Emit signal to stop other windows
     emit playbackStarted();
@@ -1242,37 +1265,12 @@ void ScoreCanvasWindow::onPlaybackTick()
 {
     if (!audioEngine || !isPlaying) return;
 
-    const QVector<Note>& notes = scoreCanvas->getPhrase().getNotes();
-
-    // Check if we've hit the loop end - if so, jump back to loop start
-    if (timeline->hasLoop()) {
-        double loopEnd = timeline->getLoopEnd();
-        if (playbackStartTime >= loopEnd) {
-            // Jump back to loop start
-            playbackStartTime = timeline->getLoopStart();
-
-            // Reset note index to find notes at loop start
-            currentNoteIndex = 0;
-            for (int i = 0; i < notes.size(); ++i) {
-                if (notes[i].getStartTime() >= playbackStartTime) {
-                    currentNoteIndex = i;
-                    break;
-                }
-            }
+    // The audio engine's transport counts the samples actually played (and
+    // applies the loop), so the marker follows the audio instead of the timer
+    playbackStartTime = playbackOrigin + audioEngine->getTransportTimeMs();
 
-            qDebug() << "ScoreCanvas: Looping back to" << playbackStartTime << "ms";
-        }
-    }
-
-    // Update timeline now marker (always advance, even if no notes)
+    // Update timeline now marker
     timeline->setNowMarker(playbackStartTime);
-
-    // Note: In pre-rendered mode, notes are already playing from the buffer
-    // We just need to update the timeline marker for visual feedback
-
-    // Always advance playback time (10ms per tick)
-    // Playback continues indefinitely until user manually stops
-    playbackStartTime += 10.0;
 }
 
 void ScoreCanvasWindow::stopPlayback(bool stopAudioEngine)
@@ -1517,6 +1515,82 @@ void ScoreCanvasWindow::onTrackSelected(int trackIndex)
     prerenderNotes();
 }
 
+void ScoreCanvasWindow::onTrackMixChanged(int trackIndex)
+{
+    if (!audioEngine) return;
+
+    const QVector<TrackSelector::Track>& tracks = trackSelector->getTracks();
+    if (trackIndex < 0 || trackIndex >= tracks.size()) return;
+
+    TrackMix mix;
+    mix.pan = tracks[trackIndex].pan;
+    mix.width = tracks[trackIndex].width;
+    mix.minFreqHz = tracks[trackIndex].minFreqHz;
+    mix.maxFreqHz = tracks[trackIndex].maxFreqHz;
+    audioEngine->setTrackMix(trackIndex, mix);
+}
+
+void ScoreCanvasWindow::syncTrackMixes()
+{
+    // Track indices shift when tracks are removed, so place every track again
+    for (const TrackSelector::Track &track : trackSelector->getTracks()) {
+        onTrackMixChanged(track.trackIndex);
+    }
+}
+
+void ScoreCanvasWindow::onExportAudioTriggered()
+{
+    if (!audioEngine) return;
+
+    const QVector<Note>& notes = scoreCanvas->getPhrase().getNotes();
+    if (notes.isEmpty()) {
+        QMessageBox::information(this, "Export Audio", "There are no notes to export.");
+        return;
+    }
+
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(
+        this,
+        "Export Audio",
+        "composition.wav",
+        "WAV 24-bit (*.wav);;WAV 32-bit float (*.wav)",
+        &selectedFilter
+    );
+
+    if (fileName.isEmpty()) {
+        return;  // User cancelled
+    }
+
+    if (!fileName.endsWith(".wav", Qt::CaseInsensitive)) {
+        fileName += ".wav";
+    }
+    WavWriter::Format format = selectedFilter.contains("float")
+                                   ? WavWriter::Format::Float32 : WavWriter::Format::Pcm24;
+
+    syncTrackMixes();
+
+    // The bounce runs here; the progress callback keeps the dialog responsive
+    QProgressDialog progressDialog("Exporting audio...", "Cancel", 0, 1000, this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(200);
+    auto progress = [&progressDialog](double fraction) {
+        progressDialog.setValue(static_cast<int>(fraction * 1000.0));
+        QCoreApplication::processEvents();
+        return !progressDialog.wasCanceled();
+    };
+
+    QString errorString;
+    bool ok = audioEngine->bounceNotes(notes, fileName, format, progress, &errorString);
+    progressDialog.setValue(1000);
+
+    if (ok) {
+        qDebug() << "ScoreCanvasWindow: Exported audio to" << fileName;
+    } else if (!progressDialog.wasCanceled()) {
+        QMessageBox::critical(this, "Export Error",
+            "Failed to export audio to:\n" + fileName + "\n\n" + errorString);
+    }
+}
+
 void ScoreCanvasWindow::prerenderNotes()
 {
     if (!audioEngine) return;
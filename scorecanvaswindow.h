@@ -39,6 +39,8 @@ private slots:
     void onCompositionSettingsTriggered();
     void onAddTrackTriggered();
     void onTrackSelected(int trackIndex);
+    void onTrackMixChanged(int trackIndex);
+    void onExportAudioTriggered();
 
 private:
     Ui::scorecanvas *ui;
@@ -89,6 +91,7 @@ private:
     int currentNoteIndex;
     double playbackStartTime;      // Current playback position
     double playbackStartPosition;  // Where playback should always start from (set by double-click)
+    double playbackOrigin;         // Timeline time of the first sample of the playing audio
     bool isPlaying;
 
     // Zoom state
@@ -138,6 +141,7 @@ private:
     void startPlayback();
     void onPlaybackTick();
     void prerenderNotes();  // Pre-render notes for current state (called on track change)
+    void syncTrackMixes();  // Send every track's pan and width to the audio engine
 
 public:
     // Expose ScoreCanvas for sharing notes with SounitBuilder
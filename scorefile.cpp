@@ -0,0 +1,66 @@
+#include "scorefile.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+
+bool ScoreFile::loadFromFile(const QString &filePath, QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) *errorString = "Failed to open " + filePath;
+        qWarning() << "Failed to open file for reading:" << filePath;
+        return false;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    file.close();
+    if (doc.isNull() || !doc.isObject()) {
+        if (errorString) *errorString = "Invalid JSON format in " + filePath;
+        qWarning() << "Invalid JSON format:" << filePath;
+        return false;
+    }
+    QJsonObject root = doc.object();
+
+    // Sounit paths are relative to the score
+    QDir scoreDir = QFileInfo(filePath).absoluteDir();
+
+    tracks.clear();
+    for (const QJsonValue &val : root["tracks"].toArray()) {
+        QJsonObject json = val.toObject();
+        Track track;
+        track.index = json["index"].toInt(tracks.size());
+        QString sounit = json["sounit"].toString();
+        if (!sounit.isEmpty()) {
+            track.sounitPath = scoreDir.absoluteFilePath(sounit);
+        }
+        track.mix.pan = std::clamp(json["pan"].toDouble(0.0), -1.0, 1.0);
+        track.mix.width = std::clamp(json["width"].toDouble(0.0), 0.0, 1.0);
+        track.mix.gain = json["gain"].toDouble(1.0);
+        track.mix.minFreqHz = json["minFreqHz"].toDouble(track.mix.minFreqHz);
+        track.mix.maxFreqHz = json["maxFreqHz"].toDouble(track.mix.maxFreqHz);
+        tracks.append(track);
+    }
+
+    notes.clear();
+    for (const QJsonValue &val : root["notes"].toArray()) {
+        notes.append(Note::fromJson(val.toObject()));
+    }
+    std::stable_sort(notes.begin(), notes.end(), [](const Note &a, const Note &b) {
+        return a.getStartTime() < b.getStartTime();
+    });
+
+    return true;
+}
+
+QMap<int, TrackMix> ScoreFile::trackMixes() const
+{
+    QMap<int, TrackMix> mixes;
+    for (const Track &track : tracks) {
+        mixes[track.index] = track.mix;
+    }
+    return mixes;
+}
@@ -0,0 +1,39 @@
+#ifndef SCOREFILE_H
+#define SCOREFILE_H
+
+#include "note.h"
+#include "trackmix.h"
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+/**
+ * ScoreFile - Notes and track setup for rendering outside the editor
+ *
+ * A JSON file with a "notes" array (see Note::toJson) and a "tracks"
+ * array. Each track names its index, the .sounit it plays (relative to
+ * the score file) and its mix:
+ *
+ *   { "tracks": [ { "index": 0, "sounit": "voice.sounit", "pan": -0.3, "width": 0.2 } ],
+ *     "notes":  [ { "startTime": 0, "duration": 800, "pitchHz": 220, "trackIndex": 0 } ] }
+ *
+ * Read by calamus-render; tracks without a sounit play the default generator.
+ */
+struct ScoreFile {
+    struct Track {
+        int index = 0;
+        QString sounitPath;  // Absolute, or empty for none
+        TrackMix mix;
+    };
+
+    QVector<Track> tracks;
+    QVector<Note> notes;  // Sorted by start time
+
+    bool loadFromFile(const QString &filePath, QString *errorString = nullptr);
+
+    // Mix of every listed track, for OfflineRenderer::setTrackMixes
+    QMap<int, TrackMix> trackMixes() const;
+};
+
+#endif // SCOREFILE_H
@@ -140,7 +140,7 @@ void SounitBuilder::rebuildGraph(int trackIndex)
 {
     if (audioEngine && canvas) {
         qDebug() << "SounitBuilder: Rebuilding graph from canvas for track" << trackIndex;
-        bool isValid = audioEngine->buildGraph(canvas, trackIndex);
+        bool isValid = audioEngine->buildGraph(canvas->describe(), trackIndex);
 
         // Show warning if graph is invalid AND canvas has containers
         // (Don't show warning on startup when canvas is empty)
@@ -221,8 +221,8 @@ void SounitBuilder::onAddContainer(const QString &name, const QColor &color,
     connect(newContainer, &Container::portClicked, this, &SounitBuilder::onPortClicked);
     connect(newContainer, &Container::clicked, canvas, &Canvas::selectContainer);
     connect(newContainer, &Container::moved, canvas, QOverload<>::of(&QWidget::update));
-    connect(newContainer, &Container::parameterChanged, this, [this]() {
-        rebuildGraph(0);  // Default track for Sound Engine editing
+    connect(newContainer, &Container::parameterChanged, this, [this, newContainer]() {
+        onContainerParameterChanged(newContainer);
     });
 
     containers.append(newContainer);
@@ -299,12 +299,9 @@ void SounitBuilder::startPlayback()
     // Make sure audio is stopped from any other source
     audioEngine->stopNote();
 
-    // PRE-RENDER: Render all notes into a single continuous buffer
-    qDebug() << "SounitBuilder: Pre-rendering notes...";
-    audioEngine->renderNotes(notes, notes.size());  // Render all notes
-
-    // Play the rendered buffer
-    audioEngine->playRenderedBuffer();
+    // STREAM: Render ahead of the playhead and start as soon as the first block is ready
+    qDebug() << "SounitBuilder: Streaming notes...";
+    audioEngine->streamNotes(notes, notes.size());  // Stream all notes
 
     // Calculate total playback duration from all notes
     double totalDuration = 0.0;
@@ -325,7 +322,7 @@ void SounitBuilder::startPlayback()
     // Start the playback timer (tick every 10ms for smooth timing)
     playbackTimer->start(10);
 
-    qDebug() << "SounitBuilder: Starting playback of" << notes.size() << "note(s) (rendered mode, total duration:" << totalDuration << "ms)";
+    qDebug() << "SounitBuilder: Starting playback of" << notes.size() << "note(s) (streaming mode, total duration:" << totalDuration << "ms)";
 
     // Emit signal to stop other windows
     emit playbackStarted();
@@ -335,18 +332,16 @@ void SounitBuilder::onPlaybackTick()
 {
     if (!audioEngine || !isPlaying) return;
 
-    // With pre-rendered buffer playback, we don't need to trigger individual notes
+    // With streamed (or pre-rendered) playback, we don't need to trigger individual notes
     // The audio callback automatically plays through the entire rendered buffer
-    // This timer just checks if playback has finished
+    // This timer just follows the transport and checks if playback has finished
+    playbackStartTime = audioEngine->getTransportTimeMs();
 
-    // Check if we've exceeded the total duration
-    if (playbackStartTime >= noteDuration) {
+    // Check if the audio has played to the end
+    if (!audioEngine->isTransportRunning() || playbackStartTime >= noteDuration) {
         stopPlayback();
         return;
     }
-
-    // Advance playback time (10ms per tick)
-    playbackStartTime += 10.0;
 }
 
 void SounitBuilder::stopPlayback(bool stopAudioEngine)
@@ -415,11 +410,22 @@ void SounitBuilder::connectContainerSignals(Container *container)
     connect(container, &Container::portClicked, this, &SounitBuilder::onPortClicked);
     connect(container, &Container::clicked, canvas, &Canvas::selectContainer);
     connect(container, &Container::moved, canvas, QOverload<>::of(&QWidget::update));
-    connect(container, &Container::parameterChanged, this, [this]() {
-        rebuildGraph(0);  // Default track for Sound Engine editing
+    connect(container, &Container::parameterChanged, this, [this, container]() {
+        onContainerParameterChanged(container);
     });
 }
 
+void SounitBuilder::onContainerParameterChanged(Container *container)
+{
+    // Parameter edits only refresh that container's snapshot in the graph;
+    // fall back to a full rebuild if the graph doesn't know the container
+    // (track 0 is the default track for Sound Engine editing)
+    if (audioEngine && audioEngine->updateGraphParameters(container->describe(), 0)) {
+        return;
+    }
+    rebuildGraph(0);
+}
+
 SounitBuilder::~SounitBuilder()
 {
     delete ui;
@@ -72,6 +72,7 @@ private slots:
     void onPlay();
     void onStop();
     void onPlaybackTick();
+    void onContainerParameterChanged(Container *container);
 
 public slots:
     void stopPlayback(bool stopAudioEngine = true);
@@ -0,0 +1,174 @@
+#include "sounitdescription.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+bool SounitDescription::loadFromFile(const QString &filePath, QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) *errorString = "Failed to open " + filePath;
+        qWarning() << "Failed to open file for reading:" << filePath;
+        return false;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    file.close();
+    if (doc.isNull() || !doc.isObject()) {
+        if (errorString) *errorString = "Invalid JSON format in " + filePath;
+        qWarning() << "Invalid JSON format:" << filePath;
+        return false;
+    }
+
+    *this = fromJson(doc.object());
+    return true;
+}
+
+SounitDescription SounitDescription::fromJson(const QJsonObject &root)
+{
+    SounitDescription description;
+
+    QJsonObject sounitMeta = root["sounit"].toObject();
+    description.name = sounitMeta["name"].toString("Untitled Sounit");
+    description.comment = sounitMeta["comment"].toString("");
+
+    // Nodes, numbered from 1 in file order
+    QMap<QString, int> nodeIndex;  // instanceName -> index into nodes
+    QJsonArray containersArray = root["containers"].toArray();
+    for (const QJsonValue &val : containersArray) {
+        QJsonObject json = val.toObject();
+
+        Node node;
+        node.type = json["type"].toString();
+        node.instanceName = json["instanceName"].toString();
+
+        QStringList inputs, outputs;
+        if (!portsForType(node.type, inputs, outputs)) {
+            qWarning() << "Cannot deserialize unknown container type:" << node.type;
+            continue;
+        }
+
+        QJsonObject params = json["parameters"].toObject();
+        for (auto it = params.begin(); it != params.end(); ++it) {
+            node.parameters[it.key()] = it.value().toDouble();
+        }
+
+        // Custom DNA, stored as parameters like the container keeps it
+        if (json.contains("customDna")) {
+            QJsonObject customDna = json["customDna"].toObject();
+            int count = customDna["count"].toInt();
+            QJsonArray amps = customDna["amplitudes"].toArray();
+
+            node.parameters["customDnaCount"] = static_cast<double>(count);
+            node.parameters["dnaSelect"] = -1.0;  // Mark as custom
+            for (int i = 0; i < count && i < amps.size(); i++) {
+                node.parameters[QString("customDna_%1").arg(i)] = amps[i].toDouble();
+            }
+        }
+
+        if (json.contains("customEnvelope")) {
+            QJsonArray pointsArray = json["customEnvelope"].toObject()["points"].toArray();
+            for (const QJsonValue &ptVal : pointsArray) {
+                QJsonObject ptObj = ptVal.toObject();
+                node.customEnvelope.append(EnvelopePoint(ptObj["time"].toDouble(),
+                                                         ptObj["value"].toDouble(),
+                                                         ptObj["curveType"].toInt()));
+            }
+        }
+
+        // Duplicate instance names: connections resolve to the first one
+        if (nodeIndex.contains(node.instanceName)) {
+            qWarning() << "Duplicate instance name detected:" << node.instanceName;
+        } else {
+            nodeIndex[node.instanceName] = description.nodes.size();
+        }
+
+        node.id = static_cast<uint64_t>(description.nodes.size() + 1);
+        description.nodes.append(node);
+    }
+
+    // Connections between known nodes and ports
+    QJsonArray connectionsArray = root["connections"].toArray();
+    int skippedConnections = 0;
+    for (const QJsonValue &val : connectionsArray) {
+        QJsonObject connJson = val.toObject();
+
+        QString fromName = connJson["fromContainer"].toString();
+        QString toName = connJson["toContainer"].toString();
+        if (!nodeIndex.contains(fromName) || !nodeIndex.contains(toName)) {
+            qWarning() << "Connection references missing container:" << fromName << "->" << toName;
+            skippedConnections++;
+            continue;
+        }
+
+        Connection conn;
+        conn.fromNode = nodeIndex[fromName];
+        conn.fromPort = connJson["fromPort"].toString();
+        conn.toNode = nodeIndex[toName];
+        conn.toPort = connJson["toPort"].toString();
+        conn.function = connJson["function"].toString("passthrough");
+        conn.weight = connJson["weight"].toDouble(1.0);
+
+        QStringList fromInputs, fromOutputs, toInputs, toOutputs;
+        portsForType(description.nodes[conn.fromNode].type, fromInputs, fromOutputs);
+        portsForType(description.nodes[conn.toNode].type, toInputs, toOutputs);
+        if (!fromOutputs.contains(conn.fromPort) || !toInputs.contains(conn.toPort)) {
+            qWarning() << "Invalid port in connection:" << fromName << conn.fromPort
+                       << "->" << toName << conn.toPort;
+            skippedConnections++;
+            continue;
+        }
+
+        description.connections.append(conn);
+    }
+
+    if (skippedConnections > 0) {
+        qWarning() << "Skipped" << skippedConnections << "invalid connections during load";
+    }
+
+    return description;
+}
+
+bool SounitDescription::portsForType(const QString &type, QStringList &inputs, QStringList &outputs)
+{
+    if (type == "Harmonic Generator") {
+        inputs = {"purity", "drift"};
+        outputs = {"spectrum"};
+    } else if (type == "Spectrum to Signal") {
+        inputs = {"spectrumIn", "pitch", "normalize"};
+        outputs = {"signalOut"};
+    } else if (type == "Rolloff Processor") {
+        inputs = {"spectrumIn", "rolloff"};
+        outputs = {"spectrumOut"};
+    } else if (type == "Formant Body") {
+        inputs = {"signalIn", "f1Freq", "f2Freq", "f1Q", "f2Q", "directMix", "f1f2Balance"};
+        outputs = {"signalOut"};
+    } else if (type == "Breath Turbulence") {
+        inputs = {"voiceIn", "noiseIn", "blend"};
+        outputs = {"signalOut"};
+    } else if (type == "Noise Color Filter") {
+        inputs = {"audioIn", "color", "filterQ"};
+        outputs = {"noiseOut"};
+    } else if (type == "Physics System") {
+        inputs = {"targetValue", "mass", "springK", "damping", "impulse", "impulseAmount"};
+        outputs = {"currentValue"};
+    } else if (type == "Easing Applicator") {
+        inputs = {"startValue", "endValue", "progress", "easingSelect"};
+        outputs = {"easedValue"};
+    } else if (type == "Envelope Engine") {
+        inputs = {"timeScale", "valueScale", "valueOffset"};
+        outputs = {"envelopeValue"};
+    } else if (type == "Drift Engine") {
+        inputs = {"amount", "rate"};
+        outputs = {"driftOut"};
+    } else if (type == "Gate Processor") {
+        inputs = {"velocity", "attackTime", "releaseTime", "attackCurve", "releaseCurve", "velocitySens"};
+        outputs = {"envelopeOut", "stateOut", "attackTrigger", "releaseTrigger"};
+    } else {
+        inputs.clear();
+        outputs.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef SOUNITDESCRIPTION_H
+#define SOUNITDESCRIPTION_H
+
+#include "envelopedata.h"
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdint>
+
+/**
+ * SounitDescription - Plain-data model of a sounit graph
+ *
+ * Nodes (container type, parameters, custom envelope) and the connections
+ * between their ports, without any widgets. It is what SounitGraph
+ * compiles, and it can come from the Sounit Builder canvas
+ * (Canvas::describe()) or straight from a .sounit file (loadFromFile()),
+ * so a graph can be built without a QApplication.
+ *
+ * Node ids identify a node across descriptions of the same sounit, for
+ * SounitGraph::updateParameters(). The canvas uses each container's id;
+ * a loaded file numbers its nodes from 1.
+ */
+struct SounitDescription {
+    struct Node {
+        uint64_t id = 0;
+        QString type;          // Container type, e.g. "Harmonic Generator"
+        QString instanceName;  // Unique within the sounit
+        QMap<QString, double> parameters;
+        QVector<EnvelopePoint> customEnvelope;  // Empty = none
+
+        double parameter(const QString &name, double defaultValue = 0.0) const
+        {
+            return parameters.value(name, defaultValue);
+        }
+    };
+
+    struct Connection {
+        int fromNode = -1;  // Index into nodes
+        QString fromPort;
+        int toNode = -1;    // Index into nodes
+        QString toPort;
+        QString function = "passthrough";
+        double weight = 1.0;
+    };
+
+    QString name = "Untitled Sounit";
+    QString comment;
+    QVector<Node> nodes;
+    QVector<Connection> connections;
+
+    // Read a .sounit file (the format Canvas::saveToJson writes)
+    bool loadFromFile(const QString &filePath, QString *errorString = nullptr);
+    static SounitDescription fromJson(const QJsonObject &root);
+
+    // Input and output ports of a container type (false = unknown type)
+    static bool portsForType(const QString &type, QStringList &inputs, QStringList &outputs);
+};
+
+#endif // SOUNITDESCRIPTION_H
@@ -1,132 +1,282 @@
 #include "sounitgraph.h"
+#include "contenthash.h"
 #include <QDebug>
 #include <QSet>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
-// Helper function to apply connection functions
-static double applyConnectionFunction(double currentValue, double sourceValue,
-                                     const QString& function, double weight)
+// Clamp range for ports that are not bounded
+static constexpr double kUnbounded = std::numeric_limits<double>::infinity();
+
+// Stable hash of a node's instance name (unique within a sounit, and the
+// same whether the sounit came from the canvas or a file)
+static uint64_t instanceSeedKey(const QString &instanceName)
 {
-    if (function == "passthrough") {
+    uint64_t hash = 0;
+    for (unsigned char c : instanceName.toStdString()) {
+        hash = ContentHash::combine(hash, static_cast<uint64_t>(c));
+    }
+    return hash;
+}
+
+// Apply a connection function to combine an input with a source value
+double SounitGraph::applyConnectionFunction(double currentValue, double sourceValue,
+                                            ConnectionFunction function, double weight)
+{
+    switch (function) {
+    case ConnectionFunction::Passthrough:
         // Source replaces input entirely (ignores weight)
         return sourceValue;
-    } else if (function == "add") {
+    case ConnectionFunction::Add:
         // Input + source × weight
         return currentValue + sourceValue * weight;
-    } else if (function == "multiply") {
+    case ConnectionFunction::Multiply:
         // Input × source × weight
         return currentValue * sourceValue * weight;
-    } else if (function == "subtract") {
+    case ConnectionFunction::Subtract:
         // Input - source × weight
         return currentValue - sourceValue * weight;
-    } else if (function == "replace") {
+    case ConnectionFunction::Replace:
         // Weighted blend: input × (1-weight) + source × weight
         return currentValue * (1.0 - weight) + sourceValue * weight;
-    } else if (function == "modulate") {
+    case ConnectionFunction::Modulate:
         // Bipolar modulation around input: input + (source - 0.5) × weight × range
         // Using range = 2.0 for full bipolar range
         return currentValue + (sourceValue - 0.5) * weight * 2.0;
     }
 
-    // Unknown function, default to passthrough
     return sourceValue;
 }
 
-SounitGraph::SounitGraph(double sampleRate)
-    : sampleRate(sampleRate)
-    , hasValidSignalOutput(false)
+SounitGraph::NodeType SounitGraph::nodeTypeFromName(const QString &name)
 {
+    if (name == "Harmonic Generator") return NodeType::HarmonicGenerator;
+    if (name == "Rolloff Processor") return NodeType::RolloffProcessor;
+    if (name == "Spectrum to Signal") return NodeType::SpectrumToSignal;
+    if (name == "Formant Body") return NodeType::FormantBody;
+    if (name == "Breath Turbulence") return NodeType::BreathTurbulence;
+    if (name == "Noise Color Filter") return NodeType::NoiseColorFilter;
+    if (name == "Physics System") return NodeType::PhysicsSystem;
+    if (name == "Envelope Engine") return NodeType::EnvelopeEngine;
+    if (name == "Drift Engine") return NodeType::DriftEngine;
+    if (name == "Gate Processor") return NodeType::GateProcessor;
+    if (name == "Easing Applicator") return NodeType::EasingApplicator;
+    return NodeType::Unknown;
 }
 
-void SounitGraph::buildFromCanvas(Canvas *canvas)
+SounitGraph::InputPort SounitGraph::inputPortFromName(const QString &name)
 {
-    qDebug() << "SounitGraph::buildFromCanvas - START";
+    static const QMap<QString, InputPort> ports = {
+        {"spectrumIn", InputPort::SpectrumIn},
+        {"signalIn", InputPort::SignalIn},
+        {"voiceIn", InputPort::VoiceIn},
+        {"noiseIn", InputPort::NoiseIn},
+        {"audioIn", InputPort::AudioIn},
+        {"purity", InputPort::Purity},
+        {"drift", InputPort::Drift},
+        {"rolloff", InputPort::Rolloff},
+        {"pitch", InputPort::Pitch},
+        {"f1Freq", InputPort::F1Freq},
+        {"f2Freq", InputPort::F2Freq},
+        {"f1Q", InputPort::F1Q},
+        {"f2Q", InputPort::F2Q},
+        {"directMix", InputPort::DirectMix},
+        {"f1f2Balance", InputPort::F1F2Balance},
+        {"blend", InputPort::Blend},
+        {"color", InputPort::Color},
+        {"filterQ", InputPort::FilterQ},
+        {"targetValue", InputPort::TargetValue},
+        {"mass", InputPort::Mass},
+        {"springK", InputPort::SpringK},
+        {"damping", InputPort::Damping},
+        {"impulse", InputPort::Impulse},
+        {"impulseAmount", InputPort::ImpulseAmount},
+        {"timeScale", InputPort::TimeScale},
+        {"valueScale", InputPort::ValueScale},
+        {"valueOffset", InputPort::ValueOffset},
+        {"amount", InputPort::Amount},
+        {"rate", InputPort::Rate},
+        {"startValue", InputPort::StartValue},
+        {"endValue", InputPort::EndValue},
+        {"progress", InputPort::Progress}
+    };
+    return ports.value(name, InputPort::Unknown);
+}
 
-    processors.clear();
-    executionOrder.clear();
-    signalOutputContainer = nullptr;
-    hasValidSignalOutput = false;
+SounitGraph::OutputPort SounitGraph::outputPortFromName(const QString &name)
+{
+    // Gate Processor has multiple named outputs
+    if (name == "envelopeOut") return OutputPort::GateEnvelope;
+    if (name == "stateOut") return OutputPort::GateState;
+    if (name == "attackTrigger") return OutputPort::GateAttackTrigger;
+    if (name == "releaseTrigger") return OutputPort::GateReleaseTrigger;
 
-    if (!canvas) {
-        qDebug() << "SounitGraph::buildFromCanvas - canvas is null!";
-        return;
+    // Default: check if it's a signal or control output
+    if (name == "signalOut" || name.contains("signal", Qt::CaseInsensitive)) {
+        return OutputPort::Signal;
     }
 
-    qDebug() << "SounitGraph: Finding containers...";
-    // Create processor data for each container
-    QList<Container*> containers = canvas->findChildren<Container*>();
-    qDebug() << "SounitGraph: Found" << containers.size() << "containers";
-
-    for (Container *container : containers) {
-        qDebug() << "  - Container:" << container->getName();
-        ProcessorData data;
-        data.container = container;
-        processors[container] = data;
-    }
+    // Default to controlOut for any other named output
+    return OutputPort::Control;
+}
 
-    qDebug() << "SounitGraph: Computing execution order...";
-    // Compute execution order
-    computeExecutionOrder(canvas);
+SounitGraph::ConnectionFunction SounitGraph::connectionFunctionFromName(const QString &name)
+{
+    if (name == "add") return ConnectionFunction::Add;
+    if (name == "multiply") return ConnectionFunction::Multiply;
+    if (name == "subtract") return ConnectionFunction::Subtract;
+    if (name == "replace") return ConnectionFunction::Replace;
+    if (name == "modulate") return ConnectionFunction::Modulate;
+
+    // "passthrough" and unknown functions
+    return ConnectionFunction::Passthrough;
+}
 
-    qDebug() << "SounitGraph: Creating processors...";
-    // Create processor instances
-    createProcessors();
+SounitGraph::SounitGraph(double sampleRate)
+    : sampleRate(sampleRate)
+    , program(std::make_shared<Program>())
+{
+    instantiate();
+}
 
-    qDebug() << "SounitGraph: Built graph with" << processors.size() << "containers";
-    qDebug() << "SounitGraph: Execution order:" << executionOrder.size() << "containers";
-    qDebug() << "SounitGraph: Valid signal output:" << hasValidSignalOutput;
+void SounitGraph::setControlInterval(int samples)
+{
+    // Power of two, so control ticks line up with kMaxBlockFrames chunks
+    samples = std::clamp(samples, 1, kMaxBlockFrames);
+    int interval = 1;
+    while (interval * 2 <= samples) {
+        interval *= 2;
+    }
+    controlInterval = interval;
 }
 
-void SounitGraph::computeExecutionOrder(Canvas *canvas)
+SounitGraph::Rate SounitGraph::nodeRate(NodeType type)
 {
-    // Proper topological sort using Kahn's algorithm
-    // This follows actual connections instead of fixed type-based ordering
+    switch (type) {
+    case NodeType::EnvelopeEngine:
+    case NodeType::DriftEngine:
+    case NodeType::GateProcessor:
+    case NodeType::EasingApplicator:
+        return Rate::Control;
+    default:
+        // Physics System stays at audio rate: its spring constants are per sample
+        return Rate::Audio;
+    }
+}
 
-    if (!canvas) {
-        qDebug() << "SounitGraph::computeExecutionOrder - canvas is null";
-        return;
+bool SounitGraph::isModulationPort(InputPort port)
+{
+    switch (port) {
+    case InputPort::SpectrumIn:
+    case InputPort::SignalIn:
+    case InputPort::VoiceIn:
+    case InputPort::NoiseIn:
+    case InputPort::AudioIn:
+    case InputPort::Impulse:
+    case InputPort::Unknown:
+        return false;
+    default:
+        return true;
     }
+}
 
-    // Build dependency graph
-    // Key: container, Value: set of containers that depend on it (outgoing edges)
-    QMap<Container*, QSet<Container*>> dependents;
-    // Key: container, Value: number of incoming edges (dependencies)
-    QMap<Container*, int> incomingEdgeCount;
+void SounitGraph::build(const SounitDescription &description)
+{
+    qDebug() << "SounitGraph::build - START" << description.name;
+
+    auto compiled = std::make_shared<Program>();
+    compiled->sampleRate = sampleRate;
+    compiled->controlInterval = controlInterval;
+    compiled->oversampling = oversampling;
+
+    qDebug() << "SounitGraph: Compiling execution plan...";
+    if (compileNodes(description, *compiled)) {
+        qDebug() << "SounitGraph: Creating processors...";
+        compiled->bufferSize = kNodeBufferOffset;
+        compiled->initialState.resize(compiled->nodes.size());
+        for (size_t n = 0; n < compiled->nodes.size(); n++) {
+            NodePlan &plan = compiled->nodes[n];
+            allocateBuffers(*compiled, plan);
+            createProcessor(*compiled, plan, compiled->initialState[n]);
+        }
 
-    // Initialize all containers with zero incoming edges
-    for (Container *container : processors.keys()) {
-        incomingEdgeCount[container] = 0;
-        dependents[container] = QSet<Container*>();
+        qDebug() << "SounitGraph: Built graph with" << compiled->nodes.size() << "nodes";
+        qDebug() << "SounitGraph: Valid signal output:" << compiled->hasValidSignalOutput;
+    } else {
+        // Leave an empty (invalid) program behind
+        *compiled = Program();
+        compiled->sampleRate = sampleRate;
+        compiled->controlInterval = controlInterval;
+        compiled->oversampling = oversampling;
     }
 
-    // Build the graph from connections
-    const QVector<Canvas::Connection>& connections = canvas->getConnections();
-    for (const Canvas::Connection &conn : connections) {
-        // Connection goes from output to input, so fromContainer must execute before toContainer
-        if (processors.contains(conn.fromContainer) && processors.contains(conn.toContainer)) {
-            // Add edge: fromContainer → toContainer
-            dependents[conn.fromContainer].insert(conn.toContainer);
-            incomingEdgeCount[conn.toContainer]++;
+    // Become the first voice of the new program
+    program = compiled;
+    instantiate();
+}
+
+std::unique_ptr<SounitGraph> SounitGraph::createVoice() const
+{
+    auto voice = std::make_unique<SounitGraph>(sampleRate);
+    voice->controlInterval = controlInterval;
+    voice->controlSmoothing = controlSmoothing;
+    voice->oversampling = oversampling;
+    voice->program = program;
+    voice->instantiate();
+    return voice;
+}
+
+void SounitGraph::instantiate()
+{
+    // Buffers and spectrum rows for the program's layout, processors from its initial state
+    buffers.assign(std::max(program->bufferSize, kNodeBufferOffset), 0.0);
+    spectra.assign(program->spectrumRows, Spectrum());
+    reset();
+}
+
+bool SounitGraph::compileNodes(const SounitDescription &description, Program &compiled)
+{
+    const QVector<SounitDescription::Node> &nodes = description.nodes;
+    const QVector<SounitDescription::Connection> &connections = description.connections;
+    qDebug() << "SounitGraph: Found" << nodes.size() << "containers";
+
+    // Only connections between nodes of this description count
+    auto isValidConnection = [&nodes](const SounitDescription::Connection &conn) {
+        return conn.fromNode >= 0 && conn.fromNode < nodes.size()
+               && conn.toNode >= 0 && conn.toNode < nodes.size();
+    };
+
+    // Proper topological sort using Kahn's algorithm
+    // This follows actual connections instead of fixed type-based ordering
+    // Outgoing edges and incoming edge counts, indexed like nodes
+    QVector<QVector<int>> dependents(nodes.size());
+    QVector<int> incomingEdgeCount(nodes.size(), 0);
+
+    for (const SounitDescription::Connection &conn : connections) {
+        // Connection goes from output to input, so fromNode must execute before toNode
+        if (isValidConnection(conn)) {
+            if (!dependents[conn.fromNode].contains(conn.toNode)) {
+                dependents[conn.fromNode].append(conn.toNode);
+                incomingEdgeCount[conn.toNode]++;
+            }
         }
     }
 
-    // Kahn's algorithm: Start with containers that have no dependencies
-    QVector<Container*> queue;
-    for (Container *container : processors.keys()) {
-        if (incomingEdgeCount[container] == 0) {
-            queue.append(container);
+    // Kahn's algorithm: Start with nodes that have no dependencies
+    QVector<int> queue;
+    for (int i = 0; i < nodes.size(); i++) {
+        if (incomingEdgeCount[i] == 0) {
+            queue.append(i);
         }
     }
 
-    // Process queue
-    executionOrder.clear();
+    QVector<int> order;
     while (!queue.isEmpty()) {
-        // Remove a container with no incoming edges
-        Container *current = queue.takeFirst();
-        executionOrder.append(current);
+        int current = queue.takeFirst();
+        order.append(current);
 
-        // Remove edges from current to its dependents
-        for (Container *dependent : dependents[current]) {
+        for (int dependent : dependents[current]) {
             incomingEdgeCount[dependent]--;
             if (incomingEdgeCount[dependent] == 0) {
                 queue.append(dependent);
@@ -135,871 +285,1014 @@ void SounitGraph::computeExecutionOrder(Canvas *canvas)
     }
 
     // Check for cycles
-    if (executionOrder.size() != processors.size()) {
-        qDebug() << "SounitGraph::computeExecutionOrder - WARNING: Cycle detected!";
-        qDebug() << "  Processed" << executionOrder.size() << "containers, but" << processors.size() << "total";
+    if (order.size() != nodes.size()) {
+        qDebug() << "SounitGraph::compileNodes - WARNING: Cycle detected!";
+        qDebug() << "  Processed" << order.size() << "containers, but" << nodes.size() << "total";
         qDebug() << "  Containers in cycle:";
-        for (Container *container : processors.keys()) {
-            if (!executionOrder.contains(container)) {
-                qDebug() << "    -" << container->getName() << "(" << container->getInstanceName() << ")";
+        for (int i = 0; i < nodes.size(); i++) {
+            if (!order.contains(i)) {
+                qDebug() << "    -" << nodes[i].type << "(" << nodes[i].instanceName << ")";
             }
         }
-        // Continue anyway with partial order, but mark as invalid
-        hasValidSignalOutput = false;
-        return;
+        return false;
     }
 
-    // Find the signal output container
-    // Look for containers with "signalOut" port that have no outgoing signal connections
-    // or simply the last container in execution order that has a signalOut port
-    signalOutputContainer = nullptr;
-
-    // Check containers in reverse execution order (last executed first)
-    for (int i = executionOrder.size() - 1; i >= 0; i--) {
-        Container *container = executionOrder[i];
-        QStringList outputs = container->getOutputPorts();
-
-        // Check if this container has a signalOut port
-        if (outputs.contains("signalOut")) {
-            // Check if this port has any outgoing connections
-            bool hasOutgoingSignal = false;
-            for (const Canvas::Connection &conn : connections) {
-                if (conn.fromContainer == container && conn.fromPort == "signalOut") {
-                    hasOutgoingSignal = true;
-                    break;
-                }
-            }
+    // Lay out nodes contiguously in execution order
+    QVector<int> nodeIndexOf(nodes.size(), -1);
+    compiled.nodes.resize(order.size());
+    for (int n = 0; n < order.size(); n++) {
+        const SounitDescription::Node &node = nodes[order[n]];
+        compiled.nodes[n].type = nodeTypeFromName(node.type);
+        compiled.nodes[n].nodeId = node.id;
+        compiled.nodes[n].typeName = node.type;
+        compiled.nodes[n].instanceName = node.instanceName;
+        compiled.nodes[n].seedKey = instanceSeedKey(node.instanceName);
+        readParameters(compiled.nodes[n], node);
+        nodeIndexOf[order[n]] = n;
+    }
+
+    // Resolve every connection into an input slot on its target node
+    for (const SounitDescription::Connection &conn : connections) {
+        if (!isValidConnection(conn)) {
+            continue;
+        }
+
+        InputSlot slot;
+        slot.port = inputPortFromName(conn.toPort);
+        slot.sourceNode = nodeIndexOf[conn.fromNode];
+        slot.function = connectionFunctionFromName(conn.function);
+        slot.weight = conn.weight;
+
+        switch (slot.port) {
+        case InputPort::SpectrumIn:
+            slot.sourcePort = OutputPort::Spectrum;
+            break;
+        case InputPort::SignalIn:
+        case InputPort::VoiceIn:
+        case InputPort::NoiseIn:
+        case InputPort::AudioIn:
+            slot.sourcePort = OutputPort::Signal;
+            break;
+        case InputPort::Impulse:
+            // Impulse reads the specific source port (e.g. Gate attackTrigger)
+            slot.sourcePort = outputPortFromName(conn.fromPort);
+            break;
+        default:
+            slot.sourcePort = OutputPort::Control;
+            break;
+        }
+
+        if (slot.port == InputPort::Unknown) {
+            qDebug() << "SounitGraph: Ignoring connection to unknown port" << conn.toPort;
+            continue;
+        }
+
+        compiled.nodes[nodeIndexOf[conn.toNode]].inputs.push_back(slot);
+    }
+
+    // Find the signal output node
+    // Look for the last node in execution order with a "signalOut" port
+    // that has no outgoing signal connections
+    for (int n = static_cast<int>(compiled.nodes.size()) - 1; n >= 0; n--) {
+        int nodeIdx = order[n];
+        QStringList inputs, outputs;
+        SounitDescription::portsForType(nodes[nodeIdx].type, inputs, outputs);
+        if (!outputs.contains("signalOut")) {
+            continue;
+        }
 
-            // If no outgoing signal connection, this is likely the final output
-            if (!hasOutgoingSignal) {
-                signalOutputContainer = container;
-                hasValidSignalOutput = true;
-                qDebug() << "SounitGraph: Signal output container:" << container->getName()
-                         << "(" << container->getInstanceName() << ")";
+        bool hasOutgoingSignal = false;
+        for (const SounitDescription::Connection &conn : connections) {
+            if (conn.fromNode == nodeIdx && conn.fromPort == "signalOut") {
+                hasOutgoingSignal = true;
                 break;
             }
         }
+
+        // If no outgoing signal connection, this is likely the final output
+        if (!hasOutgoingSignal) {
+            compiled.outputNode = n;
+            compiled.hasValidSignalOutput = true;
+            qDebug() << "SounitGraph: Signal output container:" << nodes[nodeIdx].type
+                     << "(" << nodes[nodeIdx].instanceName << ")";
+            break;
+        }
     }
 
     // Debug output
     qDebug() << "SounitGraph: Topological sort complete";
     qDebug() << "  Execution order:";
-    for (int i = 0; i < executionOrder.size(); i++) {
-        Container *c = executionOrder[i];
-        qDebug() << "    " << (i+1) << "." << c->getName() << "(" << c->getInstanceName() << ")";
+    for (size_t n = 0; n < compiled.nodes.size(); n++) {
+        qDebug() << "    " << (n + 1) << "." << compiled.nodes[n].typeName
+                 << "(" << compiled.nodes[n].instanceName << ")"
+                 << compiled.nodes[n].inputs.size() << "input(s)";
     }
 
-    if (!hasValidSignalOutput) {
+    if (!compiled.hasValidSignalOutput) {
         qDebug() << "SounitGraph: WARNING - No valid signal output found!";
     }
+
+    return true;
 }
 
-void SounitGraph::createProcessors()
+void SounitGraph::allocateBuffers(Program &compiled, NodePlan &plan)
 {
-    for (auto it = processors.begin(); it != processors.end(); ++it) {
-        Container *container = it.key();
-        ProcessorData &data = it.value();
+    plan.rate = nodeRate(plan.type);
+
+    // Parameters change as fast as the fastest source modulating them
+    plan.modulationRate = Rate::Block;
+    Rate purityRate = Rate::Block;
+    Rate rolloffRate = Rate::Block;
+    for (const InputSlot &slot : plan.inputs) {
+        if (!isModulationPort(slot.port)) {
+            continue;
+        }
+        Rate sourceRate = compiled.nodes[slot.sourceNode].rate;
+        plan.modulationRate = std::max(plan.modulationRate, sourceRate);
+        if (slot.port == InputPort::Purity) {
+            purityRate = std::max(purityRate, sourceRate);
+        } else if (slot.port == InputPort::Rolloff) {
+            rolloffRate = std::max(rolloffRate, sourceRate);
+        }
+    }
 
-        if (container->getName() == "Harmonic Generator") {
-            data.harmonicGen = new HarmonicGenerator(sampleRate);
+    // Hands out the next kMaxBlockFrames doubles of the voice buffer arena
+    auto allocateBuffer = [&compiled]() {
+        int offset = compiled.bufferSize;
+        compiled.bufferSize += kMaxBlockFrames;
+        return offset;
+    };
+
+    switch (plan.type) {
+    case NodeType::HarmonicGenerator:
+    case NodeType::RolloffProcessor: {
+        // A spectrum changes when a control modulates it, or when the
+        // spectrum it is derived from does
+        const NodePlan *source = spectrumInput(compiled, plan);
+        plan.spectrumRate = std::max(purityRate, rolloffRate);
+        if (source) {
+            plan.spectrumRate = std::max(plan.spectrumRate, source->spectrumRate);
+        }
 
-            int dnaSelect = static_cast<int>(container->getParameter("dnaSelect", 0.0));
+        int rows = 1;
+        if (plan.spectrumRate == Rate::Control) {
+            rows = kMaxBlockFrames / compiled.controlInterval + 1;
+        } else if (plan.spectrumRate == Rate::Audio) {
+            rows = kMaxBlockFrames;
+        }
+        plan.spectrumRow = compiled.spectrumRows;
+        compiled.spectrumRows += rows;
+        break;
+    }
 
-            // Check if using custom DNA pattern
-            if (dnaSelect == -1) {
-                // Load custom DNA pattern from container
-                int customDnaCount = static_cast<int>(container->getParameter("customDnaCount", 0.0));
+    case NodeType::SpectrumToSignal:
+    case NodeType::FormantBody:
+    case NodeType::BreathTurbulence:
+    case NodeType::NoiseColorFilter:
+        plan.signalOut = allocateBuffer();
+        break;
+
+    case NodeType::GateProcessor:
+        plan.gateEnvelopeOut = allocateBuffer();
+        plan.gateStateOut = allocateBuffer();
+        plan.gateAttackTrigger = allocateBuffer();
+        plan.gateReleaseTrigger = allocateBuffer();
+        plan.controlOut = allocateBuffer();
+        break;
+
+    case NodeType::PhysicsSystem:
+    case NodeType::EnvelopeEngine:
+    case NodeType::DriftEngine:
+    case NodeType::EasingApplicator:
+        plan.controlOut = allocateBuffer();
+        break;
+
+    case NodeType::Unknown:
+        break;
+    }
+}
 
-                if (customDnaCount > 0) {
-                    std::vector<double> customAmplitudes;
-                    customAmplitudes.reserve(customDnaCount);
+void SounitGraph::createProcessor(const Program &compiled, const NodePlan &plan, NodeState &state)
+{
+    double rate = compiled.sampleRate;
+
+    switch (plan.type) {
+    case NodeType::HarmonicGenerator:
+        state.processor.emplace<HarmonicGenerator>(rate);
+        break;
+    case NodeType::RolloffProcessor:
+        state.processor.emplace<RolloffProcessor>();
+        break;
+    case NodeType::SpectrumToSignal:
+        state.processor.emplace<SpectrumToSignal>(rate).setOversampling(compiled.oversampling);
+        break;
+    case NodeType::FormantBody:
+        state.processor.emplace<FormantBody>(rate).setGlideFrames(compiled.controlInterval);
+        break;
+    case NodeType::BreathTurbulence:
+        state.processor.emplace<BreathTurbulence>();
+        break;
+    case NodeType::NoiseColorFilter:
+        state.processor.emplace<NoiseColorFilter>(rate);
+        break;
+    case NodeType::PhysicsSystem:
+        state.processor.emplace<PhysicsSystem>();
+        break;
+    case NodeType::EnvelopeEngine:
+        state.processor.emplace<EnvelopeEngine>();
+        break;
+    case NodeType::DriftEngine:
+        // Runs once per control tick
+        state.processor.emplace<DriftEngine>(rate / compiled.controlInterval);
+        break;
+    case NodeType::GateProcessor:
+        // Runs once per control tick
+        state.processor.emplace<GateProcessor>(rate / compiled.controlInterval);
+        break;
+    case NodeType::EasingApplicator:
+        state.processor.emplace<EasingApplicator>();
+        break;
+    case NodeType::Unknown:
+        qDebug() << "SounitGraph: No processor for container type" << plan.typeName;
+        return;
+    }
 
-                    for (int i = 0; i < customDnaCount; i++) {
-                        QString paramName = QString("customDna_%1").arg(i);
-                        double amp = container->getParameter(paramName, 0.0);
-                        customAmplitudes.push_back(amp);
-                    }
+    // Configure from the parameter snapshot (read by the caller)
+    applyParameters(plan, state);
+}
 
-                    qDebug() << "Loading custom DNA with" << customDnaCount << "harmonics";
-                    data.harmonicGen->setCustomAmplitudes(customAmplitudes);
-                } else {
-                    // No custom pattern stored, fall back to rolloff-based generation
-                    qDebug() << "Custom DNA selected but no pattern stored, using rolloff";
-                    data.harmonicGen->setNumHarmonics(
-                        static_cast<int>(container->getParameter("numHarmonics", 64.0)));
-                    data.harmonicGen->setRolloffPower(container->getParameter("rolloff", 1.82));
-                    data.harmonicGen->setDnaPreset(-1);
-                }
-            } else {
-                // Using preset DNA
-                data.harmonicGen->setNumHarmonics(
-                    static_cast<int>(container->getParameter("numHarmonics", 64.0)));
-                data.harmonicGen->setRolloffPower(container->getParameter("rolloff", 1.82));
-                data.harmonicGen->setDnaPreset(dnaSelect);
+bool SounitGraph::updateParameters(const SounitDescription::Node &node)
+{
+    if (!program) {
+        return false;
+    }
+
+    for (size_t n = 0; n < program->nodes.size(); n++) {
+        if (program->nodes[n].nodeId != node.id) {
+            continue;
+        }
+
+        // Publish a new program rather than editing the one other voices share
+        auto updated = std::make_shared<Program>(*program);
+        readParameters(updated->nodes[n], node);
+        applyParameters(updated->nodes[n], updated->initialState[n]);
+        program = updated;
+        return true;
+    }
+    return false;
+}
+
+void SounitGraph::readParameters(NodePlan &plan, const SounitDescription::Node &node)
+{
+    NodeParams &params = plan.params;
+
+    switch (plan.type) {
+    case NodeType::HarmonicGenerator: {
+        params.dnaSelect = static_cast<int>(node.parameter("dnaSelect", 0.0));
+        params.numHarmonics = static_cast<int>(node.parameter("numHarmonics", 64.0));
+        params.rolloff = node.parameter("rolloff", 1.82);
+
+        // Custom DNA pattern, stored as customDna_0..customDna_N-1
+        params.customDna.clear();
+        if (params.dnaSelect == -1) {
+            int customDnaCount = static_cast<int>(node.parameter("customDnaCount", 0.0));
+            params.customDna.reserve(customDnaCount);
+            for (int i = 0; i < customDnaCount; i++) {
+                QString paramName = QString("customDna_%1").arg(i);
+                params.customDna.push_back(node.parameter(paramName, 0.0));
             }
+        }
+        break;
+    }
 
-            // Note: purity and drift are now controlled via input ports, not stored parameters
-
-        } else if (container->getName() == "Rolloff Processor") {
-            data.rolloffProc = new RolloffProcessor();
-            data.rolloffProc->setRolloffPower(container->getParameter("rolloff", 0.6));
-
-        } else if (container->getName() == "Spectrum to Signal") {
-            data.spectrumToSig = new SpectrumToSignal(sampleRate);
-            data.spectrumToSig->setNormalize(container->getParameter("normalize", 1.0));
-
-        } else if (container->getName() == "Formant Body") {
-            data.formantBody = new FormantBody(sampleRate);
-            data.formantBody->setF1Freq(container->getParameter("f1Freq", 500.0));
-            data.formantBody->setF2Freq(container->getParameter("f2Freq", 1500.0));
-            data.formantBody->setF1Q(container->getParameter("f1Q", 8.0));
-            data.formantBody->setF2Q(container->getParameter("f2Q", 10.0));
-            data.formantBody->setDirectMix(container->getParameter("directMix", 0.3));
-            data.formantBody->setF1F2Balance(container->getParameter("f1f2Balance", 0.6));
-
-        } else if (container->getName() == "Breath Turbulence") {
-            data.breathTurb = new BreathTurbulence();
-            data.breathTurb->setBlend(container->getParameter("blend", 0.10));
-            // For now, use default blend curve (sqrt)
-
-        } else if (container->getName() == "Noise Color Filter") {
-            data.noiseFilter = new NoiseColorFilter(sampleRate);
-            data.noiseFilter->setColor(container->getParameter("color", 2000.0));
-            data.noiseFilter->setFilterQ(container->getParameter("filterQ", 1.0));
-
-            // Set noise type
-            int noiseTypeValue = static_cast<int>(container->getParameter("noiseType", 0.0));
-            data.noiseFilter->setNoiseType(static_cast<NoiseColorFilter::NoiseType>(noiseTypeValue));
-
-            // For now, use default filter type (highpass)
-
-        } else if (container->getName() == "Physics System") {
-            data.physicsSys = new PhysicsSystem();
-            data.physicsSys->setMass(container->getParameter("mass", 0.5));
-            data.physicsSys->setSpringK(container->getParameter("springK", 0.001));
-            data.physicsSys->setDamping(container->getParameter("damping", 0.995));
-            data.physicsSys->setImpulseAmount(container->getParameter("impulseAmount", 100.0));
-
-        } else if (container->getName() == "Envelope Engine") {
-            data.envelopeEng = new EnvelopeEngine();
-            int envSelect = static_cast<int>(container->getParameter("envelopeSelect", 0.0));
-
-            // If custom envelope is selected (index 5), set envelope type to Custom
-            // and load the custom envelope data
-            if (envSelect == 5 && container->hasCustomEnvelopeData()) {
-                data.envelopeEng->setEnvelopeType(EnvelopeEngine::EnvelopeType::Custom);
-                EnvelopeData customData = container->getCustomEnvelopeData();
-                data.envelopeEng->setCustomEnvelope(customData.points);
-            } else {
-                // Standard envelope types (0-4)
-                data.envelopeEng->setEnvelopeSelect(envSelect);
+    case NodeType::RolloffProcessor:
+        params.rolloff = node.parameter("rolloff", 0.6);
+        break;
+
+    case NodeType::SpectrumToSignal:
+        params.normalize = node.parameter("normalize", 1.0);
+        break;
+
+    case NodeType::FormantBody:
+        params.f1Freq = node.parameter("f1Freq", 500.0);
+        params.f2Freq = node.parameter("f2Freq", 1500.0);
+        params.f1Q = node.parameter("f1Q", 8.0);
+        params.f2Q = node.parameter("f2Q", 10.0);
+        params.directMix = node.parameter("directMix", 0.3);
+        params.f1f2Balance = node.parameter("f1f2Balance", 0.6);
+        break;
+
+    case NodeType::BreathTurbulence:
+        params.blend = node.parameter("blend", 0.10);
+        break;
+
+    case NodeType::NoiseColorFilter:
+        params.color = node.parameter("color", 2000.0);
+        params.filterQ = node.parameter("filterQ", 1.0);
+        params.noiseType = static_cast<int>(node.parameter("noiseType", 0.0));
+        break;
+
+    case NodeType::PhysicsSystem:
+        params.mass = node.parameter("mass", 0.5);
+        params.springK = node.parameter("springK", 0.001);
+        params.damping = node.parameter("damping", 0.995);
+        params.impulseAmount = node.parameter("impulseAmount", 100.0);
+        break;
+
+    case NodeType::EnvelopeEngine:
+        params.envelopeSelect = static_cast<int>(node.parameter("envelopeSelect", 0.0));
+        params.customEnvelope.clear();
+        if (params.envelopeSelect == 5 && !node.customEnvelope.isEmpty()) {
+            params.customEnvelope = node.customEnvelope;
+        }
+        params.timeScale = node.parameter("timeScale", 1.0);
+        params.valueScale = node.parameter("valueScale", 1.0);
+        params.valueOffset = node.parameter("valueOffset", 0.0);
+        params.envAttack = node.parameter("envAttack", 0.1);
+        params.envDecay = node.parameter("envDecay", 0.2);
+        params.envSustain = node.parameter("envSustain", 0.7);
+        params.envRelease = node.parameter("envRelease", 0.2);
+        params.envFadeTime = node.parameter("envFadeTime", 0.5);
+        break;
+
+    case NodeType::DriftEngine:
+        params.amount = node.parameter("amount", 0.005);
+        params.rate = node.parameter("rate", 0.5);
+        params.driftPattern = static_cast<int>(node.parameter("driftPattern", 2.0));
+        break;
+
+    case NodeType::GateProcessor:
+        params.velocity = node.parameter("velocity", 1.0);
+        params.attackTime = node.parameter("attackTime", 0.01);
+        params.releaseTime = node.parameter("releaseTime", 0.1);
+        params.attackCurve = static_cast<int>(node.parameter("attackCurve", 0.0));
+        params.releaseCurve = static_cast<int>(node.parameter("releaseCurve", 0.0));
+        params.velocitySens = node.parameter("velocitySens", 0.5);
+        break;
+
+    case NodeType::EasingApplicator:
+        params.easingSelect = static_cast<int>(node.parameter("easingSelect", 0.0));
+        break;
+
+    case NodeType::Unknown:
+        break;
+    }
+}
+
+void SounitGraph::applyParameters(const NodePlan &plan, NodeState &state)
+{
+    const NodeParams &params = plan.params;
+
+    // Configuration that isn't modulated per block goes straight to the processor;
+    // modulatable values are read from the snapshot by executeNode()
+    switch (plan.type) {
+    case NodeType::HarmonicGenerator: {
+        HarmonicGenerator &harmonicGen = std::get<HarmonicGenerator>(state.processor);
+
+        // Check if using custom DNA pattern
+        if (params.dnaSelect == -1 && !params.customDna.empty()) {
+            qDebug() << "Loading custom DNA with" << params.customDna.size() << "harmonics";
+            harmonicGen.setCustomAmplitudes(params.customDna);
+        } else {
+            if (params.dnaSelect == -1) {
+                // No custom pattern stored, fall back to rolloff-based generation
+                qDebug() << "Custom DNA selected but no pattern stored, using rolloff";
             }
+            harmonicGen.setNumHarmonics(params.numHarmonics);
+            harmonicGen.setRolloffPower(params.rolloff);
+            harmonicGen.setDnaPreset(params.dnaSelect);
+        }
+        // Note: purity and drift are controlled via input ports, not stored parameters
+        break;
+    }
 
-            data.envelopeEng->setTimeScale(container->getParameter("timeScale", 1.0));
-            data.envelopeEng->setValueScale(container->getParameter("valueScale", 1.0));
-            data.envelopeEng->setValueOffset(container->getParameter("valueOffset", 0.0));
+    case NodeType::RolloffProcessor:
+        std::get<RolloffProcessor>(state.processor).setRolloffPower(params.rolloff);
+        break;
+
+    case NodeType::SpectrumToSignal:
+        std::get<SpectrumToSignal>(state.processor).setNormalize(params.normalize);
+        break;
+
+    case NodeType::NoiseColorFilter:
+        std::get<NoiseColorFilter>(state.processor)
+            .setNoiseType(static_cast<NoiseColorFilter::NoiseType>(params.noiseType));
+        // For now, use default filter type (highpass)
+        break;
+
+    case NodeType::EnvelopeEngine: {
+        EnvelopeEngine &envelopeEng = std::get<EnvelopeEngine>(state.processor);
+
+        // If custom envelope is selected (index 5), set envelope type to Custom
+        // and load the custom envelope data
+        if (params.envelopeSelect == 5 && !params.customEnvelope.isEmpty()) {
+            envelopeEng.setEnvelopeType(EnvelopeEngine::EnvelopeType::Custom);
+            envelopeEng.setCustomEnvelope(params.customEnvelope);
+        } else {
+            // Standard envelope types (0-4)
+            envelopeEng.setEnvelopeSelect(params.envelopeSelect);
+        }
 
-        } else if (container->getName() == "Drift Engine") {
-            data.driftEng = new DriftEngine(sampleRate);
-            data.driftEng->setAmount(container->getParameter("amount", 0.005));
-            data.driftEng->setRate(container->getParameter("rate", 0.5));
+        // Envelope-specific timing parameters (for standard envelopes)
+        envelopeEng.setAttackTime(params.envAttack);
+        envelopeEng.setDecayTime(params.envDecay);
+        envelopeEng.setSustainLevel(params.envSustain);
+        envelopeEng.setReleaseTime(params.envRelease);
+        envelopeEng.setFadeTime(params.envFadeTime);
+        envelopeEng.updateTable();
+        break;
+    }
 
-            // Set drift pattern
-            int patternValue = static_cast<int>(container->getParameter("driftPattern", 2.0));
-            data.driftEng->setDriftPattern(static_cast<DriftEngine::DriftPattern>(patternValue));
+    case NodeType::DriftEngine:
+        std::get<DriftEngine>(state.processor)
+            .setDriftPattern(static_cast<DriftEngine::DriftPattern>(params.driftPattern));
+        break;
+
+    case NodeType::GateProcessor: {
+        GateProcessor &gateProc = std::get<GateProcessor>(state.processor);
+        gateProc.setVelocity(params.velocity);
+        gateProc.setAttackTime(params.attackTime);
+        gateProc.setReleaseTime(params.releaseTime);
+        gateProc.setAttackCurve(params.attackCurve);
+        gateProc.setReleaseCurve(params.releaseCurve);
+        gateProc.setVelocitySens(params.velocitySens);
+        break;
+    }
 
-        } else if (container->getName() == "Gate Processor") {
-            data.gateProc = new GateProcessor(sampleRate);
-            data.gateProc->setVelocity(container->getParameter("velocity", 1.0));
-            data.gateProc->setAttackTime(container->getParameter("attackTime", 0.01));
-            data.gateProc->setReleaseTime(container->getParameter("releaseTime", 0.1));
-            data.gateProc->setAttackCurve(static_cast<int>(container->getParameter("attackCurve", 0.0)));
-            data.gateProc->setReleaseCurve(static_cast<int>(container->getParameter("releaseCurve", 0.0)));
-            data.gateProc->setVelocitySens(container->getParameter("velocitySens", 0.5));
+    case NodeType::EasingApplicator: {
+        EasingApplicator &easingApp = std::get<EasingApplicator>(state.processor);
+        easingApp.setEasingSelect(params.easingSelect);
+        // For now, use default easing mode (InOut)
+        easingApp.updateTable();
+        break;
+    }
 
-        } else if (container->getName() == "Easing Applicator") {
-            data.easingApp = new EasingApplicator();
-            data.easingApp->setEasingSelect(static_cast<int>(container->getParameter("easingSelect", 0.0)));
-            // For now, use default easing mode (InOut)
-        }
+    case NodeType::FormantBody:
+    case NodeType::BreathTurbulence:
+    case NodeType::PhysicsSystem:
+    case NodeType::Unknown:
+        break;
     }
 }
 
-void SounitGraph::reset()
+void SounitGraph::reset(uint64_t noteSeed)
 {
-    for (auto &data : processors) {
-        if (data.harmonicGen) {
-            data.harmonicGen->reset();
-        }
-        if (data.spectrumToSig) {
-            data.spectrumToSig->reset();
-        }
-        if (data.formantBody) {
-            data.formantBody->reset();
-        }
-        if (data.noiseFilter) {
-            data.noiseFilter->reset();
-        }
-        if (data.physicsSys) {
-            data.physicsSys->reset();
-        }
-        if (data.driftEng) {
-            data.driftEng->reset();
-        }
-        if (data.gateProc) {
-            data.gateProc->reset();
-            // Trigger note on when starting a new note
-            data.gateProc->noteOn(1.0);
+    controlClock = 0;
+
+    // Processors, ramps and trigger state go back to the program's initial state
+    // (copy-assigned, so the processors' own tables don't reallocate)
+    states = program->initialState;
+
+    for (size_t n = 0; n < states.size(); n++) {
+        NodeState &state = states[n];
+        uint64_t seed = ContentHash::combine(noteSeed, program->nodes[n].seedKey);
+
+        // Trigger note on when starting a new note
+        if (GateProcessor *gateProc = std::get_if<GateProcessor>(&state.processor)) {
+            gateProc->noteOn(1.0);
+        } else if (NoiseColorFilter *noiseFilter = std::get_if<NoiseColorFilter>(&state.processor)) {
+            noiseFilter->setSeed(seed);
+        } else if (DriftEngine *driftEng = std::get_if<DriftEngine>(&state.processor)) {
+            driftEng->setSeed(seed);
         }
-        // RolloffProcessor and BreathTurbulence have no state to reset
     }
 }
 
+uint64_t SounitGraph::noteSeed(int trackIndex, uint64_t noteContentHash)
+{
+    return ContentHash::combine(ContentHash::combine(uint64_t(0), trackIndex), noteContentHash);
+}
+
 double SounitGraph::generateSample(double pitch, double noteProgress)
 {
-    if (!hasValidSignalOutput) {
+    if (!isValid()) {
         return 0.0;
     }
 
-    // Execute containers in order
-    for (Container *container : executionOrder) {
-        if (processors.contains(container)) {
-            executeContainer(processors[container], pitch, noteProgress);
+    // A single sample is a one-frame block
+    processNodes(&pitch, &noteProgress, 1);
+
+    // Return final signal output
+    return buffer(program->nodes[program->outputNode].signalOut)[0];
+}
+
+void SounitGraph::processBlock(float *out, int nFrames, const double *pitch, const double *progress)
+{
+    if (!isValid()) {
+        std::fill(out, out + nFrames, 0.0f);
+        return;
+    }
+
+    const double *signal = buffer(program->nodes[program->outputNode].signalOut);
+    for (int offset = 0; offset < nFrames; offset += kMaxBlockFrames) {
+        int chunkFrames = std::min(kMaxBlockFrames, nFrames - offset);
+        processNodes(pitch + offset, progress + offset, chunkFrames);
+
+        for (int i = 0; i < chunkFrames; i++) {
+            out[offset + i] = static_cast<float>(signal[i]);
         }
     }
+}
 
-    // Return final signal output
-    if (signalOutputContainer && processors.contains(signalOutputContainer)) {
-        return processors[signalOutputContainer].signalOut;
-    }
-
-    return 0.0;
-}
-
-void SounitGraph::executeContainer(ProcessorData &proc, double pitch, double noteProgress)
-{
-    Container *container = proc.container;
-    if (!container) return;
-
-    if (container->getName() == "Harmonic Generator") {
-        if (proc.harmonicGen) {
-            // Initialize input values with defaults
-            double purityValue = 0.0;  // Default purity (0.0 = pure DNA, 1.0 = flat spectrum)
-            double driftValue = 0.0;   // Default drift
-
-            // Check for connections to purity and drift ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "purity") {
-                            // Get purity modulation from source container (control output 0.0-1.0)
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                purityValue = applyConnectionFunction(purityValue, sourceValue,
-                                                                    conn.function, conn.weight);
-                                // Clamp to valid range
-                                purityValue = qBound(0.0, purityValue, 1.0);
-                            }
-                        } else if (conn.toPort == "drift") {
-                            // Get drift modulation from source container (control output)
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale to drift range (0.0 to 0.1)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 0.1;
-                                driftValue = applyConnectionFunction(driftValue, sourceValue,
-                                                                   conn.function, conn.weight);
-                                // Clamp to valid range
-                                driftValue = qBound(0.0, driftValue, 0.1);
-                            }
-                        }
-                    }
-                }
-            }
+void SounitGraph::processNodes(const double *pitch, const double *progress, int nFrames)
+{
+    // Split the block into control segments
+    segmentCount = 0;
+    for (int i = 0; i < nFrames; i++) {
+        if (i == 0 || isControlTick(i)) {
+            segmentStart[segmentCount++] = i;
+        }
+        segmentOfFrame[i] = segmentCount - 1;
+    }
+    segmentStart[segmentCount] = nFrames;
 
-            // Apply final modulated values
-            proc.harmonicGen->setPurity(purityValue);
-            proc.harmonicGen->setDrift(driftValue);
+    // Execute nodes in order, each over the whole block
+    const std::vector<NodePlan> &nodes = program->nodes;
+    for (size_t n = 0; n < nodes.size(); n++) {
+        executeNode(nodes[n], states[n], pitch, progress, nFrames);
+    }
 
-            // Generate harmonic spectrum using HarmonicGenerator's pre-calculated amplitudes
-            // (which include DNA preset characteristics and purity blending)
-            int numHarmonics = proc.harmonicGen->getNumHarmonics();
-            proc.spectrumOut.resize(numHarmonics);
+    controlClock += nFrames;
+}
 
-            // Use the pre-calculated amplitudes from HarmonicGenerator
-            // (already normalized and DNA-aware)
-            for (int h = 0; h < numHarmonics; h++) {
-                double amp = proc.harmonicGen->getHarmonicAmplitude(h);
-                proc.spectrumOut.setAmplitude(h, amp);
+void SounitGraph::startRamp(ControlRamp &ramp, double target) const
+{
+    ramp.target = target;
+
+    // First tick after reset, or no smoothing: jump straight to the value
+    if (!ramp.primed || controlSmoothing == ControlSmoothing::Step) {
+        ramp.value = target;
+        ramp.increment = 0.0;
+        ramp.remaining = 0;
+        ramp.primed = true;
+        return;
+    }
+
+    ramp.increment = (target - ramp.value) / program->controlInterval;
+    ramp.remaining = program->controlInterval;
+}
+
+void SounitGraph::fillRamp(ControlRamp &ramp, double *out, int start, int end)
+{
+    for (int i = start; i < end; i++) {
+        if (ramp.remaining > 0) {
+            ramp.value += ramp.increment;
+            if (--ramp.remaining == 0) {
+                ramp.value = ramp.target;  // Land exactly on the target
             }
         }
+        out[i] = ramp.value;
+    }
+}
 
-    } else if (container->getName() == "Rolloff Processor") {
-        if (proc.rolloffProc) {
-            // Initialize input values with defaults
-            Spectrum inputSpectrum;
-            double rolloffPower = container->getParameter("rolloff", 0.6);
-
-            // Find connections to spectrumIn and rolloff ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "spectrumIn") {
-                            // Get spectrum from source container (passthrough only for spectrum data)
-                            if (processors.contains(conn.fromContainer)) {
-                                inputSpectrum = processors[conn.fromContainer].spectrumOut;
-                            }
-                        } else if (conn.toPort == "rolloff") {
-                            // Get rolloff modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to rolloff range (0.1-3.0)
-                                double sourceValue = 0.1 + processors[conn.fromContainer].controlOut * 2.9;
-                                rolloffPower = applyConnectionFunction(rolloffPower, sourceValue,
-                                                                     conn.function, conn.weight);
-                                // Clamp to valid range
-                                rolloffPower = qBound(0.1, rolloffPower, 3.0);
-                            }
-                        }
-                    }
-                }
-            }
+const double *SounitGraph::sourceBuffer(const InputSlot &slot) const
+{
+    const NodePlan &source = program->nodes[slot.sourceNode];
+    int offset = source.controlOut;
+
+    switch (slot.sourcePort) {
+    case OutputPort::Signal:
+        offset = source.signalOut;
+        break;
+    case OutputPort::GateEnvelope:
+        offset = source.gateEnvelopeOut;
+        break;
+    case OutputPort::GateState:
+        offset = source.gateStateOut;
+        break;
+    case OutputPort::GateAttackTrigger:
+        offset = source.gateAttackTrigger;
+        break;
+    case OutputPort::GateReleaseTrigger:
+        offset = source.gateReleaseTrigger;
+        break;
+    case OutputPort::Control:
+    case OutputPort::Spectrum:
+        break;
+    }
 
-            // Process spectrum with rolloff curve
-            proc.rolloffProc->processSpectrum(inputSpectrum, proc.spectrumOut, rolloffPower);
-        }
-
-    } else if (container->getName() == "Spectrum to Signal") {
-        if (proc.spectrumToSig) {
-            // Initialize input values with defaults
-            Spectrum inputSpectrum;
-            double effectivePitch = pitch;  // Default to global pitch
-
-            // Find connections to spectrumIn and pitch ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "spectrumIn") {
-                            // Get spectrum from source container (passthrough only for spectrum data)
-                            if (processors.contains(conn.fromContainer)) {
-                                inputSpectrum = processors[conn.fromContainer].spectrumOut;
-                            }
-                        } else if (conn.toPort == "pitch") {
-                            // Get pitch modulation from source container (control output)
-                            if (processors.contains(conn.fromContainer)) {
-                                // Use control output as pitch multiplier (typical range 0.5-2.0)
-                                double sourceValue = processors[conn.fromContainer].controlOut * pitch;
-                                effectivePitch = applyConnectionFunction(effectivePitch, sourceValue,
-                                                                       conn.function, conn.weight);
-                                // Clamp to reasonable pitch range
-                                effectivePitch = qBound(20.0, effectivePitch, 20000.0);
-                            }
-                        }
-                    }
-                }
-            }
+    // Outputs the source type doesn't produce read as silence
+    return buffer(offset < 0 ? kSilentOffset : offset);
+}
 
-            // Generate audio sample from spectrum with modulated pitch
-            proc.signalOut = proc.spectrumToSig->generateSample(inputSpectrum, effectivePitch);
-        }
-
-    } else if (container->getName() == "Formant Body") {
-        if (proc.formantBody) {
-            // Initialize input values with defaults
-            double inputSignal = 0.0;
-            double f1Freq = container->getParameter("f1Freq", 500.0);
-            double f2Freq = container->getParameter("f2Freq", 1500.0);
-            double f1Q = container->getParameter("f1Q", 8.0);
-            double f2Q = container->getParameter("f2Q", 10.0);
-            double directMix = container->getParameter("directMix", 0.3);
-            double f1f2Balance = container->getParameter("f1f2Balance", 0.6);
-
-            // Find connections to all input ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "signalIn") {
-                            // Get signal from source container (passthrough only for signal data)
-                            if (processors.contains(conn.fromContainer)) {
-                                inputSignal = processors[conn.fromContainer].signalOut;
-                            }
-                        } else if (conn.toPort == "f1Freq") {
-                            // Get f1Freq modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to f1Freq range (200-1000 Hz)
-                                double sourceValue = 200.0 + processors[conn.fromContainer].controlOut * 800.0;
-                                f1Freq = applyConnectionFunction(f1Freq, sourceValue,
-                                                               conn.function, conn.weight);
-                                f1Freq = qBound(200.0, f1Freq, 1000.0);
-                            }
-                        } else if (conn.toPort == "f2Freq") {
-                            // Get f2Freq modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to f2Freq range (500-3000 Hz)
-                                double sourceValue = 500.0 + processors[conn.fromContainer].controlOut * 2500.0;
-                                f2Freq = applyConnectionFunction(f2Freq, sourceValue,
-                                                               conn.function, conn.weight);
-                                f2Freq = qBound(500.0, f2Freq, 3000.0);
-                            }
-                        } else if (conn.toPort == "f1Q") {
-                            // Get f1Q modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to Q range (1.0-20.0)
-                                double sourceValue = 1.0 + processors[conn.fromContainer].controlOut * 19.0;
-                                f1Q = applyConnectionFunction(f1Q, sourceValue,
-                                                            conn.function, conn.weight);
-                                f1Q = qBound(1.0, f1Q, 20.0);
-                            }
-                        } else if (conn.toPort == "f2Q") {
-                            // Get f2Q modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to Q range (1.0-20.0)
-                                double sourceValue = 1.0 + processors[conn.fromContainer].controlOut * 19.0;
-                                f2Q = applyConnectionFunction(f2Q, sourceValue,
-                                                            conn.function, conn.weight);
-                                f2Q = qBound(1.0, f2Q, 20.0);
-                            }
-                        } else if (conn.toPort == "directMix") {
-                            // Get directMix modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                directMix = applyConnectionFunction(directMix, sourceValue,
-                                                                  conn.function, conn.weight);
-                                directMix = qBound(0.0, directMix, 1.0);
-                            }
-                        } else if (conn.toPort == "f1f2Balance") {
-                            // Get f1f2Balance modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                f1f2Balance = applyConnectionFunction(f1f2Balance, sourceValue,
-                                                                    conn.function, conn.weight);
-                                f1f2Balance = qBound(0.0, f1f2Balance, 1.0);
-                            }
-                        }
-                    }
-                }
-            }
+const double *SounitGraph::signalInput(const NodePlan &plan, InputPort port) const
+{
+    // Last connection to the port wins; nullptr when nothing is connected
+    const double *input = nullptr;
+    for (const InputSlot &slot : plan.inputs) {
+        if (slot.port == port) {
+            input = sourceBuffer(slot);
+        }
+    }
+    return input;
+}
 
-            // Update parameters (from static config or modulated values)
-            proc.formantBody->setF1Freq(f1Freq);
-            proc.formantBody->setF2Freq(f2Freq);
-            proc.formantBody->setF1Q(f1Q);
-            proc.formantBody->setF2Q(f2Q);
-            proc.formantBody->setDirectMix(directMix);
-            proc.formantBody->setF1F2Balance(f1f2Balance);
-
-            // Process the signal through formant filters
-            proc.signalOut = proc.formantBody->processSample(inputSignal);
-        }
-
-    } else if (container->getName() == "Breath Turbulence") {
-        if (proc.breathTurb) {
-            // Initialize input values with defaults
-            double voiceIn = 0.0;
-            double noiseIn = 0.0;
-            double blend = container->getParameter("blend", 0.10);
-
-            // Find connections to voiceIn, noiseIn, and blend ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "voiceIn") {
-                            // Get signal from source container (passthrough only for signal data)
-                            if (processors.contains(conn.fromContainer)) {
-                                voiceIn = processors[conn.fromContainer].signalOut;
-                            }
-                        } else if (conn.toPort == "noiseIn") {
-                            // Get noise signal from source container (passthrough only for signal data)
-                            if (processors.contains(conn.fromContainer)) {
-                                noiseIn = processors[conn.fromContainer].signalOut;
-                            }
-                        } else if (conn.toPort == "blend") {
-                            // Get blend modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                blend = applyConnectionFunction(blend, sourceValue,
-                                                              conn.function, conn.weight);
-                                blend = qBound(0.0, blend, 1.0);
-                            }
-                        }
-                    }
-                }
-            }
+const SounitGraph::NodePlan *SounitGraph::spectrumInput(const Program &compiled, const NodePlan &plan)
+{
+    const NodePlan *source = nullptr;
+    for (const InputSlot &slot : plan.inputs) {
+        if (slot.port == InputPort::SpectrumIn && compiled.nodes[slot.sourceNode].spectrumRow >= 0) {
+            source = &compiled.nodes[slot.sourceNode];
+        }
+    }
+    return source;
+}
 
-            // Update blend parameter (from static config or modulated value)
-            proc.breathTurb->setBlend(blend);
-
-            // Process the blend
-            proc.signalOut = proc.breathTurb->processSample(voiceIn, noiseIn);
-        }
-
-    } else if (container->getName() == "Noise Color Filter") {
-        if (proc.noiseFilter) {
-            // Initialize input values with defaults
-            double color = container->getParameter("color", 2000.0);
-            double filterQ = container->getParameter("filterQ", 1.0);
-            double audioIn = 0.0;
-            bool hasAudioIn = false;
-
-            // Find connections to input ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "audioIn") {
-                            // Get audio signal from source container (passthrough only for signal data)
-                            if (processors.contains(conn.fromContainer)) {
-                                audioIn = processors[conn.fromContainer].signalOut;
-                                hasAudioIn = true;
-                            }
-                        } else if (conn.toPort == "color") {
-                            // Get color modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to color range (100-8000 Hz)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 7900.0 + 100.0;
-                                color = applyConnectionFunction(color, sourceValue,
-                                                              conn.function, conn.weight);
-                                color = qBound(100.0, color, 8000.0);
-                            }
-                        } else if (conn.toPort == "filterQ") {
-                            // Get filterQ modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to filterQ range (0.5-10.0)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 9.5 + 0.5;
-                                filterQ = applyConnectionFunction(filterQ, sourceValue,
-                                                                conn.function, conn.weight);
-                                filterQ = qBound(0.5, filterQ, 10.0);
-                            }
-                        }
-                    }
-                }
-            }
+const Spectrum &SounitGraph::spectrumAt(const NodePlan *source, int frame) const
+{
+    if (!source) {
+        return program->silentSpectrum;
+    }
 
-            // Update parameters
-            proc.noiseFilter->setColor(color);
-            proc.noiseFilter->setFilterQ(filterQ);
+    switch (source->spectrumRate) {
+    case Rate::Control:
+        return spectra[source->spectrumRow + segmentOfFrame[frame]];
+    case Rate::Audio:
+        return spectra[source->spectrumRow + frame];
+    case Rate::Block:
+        break;
+    }
+    return spectra[source->spectrumRow];
+}
 
-            // Update noise type
-            int noiseTypeValue = static_cast<int>(container->getParameter("noiseType", 0.0));
-            proc.noiseFilter->setNoiseType(static_cast<NoiseColorFilter::NoiseType>(noiseTypeValue));
+bool SounitGraph::hasInput(const NodePlan &plan, InputPort port)
+{
+    for (const InputSlot &slot : plan.inputs) {
+        if (slot.port == port) {
+            return true;
+        }
+    }
+    return false;
+}
 
-            // Process or generate noise
-            if (hasAudioIn) {
-                // Use external audio input
-                proc.signalOut = proc.noiseFilter->processSample(audioIn);
-            } else {
-                // Generate internal noise
-                proc.signalOut = proc.noiseFilter->generateSample();
-            }
+bool SounitGraph::evaluatePort(const NodePlan &plan, InputPort port, double staticValue,
+                               const PortRange &range, double *values, int nFrames) const
+{
+    std::fill(values, values + nFrames, staticValue);
+
+    // Connections into the same port combine in canvas order, independently per frame
+    bool connected = false;
+    for (const InputSlot &slot : plan.inputs) {
+        if (slot.port != port) {
+            continue;
         }
 
-    } else if (container->getName() == "Physics System") {
-        if (proc.physicsSys) {
-            // Initialize input values with defaults
-            double targetValue = 0.0;
-            double mass = container->getParameter("mass", 0.5);
-            double springK = container->getParameter("springK", 0.001);
-            double damping = container->getParameter("damping", 0.995);
-            double impulseAmount = container->getParameter("impulseAmount", 100.0);
-            double impulse = 0.0;
-
-            // Find connections to input ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "targetValue") {
-                            // Get control value from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                targetValue = applyConnectionFunction(targetValue, sourceValue,
-                                                                    conn.function, conn.weight);
-                            }
-                        } else if (conn.toPort == "mass") {
-                            // Get mass modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to mass range (0.0-10.0)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 10.0;
-                                mass = applyConnectionFunction(mass, sourceValue,
-                                                             conn.function, conn.weight);
-                                mass = qBound(0.0, mass, 10.0);
-                            }
-                        } else if (conn.toPort == "springK") {
-                            // Get springK modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to springK range (0.0001-1.0)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 0.9999 + 0.0001;
-                                springK = applyConnectionFunction(springK, sourceValue,
-                                                                conn.function, conn.weight);
-                                springK = qBound(0.0001, springK, 1.0);
-                            }
-                        } else if (conn.toPort == "damping") {
-                            // Get damping modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to damping range (0.5-0.9999)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 0.4999 + 0.5;
-                                damping = applyConnectionFunction(damping, sourceValue,
-                                                                conn.function, conn.weight);
-                                damping = qBound(0.5, damping, 0.9999);
-                            }
-                        } else if (conn.toPort == "impulseAmount") {
-                            // Get impulseAmount modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to impulseAmount range (0-1000)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 1000.0;
-                                impulseAmount = applyConnectionFunction(impulseAmount, sourceValue,
-                                                                      conn.function, conn.weight);
-                                impulseAmount = qBound(0.0, impulseAmount, 1000.0);
-                            }
-                        } else if (conn.toPort == "impulse") {
-                            // Get impulse trigger from source container (check specific port)
-                            if (processors.contains(conn.fromContainer)) {
-                                impulse = getOutputValue(processors[conn.fromContainer], conn.fromPort);
-                            }
-                        }
-                    }
-                }
-            }
+        const double *source = sourceBuffer(slot);
+        for (int i = 0; i < nFrames; i++) {
+            double value = applyConnectionFunction(values[i], range.offset + source[i] * range.scale,
+                                                   slot.function, slot.weight);
+            values[i] = std::clamp(value, range.minValue, range.maxValue);
+        }
+        connected = true;
+    }
 
-            // Update physics parameters
-            proc.physicsSys->setMass(mass);
-            proc.physicsSys->setSpringK(springK);
-            proc.physicsSys->setDamping(damping);
-            proc.physicsSys->setImpulseAmount(impulseAmount);
+    return connected;
+}
 
-            // Handle impulse trigger (rising edge detection)
-            // Trigger when impulse crosses threshold (0.5) from below
-            if (proc.prevImpulse < 0.5 && impulse >= 0.5) {
-                proc.physicsSys->applyImpulse(impulseAmount);
+void SounitGraph::executeNode(const NodePlan &plan, NodeState &state,
+                              const double *pitch, const double *progress, int nFrames)
+{
+    const NodeParams &params = plan.params;
+
+    switch (plan.type) {
+    case NodeType::HarmonicGenerator: {
+        HarmonicGenerator &harmonicGen = std::get<HarmonicGenerator>(state.processor);
+
+        // Purity: 0.0 = pure DNA, 1.0 = flat spectrum; drift scaled to 0.0-0.1
+        double *purity = scratchBuffer(0);
+        double *drift = scratchBuffer(1);
+        evaluatePort(plan, InputPort::Purity, 0.0, {0.0, 1.0, 0.0, 1.0}, purity, nFrames);
+        evaluatePort(plan, InputPort::Drift, 0.0, {0.0, 0.1, 0.0, 0.1}, drift, nFrames);
+
+        int row = plan.spectrumRow;
+        forEachSpan(plan.spectrumRate, nFrames, [&](int start, int) {
+            harmonicGen.setPurity(purity[start]);
+            harmonicGen.setDrift(drift[start]);
+
+            // Copy HarmonicGenerator's pre-calculated amplitudes
+            // (already normalized, DNA-aware and purity-blended)
+            Spectrum &spectrum = spectra[row++];
+            int numHarmonics = harmonicGen.getNumHarmonics();
+            spectrum.resize(numHarmonics);
+            for (int h = 0; h < numHarmonics; h++) {
+                spectrum.setAmplitude(h, harmonicGen.getHarmonicAmplitude(h));
             }
-            proc.prevImpulse = impulse;
-
-            // Process physics simulation
-            proc.controlOut = proc.physicsSys->processSample(targetValue);
-        }
-
-    } else if (container->getName() == "Envelope Engine") {
-        if (proc.envelopeEng) {
-            // Initialize input values with defaults
-            double effectiveProgress = noteProgress;
-            double timeScale = container->getParameter("timeScale", 1.0);
-            double valueScale = container->getParameter("valueScale", 1.0);
-            double valueOffset = container->getParameter("valueOffset", 0.0);
-
-            // Check for connections to modulatable parameters
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "timeScale") {
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to useful range (0.1-5.0)
-                                double sourceValue = 0.1 + processors[conn.fromContainer].controlOut * 4.9;
-                                timeScale = applyConnectionFunction(timeScale, sourceValue,
-                                                                  conn.function, conn.weight);
-                                timeScale = qBound(0.1, timeScale, 5.0);
-                            }
-                        } else if (conn.toPort == "valueScale") {
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to 0.0-2.0
-                                double sourceValue = processors[conn.fromContainer].controlOut * 2.0;
-                                valueScale = applyConnectionFunction(valueScale, sourceValue,
-                                                                   conn.function, conn.weight);
-                                valueScale = qBound(0.0, valueScale, 2.0);
-                            }
-                        } else if (conn.toPort == "valueOffset") {
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale control output (0.0-1.0) to -1.0 to 1.0
-                                double sourceValue = processors[conn.fromContainer].controlOut * 2.0 - 1.0;
-                                valueOffset = applyConnectionFunction(valueOffset, sourceValue,
-                                                                    conn.function, conn.weight);
-                                valueOffset = qBound(-1.0, valueOffset, 1.0);
-                            }
-                        }
-                    }
+        });
+        break;
+    }
+
+    case NodeType::RolloffProcessor: {
+        RolloffProcessor &rolloffProc = std::get<RolloffProcessor>(state.processor);
+        const NodePlan *source = spectrumInput(*program, plan);
+
+        // Scale control output (0.0-1.0) to rolloff range (0.1-3.0)
+        double *rolloff = scratchBuffer(0);
+        evaluatePort(plan, InputPort::Rolloff, params.rolloff,
+                     {0.1, 2.9, 0.1, 3.0}, rolloff, nFrames);
+
+        // Process spectrum with rolloff curve
+        int row = plan.spectrumRow;
+        forEachSpan(plan.spectrumRate, nFrames, [&](int start, int) {
+            rolloffProc.processSpectrum(spectrumAt(source, start), spectra[row++], rolloff[start]);
+        });
+        break;
+    }
+
+    case NodeType::SpectrumToSignal: {
+        SpectrumToSignal &spectrumToSig = std::get<SpectrumToSignal>(state.processor);
+        const NodePlan *source = spectrumInput(*program, plan);
+
+        // Default to global pitch; a pitch control is a multiplier (typical range 0.5-2.0)
+        const double *effectivePitch = pitch;
+        if (hasInput(plan, InputPort::Pitch)) {
+            double *modulatedPitch = scratchBuffer(0);
+            std::copy(pitch, pitch + nFrames, modulatedPitch);
+            for (const InputSlot &slot : plan.inputs) {
+                if (slot.port != InputPort::Pitch) {
+                    continue;
+                }
+                const double *control = sourceBuffer(slot);
+                for (int i = 0; i < nFrames; i++) {
+                    double value = applyConnectionFunction(modulatedPitch[i], control[i] * pitch[i],
+                                                           slot.function, slot.weight);
+                    modulatedPitch[i] = std::clamp(value, 20.0, 20000.0);
                 }
             }
+            effectivePitch = modulatedPitch;
+        }
+
+        // Generate audio from spectrum with modulated pitch,
+        // one run per span over which the spectrum holds still
+        double *out = buffer(plan.signalOut);
+        Rate spectrumRate = source ? source->spectrumRate : Rate::Block;
+        forEachSpan(spectrumRate, nFrames, [&](int start, int end) {
+            spectrumToSig.generateBlock(spectrumAt(source, start), effectivePitch + start,
+                                        out + start, end - start);
+        });
+        break;
+    }
 
-            // Update envelope parameters
-            int envSelect = static_cast<int>(container->getParameter("envelopeSelect", 0.0));
+    case NodeType::FormantBody: {
+        FormantBody &formantBody = std::get<FormantBody>(state.processor);
+        const double *input = signalInput(plan, InputPort::SignalIn);
+        if (!input) {
+            input = buffer(kSilentOffset);
+        }
 
-            // Handle custom envelope data if selected
-            if (envSelect == 5 && container->hasCustomEnvelopeData()) {
-                proc.envelopeEng->setEnvelopeType(EnvelopeEngine::EnvelopeType::Custom);
-                EnvelopeData customData = container->getCustomEnvelopeData();
-                proc.envelopeEng->setCustomEnvelope(customData.points);
+        double *f1Freq = scratchBuffer(0);
+        double *f2Freq = scratchBuffer(1);
+        double *f1Q = scratchBuffer(2);
+        double *f2Q = scratchBuffer(3);
+        double *directMix = scratchBuffer(4);
+        double *f1f2Balance = scratchBuffer(5);
+
+        // Control outputs (0.0-1.0) scale to 200-1000 Hz, 500-3000 Hz and Q 1.0-20.0
+        evaluatePort(plan, InputPort::F1Freq, params.f1Freq,
+                     {200.0, 800.0, 200.0, 1000.0}, f1Freq, nFrames);
+        evaluatePort(plan, InputPort::F2Freq, params.f2Freq,
+                     {500.0, 2500.0, 500.0, 3000.0}, f2Freq, nFrames);
+        evaluatePort(plan, InputPort::F1Q, params.f1Q,
+                     {1.0, 19.0, 1.0, 20.0}, f1Q, nFrames);
+        evaluatePort(plan, InputPort::F2Q, params.f2Q,
+                     {1.0, 19.0, 1.0, 20.0}, f2Q, nFrames);
+        evaluatePort(plan, InputPort::DirectMix, params.directMix,
+                     {0.0, 1.0, 0.0, 1.0}, directMix, nFrames);
+        evaluatePort(plan, InputPort::F1F2Balance, params.f1f2Balance,
+                     {0.0, 1.0, 0.0, 1.0}, f1f2Balance, nFrames);
+
+        // Filter coefficients are only recomputed when the parameters can change,
+        // and then glide over a control interval. Audio-rate sources still set
+        // the filters once per control segment; mix and balance follow every frame.
+        double *out = buffer(plan.signalOut);
+        if (plan.modulationRate == Rate::Audio) {
+            forEachSpan(Rate::Control, nFrames, [&](int start, int end) {
+                formantBody.setF1Freq(f1Freq[start]);
+                formantBody.setF2Freq(f2Freq[start]);
+                formantBody.setF1Q(f1Q[start]);
+                formantBody.setF2Q(f2Q[start]);
+                formantBody.processBlock(input + start, out + start, end - start,
+                                         directMix + start, f1f2Balance + start);
+            });
+            break;
+        }
+        forEachSpan(plan.modulationRate, nFrames, [&](int start, int end) {
+            formantBody.setF1Freq(f1Freq[start]);
+            formantBody.setF2Freq(f2Freq[start]);
+            formantBody.setF1Q(f1Q[start]);
+            formantBody.setF2Q(f2Q[start]);
+            formantBody.setDirectMix(directMix[start]);
+            formantBody.setF1F2Balance(f1f2Balance[start]);
+            formantBody.processBlock(input + start, out + start, end - start);
+        });
+        break;
+    }
+
+    case NodeType::BreathTurbulence: {
+        BreathTurbulence &breathTurb = std::get<BreathTurbulence>(state.processor);
+        const double *voiceIn = signalInput(plan, InputPort::VoiceIn);
+        const double *noiseIn = signalInput(plan, InputPort::NoiseIn);
+        if (!voiceIn) {
+            voiceIn = buffer(kSilentOffset);
+        }
+        if (!noiseIn) {
+            noiseIn = buffer(kSilentOffset);
+        }
+
+        double *blend = scratchBuffer(0);
+        evaluatePort(plan, InputPort::Blend, params.blend,
+                     {0.0, 1.0, 0.0, 1.0}, blend, nFrames);
+
+        // Process the blend
+        double *out = buffer(plan.signalOut);
+        forEachSpan(plan.modulationRate, nFrames, [&](int start, int end) {
+            breathTurb.setBlend(blend[start]);
+            breathTurb.processBlock(voiceIn + start, noiseIn + start, out + start, end - start);
+        });
+        break;
+    }
+
+    case NodeType::NoiseColorFilter: {
+        NoiseColorFilter &noiseFilter = std::get<NoiseColorFilter>(state.processor);
+        const double *audioIn = signalInput(plan, InputPort::AudioIn);
+
+        // Scale controlOut (0-1) to color range (100-8000 Hz) and filterQ range (0.5-10.0)
+        double *color = scratchBuffer(0);
+        double *filterQ = scratchBuffer(1);
+        evaluatePort(plan, InputPort::Color, params.color,
+                     {100.0, 7900.0, 100.0, 8000.0}, color, nFrames);
+        evaluatePort(plan, InputPort::FilterQ, params.filterQ,
+                     {0.5, 9.5, 0.5, 10.0}, filterQ, nFrames);
+
+        // Process external audio or generate internal noise
+        double *out = buffer(plan.signalOut);
+        forEachSpan(plan.modulationRate, nFrames, [&](int start, int end) {
+            noiseFilter.setColor(color[start]);
+            noiseFilter.setFilterQ(filterQ[start]);
+            if (audioIn) {
+                noiseFilter.processBlock(audioIn + start, out + start, end - start);
             } else {
-                // Standard envelope types
-                proc.envelopeEng->setEnvelopeSelect(envSelect);
+                noiseFilter.generateBlock(out + start, end - start);
             }
+        });
+        break;
+    }
 
-            proc.envelopeEng->setTimeScale(timeScale);
-            proc.envelopeEng->setValueScale(valueScale);
-            proc.envelopeEng->setValueOffset(valueOffset);
-
-            // Set envelope-specific timing parameters (for standard envelopes)
-            proc.envelopeEng->setAttackTime(container->getParameter("envAttack", 0.1));
-            proc.envelopeEng->setDecayTime(container->getParameter("envDecay", 0.2));
-            proc.envelopeEng->setSustainLevel(container->getParameter("envSustain", 0.7));
-            proc.envelopeEng->setReleaseTime(container->getParameter("envRelease", 0.2));
-            proc.envelopeEng->setFadeTime(container->getParameter("envFadeTime", 0.5));
-
-            // Process envelope with note progress (0.0 to 1.0 over note duration)
-            proc.controlOut = proc.envelopeEng->process(effectiveProgress);
-        }
-
-    } else if (container->getName() == "Drift Engine") {
-        if (proc.driftEng) {
-            // Initialize input values with defaults
-            double amount = container->getParameter("amount", 0.005);
-            double rate = container->getParameter("rate", 0.5);
-
-            // Find connections to input ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "amount") {
-                            // Get amount modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to amount range (0.0-0.1)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 0.1;
-                                amount = applyConnectionFunction(amount, sourceValue,
-                                                               conn.function, conn.weight);
-                                amount = qBound(0.0, amount, 0.1);
-                            }
-                        } else if (conn.toPort == "rate") {
-                            // Get rate modulation from source container
-                            if (processors.contains(conn.fromContainer)) {
-                                // Scale controlOut (0-1) to rate range (0.01-10.0)
-                                double sourceValue = processors[conn.fromContainer].controlOut * 9.99 + 0.01;
-                                rate = applyConnectionFunction(rate, sourceValue,
-                                                             conn.function, conn.weight);
-                                rate = qBound(0.01, rate, 10.0);
-                            }
-                        }
-                    }
-                }
+    case NodeType::PhysicsSystem: {
+        PhysicsSystem &physicsSys = std::get<PhysicsSystem>(state.processor);
+        double *targetValue = scratchBuffer(0);
+        double *mass = scratchBuffer(1);
+        double *springK = scratchBuffer(2);
+        double *damping = scratchBuffer(3);
+        double *impulseAmount = scratchBuffer(4);
+
+        // Scale controlOut (0-1) to mass (0.0-10.0), springK (0.0001-1.0),
+        // damping (0.5-0.9999) and impulseAmount (0-1000) ranges
+        evaluatePort(plan, InputPort::TargetValue, 0.0,
+                     {0.0, 1.0, -kUnbounded, kUnbounded}, targetValue, nFrames);
+        evaluatePort(plan, InputPort::Mass, params.mass,
+                     {0.0, 10.0, 0.0, 10.0}, mass, nFrames);
+        evaluatePort(plan, InputPort::SpringK, params.springK,
+                     {0.0001, 0.9999, 0.0001, 1.0}, springK, nFrames);
+        evaluatePort(plan, InputPort::Damping, params.damping,
+                     {0.5, 0.4999, 0.5, 0.9999}, damping, nFrames);
+        evaluatePort(plan, InputPort::ImpulseAmount, params.impulseAmount,
+                     {0.0, 1000.0, 0.0, 1000.0}, impulseAmount, nFrames);
+
+        // Impulse trigger reads the specific source port
+        const double *impulse = signalInput(plan, InputPort::Impulse);
+
+        double *out = buffer(plan.controlOut);
+        forEachSpan(plan.modulationRate, nFrames, [&](int start, int end) {
+            physicsSys.setMass(mass[start]);
+            physicsSys.setSpringK(springK[start]);
+            physicsSys.setDamping(damping[start]);
+            physicsSys.setImpulseAmount(impulseAmount[start]);
+
+            if (!impulse) {
+                physicsSys.processBlock(targetValue + start, out + start, end - start);
+                return;
             }
 
-            // Update drift parameters
-            proc.driftEng->setAmount(amount);
-            proc.driftEng->setRate(rate);
-
-            // Update drift pattern
-            int patternValue = static_cast<int>(container->getParameter("driftPattern", 2.0));
-            proc.driftEng->setDriftPattern(static_cast<DriftEngine::DriftPattern>(patternValue));
-
-            // Generate drift value (detuning multiplier around 1.0)
-            proc.controlOut = proc.driftEng->generateSample();
-        }
-
-    } else if (container->getName() == "Gate Processor") {
-        if (proc.gateProc) {
-            // Update gate parameters (in case they changed)
-            proc.gateProc->setVelocity(container->getParameter("velocity", 1.0));
-            proc.gateProc->setAttackTime(container->getParameter("attackTime", 0.01));
-            proc.gateProc->setReleaseTime(container->getParameter("releaseTime", 0.1));
-            proc.gateProc->setAttackCurve(static_cast<int>(container->getParameter("attackCurve", 0.0)));
-            proc.gateProc->setReleaseCurve(static_cast<int>(container->getParameter("releaseCurve", 0.0)));
-            proc.gateProc->setVelocitySens(container->getParameter("velocitySens", 0.5));
-
-            // Process gate state machine
-            proc.gateProc->processSample();
-
-            // Store all outputs
-            proc.gateEnvelopeOut = proc.gateProc->getEnvelopeOut();
-            proc.gateStateOut = static_cast<double>(proc.gateProc->getStateOut());
-            proc.gateAttackTrigger = proc.gateProc->getAttackTrigger() ? 1.0 : 0.0;
-            proc.gateReleaseTrigger = proc.gateProc->getReleaseTrigger() ? 1.0 : 0.0;
-
-            // Default controlOut to envelopeOut for backward compatibility
-            proc.controlOut = proc.gateEnvelopeOut;
-        }
-
-    } else if (container->getName() == "Easing Applicator") {
-        if (proc.easingApp) {
-            // Initialize input values with defaults
-            double startValue = 0.0;
-            double endValue = 1.0;
-            double progress = 0.5;
-
-            // Find connections to input ports
-            Canvas *canvas = qobject_cast<Canvas*>(container->parentWidget());
-            if (canvas) {
-                const QVector<Canvas::Connection>& connections = canvas->getConnections();
-                for (const Canvas::Connection &conn : connections) {
-                    if (conn.toContainer == container) {
-                        if (conn.toPort == "startValue") {
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                startValue = applyConnectionFunction(startValue, sourceValue,
-                                                                   conn.function, conn.weight);
-                            }
-                        } else if (conn.toPort == "endValue") {
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                endValue = applyConnectionFunction(endValue, sourceValue,
-                                                                 conn.function, conn.weight);
-                            }
-                        } else if (conn.toPort == "progress") {
-                            if (processors.contains(conn.fromContainer)) {
-                                double sourceValue = processors[conn.fromContainer].controlOut;
-                                progress = applyConnectionFunction(progress, sourceValue,
-                                                                 conn.function, conn.weight);
-                                progress = qBound(0.0, progress, 1.0);
-                            }
-                        }
-                    }
+            for (int i = start; i < end; i++) {
+                // Handle impulse trigger (rising edge detection)
+                // Trigger when impulse crosses threshold (0.5) from below
+                if (state.prevImpulse < 0.5 && impulse[i] >= 0.5) {
+                    physicsSys.applyImpulse(impulseAmount[i]);
                 }
+                state.prevImpulse = impulse[i];
+
+                out[i] = physicsSys.processSample(targetValue[i]);
             }
+        });
+        break;
+    }
 
-            // Update easing parameters (in case they changed)
-            proc.easingApp->setEasingSelect(static_cast<int>(container->getParameter("easingSelect", 0.0)));
+    case NodeType::EnvelopeEngine: {
+        EnvelopeEngine &envelopeEng = std::get<EnvelopeEngine>(state.processor);
+
+        // Scale control output (0.0-1.0) to timeScale 0.1-5.0,
+        // valueScale 0.0-2.0 and valueOffset -1.0 to 1.0
+        double *timeScale = scratchBuffer(0);
+        double *valueScale = scratchBuffer(1);
+        double *valueOffset = scratchBuffer(2);
+        evaluatePort(plan, InputPort::TimeScale, params.timeScale,
+                     {0.1, 4.9, 0.1, 5.0}, timeScale, nFrames);
+        evaluatePort(plan, InputPort::ValueScale, params.valueScale,
+                     {0.0, 2.0, 0.0, 2.0}, valueScale, nFrames);
+        evaluatePort(plan, InputPort::ValueOffset, params.valueOffset,
+                     {-1.0, 2.0, -1.0, 1.0}, valueOffset, nFrames);
+
+        // Evaluate the envelope at note progress (0.0 to 1.0) on each control tick
+        double *out = buffer(plan.controlOut);
+        forEachSpan(Rate::Control, nFrames, [&](int start, int end) {
+            if (isControlTick(start)) {
+                envelopeEng.setTimeScale(timeScale[start]);
+                envelopeEng.setValueScale(valueScale[start]);
+                envelopeEng.setValueOffset(valueOffset[start]);
+                startRamp(state.controlRamp, envelopeEng.process(progress[start]));
+            }
+            fillRamp(state.controlRamp, out, start, end);
+        });
+        break;
+    }
 
-            // Process easing
-            proc.controlOut = proc.easingApp->process(startValue, endValue, progress);
-        }
+    case NodeType::DriftEngine: {
+        DriftEngine &driftEng = std::get<DriftEngine>(state.processor);
+
+        // Scale controlOut (0-1) to amount range (0.0-0.1) and rate range (0.01-10.0)
+        double *amount = scratchBuffer(0);
+        double *rate = scratchBuffer(1);
+        evaluatePort(plan, InputPort::Amount, params.amount,
+                     {0.0, 0.1, 0.0, 0.1}, amount, nFrames);
+        evaluatePort(plan, InputPort::Rate, params.rate,
+                     {0.01, 9.99, 0.01, 10.0}, rate, nFrames);
+
+        // Generate drift values (detuning multiplier around 1.0) on each control tick
+        double *out = buffer(plan.controlOut);
+        forEachSpan(Rate::Control, nFrames, [&](int start, int end) {
+            if (isControlTick(start)) {
+                driftEng.setAmount(amount[start]);
+                driftEng.setRate(rate[start]);
+                startRamp(state.controlRamp, driftEng.generateSample());
+            }
+            fillRamp(state.controlRamp, out, start, end);
+        });
+        break;
     }
-}
 
-double SounitGraph::getInputValue(Container *container, const QString &portName, double defaultValue)
-{
-    // For future: traverse connections to get input values
-    // For now, just return default
-    return container->getParameter(portName, defaultValue);
-}
+    case NodeType::GateProcessor: {
+        GateProcessor &gateProc = std::get<GateProcessor>(state.processor);
+        double *envelopeOut = buffer(plan.gateEnvelopeOut);
+        double *stateOut = buffer(plan.gateStateOut);
+        double *attackTrigger = buffer(plan.gateAttackTrigger);
+        double *releaseTrigger = buffer(plan.gateReleaseTrigger);
+
+        // Step the gate state machine on each control tick. The envelope ramps,
+        // the state holds and the triggers fire for one sample at the tick
+        std::fill(attackTrigger, attackTrigger + nFrames, 0.0);
+        std::fill(releaseTrigger, releaseTrigger + nFrames, 0.0);
+        forEachSpan(Rate::Control, nFrames, [&](int start, int end) {
+            if (isControlTick(start)) {
+                gateProc.processSample();
+                startRamp(state.controlRamp, gateProc.getEnvelopeOut());
+                state.gateStateHeld = static_cast<double>(gateProc.getStateOut());
+                attackTrigger[start] = gateProc.getAttackTrigger() ? 1.0 : 0.0;
+                releaseTrigger[start] = gateProc.getReleaseTrigger() ? 1.0 : 0.0;
+            }
+            fillRamp(state.controlRamp, envelopeOut, start, end);
+            std::fill(stateOut + start, stateOut + end, state.gateStateHeld);
+        });
 
-double SounitGraph::getOutputValue(const ProcessorData &proc, const QString &portName) const
-{
-    // Gate Processor has multiple named outputs
-    if (portName == "envelopeOut") {
-        return proc.gateEnvelopeOut;
-    } else if (portName == "stateOut") {
-        return proc.gateStateOut;
-    } else if (portName == "attackTrigger") {
-        return proc.gateAttackTrigger;
-    } else if (portName == "releaseTrigger") {
-        return proc.gateReleaseTrigger;
+        // Default controlOut to envelopeOut for backward compatibility
+        std::copy(envelopeOut, envelopeOut + nFrames, buffer(plan.controlOut));
+        break;
     }
 
-    // Default: check if it's a signal or control output
-    if (portName == "signalOut" || portName.contains("signal", Qt::CaseInsensitive)) {
-        return proc.signalOut;
+    case NodeType::EasingApplicator: {
+        EasingApplicator &easingApp = std::get<EasingApplicator>(state.processor);
+        double *startValue = scratchBuffer(0);
+        double *endValue = scratchBuffer(1);
+        double *easingProgress = scratchBuffer(2);
+        evaluatePort(plan, InputPort::StartValue, 0.0,
+                     {0.0, 1.0, -kUnbounded, kUnbounded}, startValue, nFrames);
+        evaluatePort(plan, InputPort::EndValue, 1.0,
+                     {0.0, 1.0, -kUnbounded, kUnbounded}, endValue, nFrames);
+        evaluatePort(plan, InputPort::Progress, 0.5,
+                     {0.0, 1.0, 0.0, 1.0}, easingProgress, nFrames);
+
+        // Process easing on each control tick
+        double *out = buffer(plan.controlOut);
+        forEachSpan(Rate::Control, nFrames, [&](int start, int end) {
+            if (isControlTick(start)) {
+                startRamp(state.controlRamp, easingApp.process(startValue[start], endValue[start],
+                                                               easingProgress[start]));
+            }
+            fillRamp(state.controlRamp, out, start, end);
+        });
+        break;
     }
 
-    // Default to controlOut for any other named output
-    return proc.controlOut;
+    case NodeType::Unknown:
+        break;
+    }
 }
-
@@ -1,8 +1,7 @@
 #ifndef SOUNITGRAPH_H
 #define SOUNITGRAPH_H
 
-#include "container.h"
-#include "canvas.h"
+#include "sounitdescription.h"
 #include "harmonicgenerator.h"
 #include "spectrumtosignal.h"
 #include "rolloffprocessor.h"
@@ -17,91 +16,428 @@
 #include "spectrum.h"
 #include <QMap>
 #include <QVector>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <variant>
+#include <vector>
 
 /**
  * SounitGraph - Executes a graph of connected containers
  *
- * Manages processor instances for each container and executes them
- * in topological order to generate audio.
+ * build() compiles a SounitDescription (from the canvas or a .sounit
+ * file; no widgets involved) into a flat execution plan:
+ * a contiguous array of nodes in topological order, each with an enum
+ * node type and its input connections pre-resolved to (source node index,
+ * port id, connection function, weight). generateSample() only walks that
+ * array - no container names, port strings or connection lists are
+ * touched per sample. Node parameters are copied into a per-node
+ * snapshot at build time and refreshed by updateParameters(), so the
+ * render path never reads the description.
+ *
+ * processBlock() runs the plan a block at a time: each node processes up
+ * to kMaxBlockFrames frames before the next node runs, reading its inputs
+ * from the per-port block buffers of upstream nodes. Spectrum outputs are
+ * stored as one row for the whole block when nothing modulates them, one
+ * row per control segment, or one row per frame when an audio-rate source
+ * changes them per sample.
+ *
+ * Every node declares the rate it runs at. Audio-rate nodes produce a
+ * value per sample. Control-rate nodes (envelopes, drift, easing, gate)
+ * only compute a new value every controlInterval samples ("ticks") and
+ * ramp linearly towards it in between. Parameters and spectra that are
+ * modulated only by control-rate sources are refreshed once per control
+ * segment instead of per sample, which keeps filter coefficient and
+ * spectrum recomputation out of the per-sample loop.
+ *
+ * The compiled graph is split into an immutable Program (execution plan,
+ * parameter snapshot and fully configured initial processor state, e.g.
+ * DNA tables and custom envelopes) shared by every voice, and the small
+ * per-voice state: processor instances, control ramps and one buffer
+ * arena. createVoice() shares the program and copies the initial state;
+ * updateParameters() publishes a new program rather than editing the
+ * shared one, so voices already rendering keep a consistent snapshot;
+ * the engine creates fresh voices to play the change.
+ *
+ * A voice is not thread-safe. To render on several threads, give each
+ * thread its own createVoice().
  */
 class SounitGraph
 {
 public:
     SounitGraph(double sampleRate = 44100.0);
 
-    // Build the graph from canvas containers and connections
-    void buildFromCanvas(Canvas *canvas);
+    // Build the graph from a description's nodes and connections. Reads
+    // nothing but the description, so a graph no renderer has seen yet can
+    // be built on any thread
+    void build(const SounitDescription &description);
+
+    // Create a new voice of this graph: it shares the compiled program and
+    // only owns its processor state and block buffers, ready to play from
+    // reset(). Must not overlap updateParameters() on this graph (the
+    // engine holds graphMutex for both); the voice can then render on
+    // another thread.
+    std::unique_ptr<SounitGraph> createVoice() const;
 
     // Generate a single audio sample
     // pitch = fundamental frequency in Hz
     // noteProgress = 0.0 to 1.0, represents position within note duration
     double generateSample(double pitch, double noteProgress = 0.5);
 
-    // Reset all processors (call when starting new note)
-    void reset();
+    // Generate a block of audio samples
+    // pitch, progress = per-frame fundamental (Hz) and note progress (0.0 to 1.0)
+    // Blocks longer than kMaxBlockFrames are processed in chunks
+    void processBlock(float *out, int nFrames, const double *pitch, const double *progress);
+
+    // Largest number of frames each node processes in one pass
+    static constexpr int kMaxBlockFrames = 128;
+
+    // How control-rate outputs move between ticks
+    enum class ControlSmoothing {
+        Step,    // Jump to the new value at each tick
+        Linear   // Ramp to the new value over one control interval
+    };
+
+    // Control-rate settings (take effect on the next build)
+    // interval is rounded down to a power of two in 1..kMaxBlockFrames
+    void setControlInterval(int samples);
+    int getControlInterval() const { return controlInterval; }
+    void setControlSmoothing(ControlSmoothing smoothing) { controlSmoothing = smoothing; }
+    ControlSmoothing getControlSmoothing() const { return controlSmoothing; }
+
+    // Oversampling of the Spectrum to Signal stage, 1 (off), 2 or 4, for
+    // quality renders (takes effect on the next build)
+    void setOversampling(int factor) { oversampling = (factor >= 4) ? 4 : (factor >= 2) ? 2 : 1; }
+    int getOversampling() const { return oversampling; }
+
+    // Return every processor to its initial state (call when starting new note).
+    // Random sources (noise, random drift) are seeded from noteSeed and each
+    // node's instance name, so the same note renders bit for bit the same on
+    // any voice or thread
+    void reset(uint64_t noteSeed = 0);
+
+    // Seed for a note: its track and content, which is stable across sessions
+    // (unlike the note's id, which is regenerated on load)
+    static uint64_t noteSeed(int trackIndex, uint64_t noteContentHash);
+
+    // Refresh the parameter snapshot of the node with node.id (e.g. on
+    // Container::parameterChanged; see createVoice() for locking). Voices
+    // created afterwards use it, as does this graph from its next reset().
+    // Returns false if the node isn't in the graph.
+    bool updateParameters(const SounitDescription::Node &node);
 
     // Check if graph is valid and can produce audio
-    bool isValid() const { return hasValidSignalOutput; }
+    bool isValid() const { return program->hasValidSignalOutput; }
 
 private:
-    struct ProcessorData {
-        Container *container = nullptr;
-
-        // Processor instances (only one will be used per container)
-        // Using raw pointers for QMap compatibility
-        HarmonicGenerator *harmonicGen = nullptr;
-        RolloffProcessor *rolloffProc = nullptr;
-        SpectrumToSignal *spectrumToSig = nullptr;
-        FormantBody *formantBody = nullptr;
-        BreathTurbulence *breathTurb = nullptr;
-        NoiseColorFilter *noiseFilter = nullptr;
-        PhysicsSystem *physicsSys = nullptr;
-        EnvelopeEngine *envelopeEng = nullptr;
-        DriftEngine *driftEng = nullptr;
-        GateProcessor *gateProc = nullptr;
-        EasingApplicator *easingApp = nullptr;
-
-        // Data storage for this container's outputs
-        Spectrum spectrumOut;
-        double signalOut = 0.0;
-        double controlOut = 0.0;
+    // Container types known to the graph compiler
+    enum class NodeType {
+        HarmonicGenerator,
+        RolloffProcessor,
+        SpectrumToSignal,
+        FormantBody,
+        BreathTurbulence,
+        NoiseColorFilter,
+        PhysicsSystem,
+        EnvelopeEngine,
+        DriftEngine,
+        GateProcessor,
+        EasingApplicator,
+        Unknown
+    };
+
+    // Input ports across all container types
+    enum class InputPort {
+        SpectrumIn, SignalIn, VoiceIn, NoiseIn, AudioIn,
+        Purity, Drift, Rolloff, Pitch,
+        F1Freq, F2Freq, F1Q, F2Q, DirectMix, F1F2Balance,
+        Blend, Color, FilterQ,
+        TargetValue, Mass, SpringK, Damping, Impulse, ImpulseAmount,
+        TimeScale, ValueScale, ValueOffset,
+        Amount, Rate,
+        StartValue, EndValue, Progress,
+        Unknown
+    };
+
+    // Which output of the source node a connection reads
+    enum class OutputPort {
+        Spectrum,
+        Signal,
+        Control,
+        GateEnvelope,
+        GateState,
+        GateAttackTrigger,
+        GateReleaseTrigger
+    };
+
+    // How often a value changes, ordered from slowest to fastest:
+    // Block = constant over the block, Control = once per control segment,
+    // Audio = every sample
+    enum class Rate {
+        Block,
+        Control,
+        Audio
+    };
+
+    // Interpolates a control-rate output between ticks
+    struct ControlRamp {
+        double value = 0.0;
+        double increment = 0.0;
+        int remaining = 0;     // Samples left until value reaches the target
+        double target = 0.0;
+        bool primed = false;   // False until the first tick after reset
+    };
+
+    // Connection functions (see SounitDescription::Connection::function)
+    enum class ConnectionFunction {
+        Passthrough,
+        Add,
+        Multiply,
+        Subtract,
+        Replace,
+        Modulate
+    };
+
+    // One incoming connection, resolved at build time
+    struct InputSlot {
+        InputPort port = InputPort::Unknown;
+        int sourceNode = -1;  // Index into nodes
+        OutputPort sourcePort = OutputPort::Control;
+        ConnectionFunction function = ConnectionFunction::Passthrough;
+        double weight = 1.0;
+    };
+
+    // Node parameters, copied out of the description so the render path
+    // never reads it. Only the fields for the node's type are used.
+    struct NodeParams {
+        // Harmonic Generator
+        int dnaSelect = 0;
+        int numHarmonics = 64;
+        std::vector<double> customDna;  // Empty = no custom pattern stored
+
+        // Harmonic Generator / Rolloff Processor
+        double rolloff = 0.6;
+
+        // Spectrum to Signal
+        double normalize = 1.0;
+
+        // Formant Body
+        double f1Freq = 500.0;
+        double f2Freq = 1500.0;
+        double f1Q = 8.0;
+        double f2Q = 10.0;
+        double directMix = 0.3;
+        double f1f2Balance = 0.6;
+
+        // Breath Turbulence
+        double blend = 0.10;
+
+        // Noise Color Filter
+        double color = 2000.0;
+        double filterQ = 1.0;
+        int noiseType = 0;
+
+        // Physics System
+        double mass = 0.5;
+        double springK = 0.001;
+        double damping = 0.995;
+        double impulseAmount = 100.0;
+
+        // Envelope Engine
+        int envelopeSelect = 0;
+        QVector<EnvelopePoint> customEnvelope;  // Empty = no custom envelope stored
+        double timeScale = 1.0;
+        double valueScale = 1.0;
+        double valueOffset = 0.0;
+        double envAttack = 0.1;
+        double envDecay = 0.2;
+        double envSustain = 0.7;
+        double envRelease = 0.2;
+        double envFadeTime = 0.5;
+
+        // Drift Engine
+        double amount = 0.005;
+        double rate = 0.5;
+        int driftPattern = 2;
+
+        // Gate Processor
+        double velocity = 1.0;
+        double attackTime = 0.01;
+        double releaseTime = 0.1;
+        int attackCurve = 0;
+        int releaseCurve = 0;
+        double velocitySens = 0.5;
+
+        // Easing Applicator
+        int easingSelect = 0;
+    };
+
+    // One node of the execution plan, shared by every voice
+    struct NodePlan {
+        NodeType type = NodeType::Unknown;
+        uint64_t nodeId = 0;    // SounitDescription::Node::id
+        QString typeName;       // For log messages
+        QString instanceName;
+        uint64_t seedKey = 0;   // Hash of instanceName, for per-node random streams
+        std::vector<InputSlot> inputs;   // In canvas connection order
+
+        NodeParams params;
+
+        Rate rate = Rate::Audio;            // Rate the node itself runs at
+        Rate modulationRate = Rate::Block;  // Fastest source modulating its parameters
+
+        // Spectrum output: one row per block, per control segment or per frame,
+        // starting at spectrumRow in the voice's spectra (-1 = no spectrum output)
+        Rate spectrumRate = Rate::Block;
+        int spectrumRow = -1;
+
+        // Offsets of the block buffers for this node's outputs in the voice's
+        // buffer arena (kMaxBlockFrames each, -1 for outputs the type doesn't produce)
+        int signalOut = -1;
+        int controlOut = -1;
 
         // Gate Processor specific outputs
-        double gateEnvelopeOut = 0.0;
-        double gateStateOut = 0.0;
-        double gateAttackTrigger = 0.0;
-        double gateReleaseTrigger = 0.0;
+        int gateEnvelopeOut = -1;
+        int gateStateOut = -1;
+        int gateAttackTrigger = -1;
+        int gateReleaseTrigger = -1;
+    };
+
+    // Processor instance, stored inline (only the one matching the node type)
+    using Processor = std::variant<std::monostate, HarmonicGenerator, RolloffProcessor,
+                                   SpectrumToSignal, FormantBody, BreathTurbulence,
+                                   NoiseColorFilter, PhysicsSystem, EnvelopeEngine,
+                                   DriftEngine, GateProcessor, EasingApplicator>;
+
+    // Per-voice state of one node
+    struct NodeState {
+        Processor processor;
+
+        // Control-rate output interpolation (controlOut / Gate envelopeOut)
+        ControlRamp controlRamp;
+        double gateStateHeld = 0.0;
 
         // State tracking for Physics System impulse trigger
         double prevImpulse = 0.0;
+    };
 
-        // Destructor to clean up processors
-        ~ProcessorData() {
-            delete harmonicGen;
-            delete rolloffProc;
-            delete spectrumToSig;
-            delete formantBody;
-            delete breathTurb;
-            delete noiseFilter;
-            delete physicsSys;
-            delete envelopeEng;
-            delete driftEng;
-            delete gateProc;
-            delete easingApp;
-        }
+    // Compiled graph shared between voices. Never modified once published.
+    struct Program {
+        double sampleRate = 44100.0;
+        int controlInterval = 32;
+        int oversampling = 1;
+
+        std::vector<NodePlan> nodes;  // Execution plan, in topological order
+        int outputNode = -1;          // Index of the node producing the final signal
+        bool hasValidSignalOutput = false;
+
+        // Processors configured from the parameter snapshot, copied into each
+        // voice on reset() (indexed like nodes)
+        std::vector<NodeState> initialState;
+
+        int bufferSize = 0;    // Doubles in a voice's buffer arena
+        int spectrumRows = 0;  // Spectrum rows in a voice
+        Spectrum silentSpectrum;  // Fed to unconnected spectrum inputs
     };
 
     double sampleRate;
-    QMap<Container*, ProcessorData> processors;
-    QVector<Container*> executionOrder;  // Topological order
-    Container *signalOutputContainer = nullptr;  // Final output
-    bool hasValidSignalOutput = false;
-
-    void computeExecutionOrder(Canvas *canvas);
-    void createProcessors();
-    void executeContainer(ProcessorData &proc, double pitch, double noteProgress);
-    double getInputValue(Container *container, const QString &portName, double defaultValue);
-    double getOutputValue(const ProcessorData &proc, const QString &portName) const;
+    std::shared_ptr<const Program> program;
+
+    // Voice state
+    std::vector<NodeState> states;  // Indexed like program->nodes
+
+    // Buffer arena: the silent buffer (fed to unconnected signal inputs),
+    // the scratch buffers, then every node output buffer
+    static constexpr int kScratchBuffers = 8;
+    static constexpr int kSilentOffset = 0;
+    static constexpr int kScratchOffset = kMaxBlockFrames;
+    static constexpr int kNodeBufferOffset = kScratchOffset + kScratchBuffers * kMaxBlockFrames;
+    std::vector<double> buffers;
+    std::vector<Spectrum> spectra;
+
+    double *buffer(int offset) { return buffers.data() + offset; }
+    const double *buffer(int offset) const { return buffers.data() + offset; }
+
+    // Scratch buffers for per-frame parameter values while a node runs
+    double *scratchBuffer(int index) { return buffer(kScratchOffset + index * kMaxBlockFrames); }
+
+    // Control clock
+    int controlInterval = 32;  // Setting for the next build; the program holds the active one
+    ControlSmoothing controlSmoothing = ControlSmoothing::Linear;
+    uint64_t controlClock = 0;  // Samples processed since reset()
+
+    int oversampling = 1;  // Setting for the next build
+
+    // Control segments of the current block: segment s covers frames
+    // [segmentStart[s], segmentStart[s + 1]); a new segment begins at
+    // frame 0 and at every control tick
+    int segmentCount = 0;
+    std::array<int, kMaxBlockFrames + 1> segmentStart = {};
+    std::array<int, kMaxBlockFrames> segmentOfFrame = {};
+
+    // Control-to-parameter mapping for a modulatable input port:
+    // a source value v becomes offset + v * scale, results clamp to [minValue, maxValue]
+    struct PortRange {
+        double offset;
+        double scale;
+        double minValue;
+        double maxValue;
+    };
+
+    static bool compileNodes(const SounitDescription &description, Program &compiled);
+    static void allocateBuffers(Program &compiled, NodePlan &plan);
+    static void createProcessor(const Program &compiled, const NodePlan &plan, NodeState &state);
+    static void readParameters(NodePlan &plan, const SounitDescription::Node &node);
+    static void applyParameters(const NodePlan &plan, NodeState &state);
+    static const NodePlan *spectrumInput(const Program &compiled, const NodePlan &plan);
+    void instantiate();
+    void processNodes(const double *pitch, const double *progress, int nFrames);
+    void executeNode(const NodePlan &plan, NodeState &state,
+                     const double *pitch, const double *progress, int nFrames);
+
+    const double *sourceBuffer(const InputSlot &slot) const;
+    const double *signalInput(const NodePlan &plan, InputPort port) const;
+    const Spectrum &spectrumAt(const NodePlan *source, int frame) const;
+    static bool hasInput(const NodePlan &plan, InputPort port);
+    bool evaluatePort(const NodePlan &plan, InputPort port, double staticValue,
+                      const PortRange &range, double *values, int nFrames) const;
+
+    bool isControlTick(int frame) const { return (controlClock + frame) % program->controlInterval == 0; }
+    void startRamp(ControlRamp &ramp, double target) const;
+    static void fillRamp(ControlRamp &ramp, double *out, int start, int end);
+
+    static Rate nodeRate(NodeType type);
+    static bool isModulationPort(InputPort port);
+
+    // Calls fn(start, end) for each run of frames over which a value
+    // at the given rate holds still
+    template <typename Fn>
+    void forEachSpan(Rate rate, int nFrames, Fn fn) const
+    {
+        switch (rate) {
+        case Rate::Block:
+            fn(0, nFrames);
+            break;
+        case Rate::Control:
+            for (int s = 0; s < segmentCount; s++) {
+                fn(segmentStart[s], segmentStart[s + 1]);
+            }
+            break;
+        case Rate::Audio:
+            for (int i = 0; i < nFrames; i++) {
+                fn(i, i + 1);
+            }
+            break;
+        }
+    }
+
+    static double applyConnectionFunction(double currentValue, double sourceValue,
+                                          ConnectionFunction function, double weight);
+
+    static NodeType nodeTypeFromName(const QString &name);
+    static InputPort inputPortFromName(const QString &name);
+    static OutputPort outputPortFromName(const QString &name);
+    static ConnectionFunction connectionFunctionFromName(const QString &name);
 };
 
 #endif // SOUNITGRAPH_H
@@ -4,13 +4,13 @@
 SpectrumToSignal::SpectrumToSignal(double sampleRate)
     : sampleRate(sampleRate)
     , normalize(1.0)
-    , phases(64, 0.0)
 {
 }
 
 void SpectrumToSignal::reset()
 {
-    std::fill(phases.begin(), phases.end(), 0.0);
+    oscillators.reset();
+    decimator.reset();
 }
 
 void SpectrumToSignal::setSampleRate(double rate)
@@ -18,43 +18,64 @@ void SpectrumToSignal::setSampleRate(double rate)
     sampleRate = rate;
 }
 
-double SpectrumToSignal::generateSample(const Spectrum &spectrum, double pitch)
+void SpectrumToSignal::setOversampling(int factor)
 {
-    int numHarmonics = spectrum.getNumHarmonics();
-
-    // Ensure we have enough phase accumulators
-    if (static_cast<int>(phases.size()) < numHarmonics) {
-        phases.resize(numHarmonics, 0.0);
+    factor = (factor >= 4) ? 4 : (factor >= 2) ? 2 : 1;
+    if (factor == decimator.getFactor()) {
+        return;
     }
+    decimator = Decimator(factor);
+    oversampledPitch.assign(factor > 1 ? kOversampledChunk * factor : 0, 0.0);
+    oversampledOutput.assign(factor > 1 ? kOversampledChunk * factor : 0, 0.0);
+}
 
-    double output = 0.0;
-    double totalAmplitude = 0.0;
+double SpectrumToSignal::generateSample(const Spectrum &spectrum, double pitch)
+{
+    double output;
+    generateBlock(spectrum, &pitch, &output, 1);
+    return output;
+}
+
+void SpectrumToSignal::generateBlock(const Spectrum &spectrum, const double *pitch,
+                                     double *output, int numFrames)
+{
+    int numHarmonics = spectrum.getNumHarmonics();
     const std::vector<double> &harmonics = spectrum.getHarmonics();
 
-    // Sum all harmonics
+    // Only positive amplitudes sound and count towards normalization
+    double totalAmplitude = 0.0;
     for (int h = 0; h < numHarmonics; h++) {
-        double amplitude = harmonics[h];
-        if (amplitude > 0.0) {
-            totalAmplitude += amplitude;
-
-            // Generate sine wave for this harmonic
-            output += amplitude * std::sin(phases[h]);
-
-            // Advance phase
-            int harmonicNum = h + 1;  // h=0 is fundamental, h=1 is 2nd harmonic
-            phases[h] += 2.0 * M_PI * pitch * harmonicNum / sampleRate;
-
-            // Wrap phase to prevent overflow
-            if (phases[h] > 2.0 * M_PI * 1000.0) {
-                phases[h] -= 2.0 * M_PI * 1000.0;
-            }
+        if (harmonics[h] > 0.0) {
+            totalAmplitude += harmonics[h];
         }
     }
 
-    // Apply normalization to prevent clipping
+    // Normalization to prevent clipping is folded into the oscillator amplitudes
+    double gain = 1.0;
     if (normalize > 0.0 && totalAmplitude > 0.0) {
-        output /= (totalAmplitude * (1.0 - normalize) + normalize);
+        gain = 1.0 / (totalAmplitude * (1.0 - normalize) + normalize);
     }
 
-    return output;
+    // Sum all harmonics (h=0 is fundamental, h=1 is 2nd harmonic)
+    oscillators.setNumOscillators(numHarmonics);
+    oscillators.setAmplitudes(harmonics.data(), numHarmonics, gain);
+
+    int factor = decimator.getFactor();
+    if (factor == 1) {
+        oscillators.render(pitch, 1, sampleRate, output, numFrames);
+        return;
+    }
+
+    // Oversampled: hold each frame's pitch for factor samples, render at
+    // the higher rate, then filter and decimate back down. Partials above
+    // the output Nyquist would only be filtered out, so they're culled too
+    for (int offset = 0; offset < numFrames; offset += kOversampledChunk) {
+        int chunkFrames = std::min(kOversampledChunk, numFrames - offset);
+        for (int i = 0; i < chunkFrames; i++) {
+            std::fill_n(oversampledPitch.data() + i * factor, factor, pitch[offset + i]);
+        }
+        oscillators.render(oversampledPitch.data(), 1, sampleRate * factor,
+                           oversampledOutput.data(), chunkFrames * factor, 0.5 * sampleRate);
+        decimator.process(oversampledOutput.data(), output + offset, chunkFrames);
+    }
 }
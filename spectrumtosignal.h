@@ -2,14 +2,24 @@
 #define SPECTRUMTOSIGNAL_H
 
 #include "spectrum.h"
+#include "oscillatorbank.h"
+#include "decimator.h"
 #include <vector>
-#include <cmath>
 
 /**
  * SpectrumToSignal - Converts spectrum to audio signal
  *
  * Essential container - must have one to produce sound.
- * Sums oscillators for each harmonic to create audio output.
+ * Sums oscillators for each harmonic to create audio output
+ * (see OscillatorBank). Harmonics at or above Nyquist are skipped.
+ *
+ * With oversampling (2x or 4x) the harmonics are rendered at that
+ * multiple of the sample rate and brought back down by a polyphase
+ * Decimator. Partials then fade out smoothly through the filter's
+ * transition band below Nyquist instead of switching off at Nyquist as
+ * the pitch moves, and sidebands from audio-rate spectrum changes are
+ * filtered rather than aliased, at the cost of factor x the oscillator
+ * work and a delay of Decimator::getLatency() samples.
  */
 class SpectrumToSignal
 {
@@ -19,18 +29,30 @@ public:
     // Generate a single audio sample from spectrum
     double generateSample(const Spectrum &spectrum, double pitch);
 
+    // Generate a block of samples from a spectrum held constant over the block
+    // pitch = per-frame fundamental frequency in Hz
+    void generateBlock(const Spectrum &spectrum, const double *pitch, double *output, int numFrames);
+
     // Reset phase accumulators (call when starting new note)
     void reset();
 
     // Parameter setters
     void setSampleRate(double rate);
     void setNormalize(double normalize) { this->normalize = normalize; }
+    void setOversampling(int factor);  // 1 (off), 2 or 4
+    int getOversampling() const { return decimator.getFactor(); }
 
 private:
     double sampleRate;
     double normalize;  // 0 = off, 1 = full auto-normalize
 
-    std::vector<double> phases;  // Phase accumulator per harmonic
+    OscillatorBank oscillators;  // One oscillator per harmonic
+
+    // Oversampled rendering
+    Decimator decimator;
+    std::vector<double> oversampledPitch;
+    std::vector<double> oversampledOutput;
+    static constexpr int kOversampledChunk = 64;  // Output frames rendered per pass
 };
 
 #endif // SPECTRUMTOSIGNAL_H
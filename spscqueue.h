@@ -0,0 +1,65 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * SpscQueue - Lock-free single-producer, single-consumer message queue
+ *
+ * Fixed capacity, allocated up front: push() and pop() never block or
+ * allocate, so either end can be the audio callback. T should be a small
+ * trivially copyable message (no heap-owning members, or the consumer
+ * would free memory on the audio thread).
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t minCapacity)
+        : writeIndex(0)
+        , readIndex(0)
+    {
+        size_t size = 1;
+        while (size < minCapacity) {
+            size <<= 1;
+        }
+        messages.resize(size);
+        mask = size - 1;
+    }
+
+    // Producer: false if the queue is full (the message is dropped)
+    bool push(const T &message)
+    {
+        size_t write = writeIndex.load(std::memory_order_relaxed);
+        if (write - readIndex.load(std::memory_order_acquire) == messages.size()) {
+            return false;
+        }
+        messages[write & mask] = message;
+        writeIndex.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false if there's nothing to read
+    bool pop(T &message)
+    {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        if (read == writeIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        message = messages[read & mask];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> messages;
+    size_t mask;
+
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> writeIndex;
+    alignas(64) std::atomic<size_t> readIndex;
+};
+
+#endif // SPSCQUEUE_H
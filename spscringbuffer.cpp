@@ -0,0 +1,59 @@
+#include "spscringbuffer.h"
+#include <algorithm>
+#include <cstring>
+
+SpscRingBuffer::SpscRingBuffer(size_t minCapacity)
+    : writeIndex(0)
+    , readIndex(0)
+{
+    size_t size = 1;
+    while (size < minCapacity) {
+        size <<= 1;
+    }
+    buffer.assign(size, 0.0f);
+    mask = size - 1;
+}
+
+size_t SpscRingBuffer::writeAvailable() const
+{
+    size_t used = writeIndex.load(std::memory_order_relaxed) - readIndex.load(std::memory_order_acquire);
+    return buffer.size() - used;
+}
+
+size_t SpscRingBuffer::write(const float *data, size_t count)
+{
+    size_t write = writeIndex.load(std::memory_order_relaxed);
+    size_t read = readIndex.load(std::memory_order_acquire);
+    count = std::min(count, buffer.size() - (write - read));
+
+    // Copy in up to two pieces (before and after the wrap)
+    size_t start = write & mask;
+    size_t first = std::min(count, buffer.size() - start);
+    std::memcpy(buffer.data() + start, data, first * sizeof(float));
+    std::memcpy(buffer.data(), data + first, (count - first) * sizeof(float));
+
+    // Publish the samples to the reader
+    writeIndex.store(write + count, std::memory_order_release);
+    return count;
+}
+
+size_t SpscRingBuffer::readAvailable() const
+{
+    return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_relaxed);
+}
+
+size_t SpscRingBuffer::read(float *out, size_t count)
+{
+    size_t read = readIndex.load(std::memory_order_relaxed);
+    size_t write = writeIndex.load(std::memory_order_acquire);
+    count = std::min(count, write - read);
+
+    size_t start = read & mask;
+    size_t first = std::min(count, buffer.size() - start);
+    std::memcpy(out, buffer.data() + start, first * sizeof(float));
+    std::memcpy(out + first, buffer.data(), (count - first) * sizeof(float));
+
+    // Hand the space back to the writer
+    readIndex.store(read + count, std::memory_order_release);
+    return count;
+}
@@ -0,0 +1,40 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * SpscRingBuffer - Lock-free single-producer, single-consumer sample FIFO
+ *
+ * One thread writes, one other thread reads; neither ever blocks or
+ * allocates, so the reader can be the audio callback. Read and write
+ * positions only ever grow and are masked into a power-of-two buffer,
+ * so full and empty need no extra flag.
+ */
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(size_t minCapacity);  // Rounded up to a power of two
+
+    size_t capacity() const { return buffer.size(); }
+
+    // Producer side
+    size_t writeAvailable() const;
+    size_t write(const float *data, size_t count);  // Returns samples written (may be short)
+
+    // Consumer side
+    size_t readAvailable() const;
+    size_t read(float *out, size_t count);  // Returns samples read (may be short)
+
+private:
+    std::vector<float> buffer;
+    size_t mask;
+
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> writeIndex;
+    alignas(64) std::atomic<size_t> readIndex;
+};
+
+#endif // SPSCRINGBUFFER_H
@@ -0,0 +1,49 @@
+#ifndef TRACKMIX_H
+#define TRACKMIX_H
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * TrackMix - Placement of one track's bus on the stereo master bus
+ *
+ * pan places the track (-1 = left, 0 = centre, 1 = right). width spreads
+ * its notes across the field by pitch: the bottom of the track's register
+ * sits width to the left of pan and the top width to the right, which
+ * gives a mono instrument a stereo image. Gains follow the constant-power
+ * pan law, scaled so a centred note plays at unity in both channels (the
+ * level of the old mono output).
+ */
+struct TrackMix {
+    double pan = 0.0;          // -1.0 to 1.0
+    double width = 0.0;        // 0.0 (point source) to 1.0
+    double gain = 1.0;
+    double minFreqHz = 27.5;   // Register the width spreads over
+    double maxFreqHz = 4186.0;
+
+    // Left/right gains for a note at pitchHz
+    void noteGains(double pitchHz, float &left, float &right) const
+    {
+        double position = pan;
+        if (width > 0.0 && maxFreqHz > minFreqHz && pitchHz > 0.0) {
+            double register01 = std::log(pitchHz / minFreqHz) / std::log(maxFreqHz / minFreqHz);
+            position += width * (2.0 * std::clamp(register01, 0.0, 1.0) - 1.0);
+        }
+        position = std::clamp(position, -1.0, 1.0);
+
+        const double quarterPi = 0.78539816339744831;
+        const double sqrt2 = 1.41421356237309505;
+        double angle = (position + 1.0) * quarterPi;
+        left = static_cast<float>(gain * sqrt2 * std::cos(angle));
+        right = static_cast<float>(gain * sqrt2 * std::sin(angle));
+    }
+
+    bool operator==(const TrackMix &other) const
+    {
+        return pan == other.pan && width == other.width && gain == other.gain
+               && minFreqHz == other.minFreqHz && maxFreqHz == other.maxFreqHz;
+    }
+    bool operator!=(const TrackMix &other) const { return !(*this == other); }
+};
+
+#endif // TRACKMIX_H
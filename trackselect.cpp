@@ -1,6 +1,7 @@
 #include "trackselect.h"
 #include <QPainter>
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include <QPen>
 #include <QBrush>
 #include <cmath>
@@ -28,6 +29,8 @@ void TrackSelector::addTrack(const QString &name, const QColor &color,
     track.maxFreqHz = maxHz;
     track.isActive = false;
     track.trackIndex = tracks.size();
+    track.pan = 0.0;
+    track.width = 0.0;
 
     tracks.append(track);
 
@@ -122,6 +125,30 @@ void TrackSelector::updateTrack(int index, const QString &name, const QColor &co
     }
 }
 
+void TrackSelector::setTrackPan(int index, double pan)
+{
+    if (index >= 0 && index < tracks.size()) {
+        pan = qBound(-1.0, pan, 1.0);
+        if (tracks[index].pan != pan) {
+            tracks[index].pan = pan;
+            update();
+            emit trackMixChanged(index);
+        }
+    }
+}
+
+void TrackSelector::setTrackWidth(int index, double width)
+{
+    if (index >= 0 && index < tracks.size()) {
+        width = qBound(0.0, width, 1.0);
+        if (tracks[index].width != width) {
+            tracks[index].width = width;
+            update();
+            emit trackMixChanged(index);
+        }
+    }
+}
+
 void TrackSelector::setFrequencyRange(double minHz, double maxHz)
 {
     visibleMinHz = minHz;
@@ -216,6 +243,19 @@ void TrackSelector::paintEvent(QPaintEvent *event)
 
             painter.restore();
         }
+
+        // Pan position as a tick along the bottom of the bar, widened by the width
+        if (track.pan != 0.0 || track.width != 0.0) {
+            int centerX = trackRect.center().x();
+            int halfBar = trackRect.width() / 2 - 3;
+            int panX = centerX + static_cast<int>(track.pan * halfBar);
+            int spread = static_cast<int>(track.width * halfBar);
+            int y = trackRect.bottom() - 4;
+            painter.setPen(QPen(Qt::white, 2));
+            painter.drawLine(qMax(trackRect.left() + 3, panX - spread), y,
+                             qMin(trackRect.right() - 3, panX + spread), y);
+            painter.drawLine(panX, y - 3, panX, y + 3);
+        }
     }
 }
 
@@ -229,6 +269,29 @@ void TrackSelector::mousePressEvent(QMouseEvent *event)
     QWidget::mousePressEvent(event);
 }
 
+void TrackSelector::wheelEvent(QWheelEvent *event)
+{
+    int index = trackIndexAtPosition(event->position().toPoint());
+    if (index < 0 || !(event->modifiers() & Qt::ControlModifier)) {
+        QWidget::wheelEvent(event);  // Let the scroll area scroll
+        return;
+    }
+
+    // One notch is 120 units of angle delta. Some platforms (macOS) turn
+    // Shift+wheel into horizontal scrolling, so fall back to the x delta
+    int delta = event->angleDelta().y();
+    if (delta == 0) {
+        delta = event->angleDelta().x();
+    }
+    double step = (delta / 120.0) * MIX_WHEEL_STEP;
+    if (event->modifiers() & Qt::ShiftModifier) {
+        setTrackWidth(index, tracks[index].width + step);
+    } else {
+        setTrackPan(index, tracks[index].pan + step);
+    }
+    event->accept();
+}
+
 void TrackSelector::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
@@ -19,6 +19,8 @@ public:
         bool isActive;         // The track that receives new notes
         bool isSelected;       // Track is visible (notes shown)
         int trackIndex;
+        double pan;            // Stereo position, -1.0 (left) to 1.0 (right)
+        double width;          // Stereo spread of the register, 0.0 to 1.0
     };
 
     explicit TrackSelector(QWidget *parent = nullptr);
@@ -33,6 +35,8 @@ public:
     bool isTrackSelected(int index) const;
     void clearTracks();
     void updateTrack(int index, const QString &name, const QColor &color);
+    void setTrackPan(int index, double pan);      // Clamped to -1.0..1.0
+    void setTrackWidth(int index, double width);  // Clamped to 0.0..1.0
     const QVector<Track>& getTracks() const { return tracks; }
 
     // Synchronization with score canvas
@@ -46,10 +50,12 @@ public:
 signals:
     void trackClicked(int trackIndex);
     void trackSelected(int trackIndex);
+    void trackMixChanged(int trackIndex);  // Pan or width changed
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;  // Ctrl+wheel = pan, Ctrl+Shift+wheel = width
     void resizeEvent(QResizeEvent *event) override;
 
 private:
@@ -70,6 +76,7 @@ private:
     static constexpr int ACTIVE_OPACITY = 255;       // 100%
     static constexpr double BASE_FREQUENCY = 25.0;   // Hz - base frequency for just intonation
     static constexpr int PIXELS_PER_OCTAVE = 100;    // Fixed vertical size for each octave
+    static constexpr double MIX_WHEEL_STEP = 0.05;   // Pan/width change per wheel notch
 
     // Helper methods
     int frequencyToPixel(double hz) const;
@@ -0,0 +1,71 @@
+#include "voiceallocator.h"
+#include <algorithm>
+
+VoiceAllocator::VoiceAllocator(int maxVoices, StealPolicy policy)
+    : stealPolicy(policy)
+{
+    setMaxVoices(maxVoices);
+}
+
+void VoiceAllocator::setMaxVoices(int count)
+{
+    voices.assign(std::max(count, 1), Voice());
+}
+
+int VoiceAllocator::allocate(int owner, uint64_t startSample, uint64_t endSample, double level, int &stolenOwner)
+{
+    stolenOwner = -1;
+
+    // Free voices whose notes have ended, and take the first free one
+    int chosen = -1;
+    for (int v = 0; v < static_cast<int>(voices.size()); v++) {
+        if (voices[v].active && voices[v].endSample <= startSample) {
+            voices[v].active = false;
+        }
+        if (!voices[v].active && chosen < 0) {
+            chosen = v;
+        }
+    }
+
+    // All voices busy: steal one per policy
+    if (chosen < 0) {
+        if (stealPolicy == StealPolicy::None) {
+            return -1;
+        }
+
+        chosen = 0;
+        for (int v = 1; v < static_cast<int>(voices.size()); v++) {
+            const Voice &candidate = voices[v];
+            const Voice &best = voices[chosen];
+            bool better = (stealPolicy == StealPolicy::Quietest)
+                          ? candidate.level < best.level
+                          : candidate.startSample < best.startSample;
+            if (better) {
+                chosen = v;
+            }
+        }
+        stolenOwner = voices[chosen].owner;
+    }
+
+    Voice &voice = voices[chosen];
+    voice.active = true;
+    voice.owner = owner;
+    voice.startSample = startSample;
+    voice.endSample = endSample;
+    voice.level = level;
+    return chosen;
+}
+
+void VoiceAllocator::release(int voice)
+{
+    if (voice >= 0 && voice < static_cast<int>(voices.size())) {
+        voices[voice].active = false;
+    }
+}
+
+void VoiceAllocator::releaseAll()
+{
+    for (Voice &voice : voices) {
+        voice.active = false;
+    }
+}
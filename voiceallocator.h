@@ -0,0 +1,56 @@
+#ifndef VOICEALLOCATOR_H
+#define VOICEALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * VoiceAllocator - Assigns notes to a fixed number of voices on one track
+ *
+ * Each track plays up to maxVoices notes at once. A note that starts while
+ * every voice is busy either steals one (per the steal policy) or is
+ * dropped. Times are in samples; a voice frees itself once the time passes
+ * its note's end. Owners are caller-defined ids (e.g. note indices).
+ */
+class VoiceAllocator
+{
+public:
+    // Which busy voice a new note takes over
+    enum class StealPolicy {
+        Oldest,     // The voice that started earliest
+        Quietest,   // The voice with the lowest level (e.g. note dynamics)
+        None        // Never steal: the new note is dropped
+    };
+
+    VoiceAllocator(int maxVoices = 16, StealPolicy policy = StealPolicy::Oldest);
+
+    void setMaxVoices(int count);  // Clamped to at least 1; releases all voices
+    int getMaxVoices() const { return static_cast<int>(voices.size()); }
+    void setStealPolicy(StealPolicy policy) { stealPolicy = policy; }
+    StealPolicy getStealPolicy() const { return stealPolicy; }
+
+    // Start a voice for owner at startSample. Voices whose notes ended by
+    // startSample are freed first. Returns the voice index, or -1 if the note
+    // is dropped. stolenOwner is set to the owner that lost its voice (-1 if none).
+    int allocate(int owner, uint64_t startSample, uint64_t endSample, double level, int &stolenOwner);
+
+    // Free one voice early (note off)
+    void release(int voice);
+
+    // Free every voice
+    void releaseAll();
+
+private:
+    struct Voice {
+        bool active = false;
+        int owner = -1;
+        uint64_t startSample = 0;
+        uint64_t endSample = 0;
+        double level = 0.0;
+    };
+
+    std::vector<Voice> voices;
+    StealPolicy stealPolicy;
+};
+
+#endif // VOICEALLOCATOR_H
@@ -0,0 +1,173 @@
+#include "wavwriter.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+void put16(std::vector<uint8_t> &out, uint16_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void putTag(std::vector<uint8_t> &out, const char *tag)
+{
+    out.insert(out.end(), tag, tag + 4);
+}
+
+}
+
+WavWriter::WavWriter()
+    : format(Format::Pcm24)
+    , sampleRate(44100)
+    , channels(2)
+    , framesWritten(0)
+{
+}
+
+WavWriter::~WavWriter()
+{
+    if (file.isOpen()) {
+        close();
+    }
+}
+
+bool WavWriter::open(const QString &path, int sampleRate, int channels, Format format)
+{
+    if (file.isOpen()) {
+        close();
+    }
+
+    this->format = format;
+    this->sampleRate = sampleRate;
+    this->channels = std::max(channels, 1);
+    framesWritten = 0;
+    errorString.clear();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail("Could not open " + path + " for writing: " + file.errorString());
+    }
+
+    // Sizes are filled in by close()
+    return writeHeader();
+}
+
+bool WavWriter::writeHeader()
+{
+    bool isFloat = (format == Format::Float32);
+    int bytesPerSample = isFloat ? 4 : 3;
+    uint64_t dataBytes = framesWritten * channels * bytesPerSample;
+
+    std::vector<uint8_t> header;
+    putTag(header, "RIFF");
+    put32(header, 0);  // RIFF size, patched below
+    putTag(header, "WAVE");
+
+    // Non-PCM formats carry a cbSize field and a fact chunk
+    putTag(header, "fmt ");
+    put32(header, isFloat ? 18 : 16);
+    put16(header, isFloat ? 3 : 1);  // WAVE_FORMAT_IEEE_FLOAT / WAVE_FORMAT_PCM
+    put16(header, static_cast<uint16_t>(channels));
+    put32(header, static_cast<uint32_t>(sampleRate));
+    put32(header, static_cast<uint32_t>(sampleRate * channels * bytesPerSample));
+    put16(header, static_cast<uint16_t>(channels * bytesPerSample));
+    put16(header, static_cast<uint16_t>(bytesPerSample * 8));
+    if (isFloat) {
+        put16(header, 0);
+        putTag(header, "fact");
+        put32(header, 4);
+        put32(header, static_cast<uint32_t>(framesWritten));
+    }
+
+    putTag(header, "data");
+    put32(header, static_cast<uint32_t>(dataBytes));
+
+    uint32_t riffSize = static_cast<uint32_t>(header.size() - 8 + dataBytes);
+    for (int i = 0; i < 4; i++) {
+        header[4 + i] = static_cast<uint8_t>(riffSize >> (8 * i));
+    }
+
+    if (!file.seek(0) || file.write(reinterpret_cast<const char*>(header.data()), header.size())
+                             != static_cast<qint64>(header.size())) {
+        return fail("Could not write WAV header: " + file.errorString());
+    }
+    return true;
+}
+
+bool WavWriter::write(const float *interleaved, size_t frames)
+{
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    bool isFloat = (format == Format::Float32);
+    size_t bytesPerSample = isFloat ? 4 : 3;
+    size_t samples = frames * channels;
+    if ((framesWritten + frames) * channels * bytesPerSample > kMaxDataBytes) {
+        return fail("WAV file would exceed 4 GB");
+    }
+
+    chunk.resize(samples * bytesPerSample);
+    uint8_t *out = chunk.data();
+    if (isFloat) {
+        for (size_t i = 0; i < samples; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, &interleaved[i], sizeof(bits));
+            out[i * 4] = static_cast<uint8_t>(bits);
+            out[i * 4 + 1] = static_cast<uint8_t>(bits >> 8);
+            out[i * 4 + 2] = static_cast<uint8_t>(bits >> 16);
+            out[i * 4 + 3] = static_cast<uint8_t>(bits >> 24);
+        }
+    } else {
+        const double scale = 8388607.0;  // 2^23 - 1
+        for (size_t i = 0; i < samples; i++) {
+            double sample = std::clamp(static_cast<double>(interleaved[i]), -1.0, 1.0);
+            int32_t value = static_cast<int32_t>(std::lround(sample * scale));
+            out[i * 3] = static_cast<uint8_t>(value);
+            out[i * 3 + 1] = static_cast<uint8_t>(value >> 8);
+            out[i * 3 + 2] = static_cast<uint8_t>(value >> 16);
+        }
+    }
+
+    if (file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size()) != static_cast<qint64>(chunk.size())) {
+        return fail("Could not write audio: " + file.errorString());
+    }
+    framesWritten += frames;
+    return true;
+}
+
+bool WavWriter::close()
+{
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    bool ok = writeHeader();
+    file.close();
+    return ok;
+}
+
+void WavWriter::abort()
+{
+    if (file.isOpen()) {
+        file.close();
+    }
+    file.remove();
+}
+
+bool WavWriter::fail(const QString &message)
+{
+    errorString = message;
+    qDebug() << "WavWriter:" << message;
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <QFile>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * WavWriter - Streams interleaved float audio to a WAV file
+ *
+ * The header is written with placeholder sizes on open(), audio is
+ * converted and appended chunk by chunk as it arrives, and close() goes
+ * back to fill in the sizes, so a file of any length is written in
+ * constant memory. abort() closes and deletes a partial file.
+ *
+ * Pcm24 clips to [-1, 1] and rounds to 24-bit integers; Float32 stores
+ * the samples as they are (WAVE_FORMAT_IEEE_FLOAT). All fields are
+ * written little-endian regardless of the host.
+ */
+class WavWriter
+{
+public:
+    enum class Format {
+        Pcm24,    // 24-bit integer PCM
+        Float32   // 32-bit IEEE float
+    };
+
+    WavWriter();
+    ~WavWriter();  // Finalizes an open file
+
+    bool open(const QString &path, int sampleRate, int channels, Format format);
+    bool write(const float *interleaved, size_t frames);
+    bool close();   // Patch the header sizes and close
+    void abort();   // Close and delete the file
+
+    bool isOpen() const { return file.isOpen(); }
+    uint64_t getFramesWritten() const { return framesWritten; }
+    QString getErrorString() const { return errorString; }
+
+private:
+    bool writeHeader();
+    bool fail(const QString &message);
+
+    QFile file;
+    Format format;
+    int sampleRate;
+    int channels;
+    uint64_t framesWritten;
+    QString errorString;
+    std::vector<uint8_t> chunk;  // Converted audio awaiting write
+
+    static constexpr uint64_t kMaxDataBytes = 0xFFFFFFFFULL - 64;  // RIFF sizes are 32-bit
+};
+
+#endif // WAVWRITER_H